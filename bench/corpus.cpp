@@ -0,0 +1,170 @@
+#include "corpus.hpp"
+
+#include <cstdio>
+#include <random>
+
+namespace fte::bench {
+
+namespace {
+
+std::string var(std::uint32_t i) {
+    char buf[16];
+    std::snprintf(buf, sizeof buf, "x%u", i);
+    return buf;
+}
+
+std::string num(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.6g", v);
+    return buf;
+}
+
+/// Signed literal usable as an operand, e.g. `(-0.25)`.
+std::string coef(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, v < 0 ? "(%.6g)" : "%.6g", v);
+    return buf;
+}
+
+Case dense_polynomial(int degree) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    Case c{"polynomial_dense_d" + std::to_string(degree) + "_3v", "polynomial", 3, {}};
+    std::string s;
+    for (int i = 0; i <= degree; ++i)
+        for (int j = 0; i + j <= degree; ++j)
+            for (int k = 0; i + j + k <= degree; ++k) {
+                if (!s.empty())
+                    s += " + ";
+                s += coef(u(rng));
+                if (i) s += "*x0^" + std::to_string(i);
+                if (j) s += "*x1^" + std::to_string(j);
+                if (k) s += "*x2^" + std::to_string(k);
+            }
+    c.sources.push_back(std::move(s));
+    return c;
+}
+
+Case horner_polynomial(int degree) {
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    Case c{"polynomial_horner_d" + std::to_string(degree) + "_1v", "polynomial", 1, {}};
+    std::string s = num(u(rng));
+    for (int i = 0; i < degree; ++i)
+        s = "(" + s + ")*x0 + " + coef(u(rng));
+    c.sources.push_back(std::move(s));
+    return c;
+}
+
+Case composition(int depth) {
+    static const char* const wrap[][2] = {
+        {"sin(", ")"}, {"exp(-0.5*", ")"}, {"log(1.5 + ", ")"}, {"sqrt(1 + (", ")^2)"}, {"tanh(", ")"},
+    };
+    Case c{"composition_depth" + std::to_string(depth), "composition", 2, {}};
+    std::string s = "x0";
+    for (int k = 0; k < depth; ++k) {
+        const auto& w = wrap[k % 5];
+        s = std::string(w[0]) + s + (k % 2 ? "*x1 + x0" : " + x1") + w[1];
+    }
+    c.sources.push_back(std::move(s));
+    return c;
+}
+
+/// Fully connected tanh network with a linear scalar output; hidden units
+/// are written out in full, so the text repeats them and the parser's
+/// hash-consing shares them again.
+Case mlp(std::uint32_t inputs, std::vector<int> hidden) {
+    std::mt19937 rng(3);
+    std::normal_distribution<double> w(0.0, 0.5);
+    std::string name = "mlp_" + std::to_string(inputs);
+    std::vector<std::string> layer;
+    for (std::uint32_t i = 0; i < inputs; ++i)
+        layer.push_back(var(i));
+    for (int width : hidden) {
+        name += 'x';
+        name += std::to_string(width);
+        std::vector<std::string> next;
+        for (int j = 0; j < width; ++j) {
+            std::string s = "tanh(" + num(w(rng));
+            for (const std::string& a : layer)
+                s += " + " + coef(w(rng)) + "*" + a;
+            next.push_back(s + ")");
+        }
+        layer = std::move(next);
+    }
+    std::string out = num(w(rng));
+    for (const std::string& a : layer)
+        out += " + " + coef(w(rng)) + "*" + a;
+    Case c{name + "x1", "neural", inputs, {std::move(out)}, -1.0, 1.0};
+    return c;
+}
+
+/// Robertson's chemical kinetics, the classic stiff system.
+Case robertson() {
+    return {"ode_robertson", "stiff_ode", 3,
+            {"-0.04*x0 + 1e4*x1*x2", "0.04*x0 - 1e4*x1*x2 - 3e7*x1^2", "3e7*x1^2"},
+            0.0, 1.0};
+}
+
+/// Brusselator reaction-diffusion on a 1-D grid of `cells` (u, v) pairs
+/// with periodic boundaries; stiff for the large diffusion coefficient.
+Case brusselator(std::uint32_t cells) {
+    Case c{"ode_brusselator_" + std::to_string(cells), "stiff_ode", 2 * cells, {}, 0.5, 3.0};
+    const std::string a = "1", b = "3", alpha = num(0.02 * cells * cells);
+    auto u = [&](std::uint32_t i) { return var(2 * (i % cells)); };
+    auto v = [&](std::uint32_t i) { return var(2 * (i % cells) + 1); };
+    for (std::uint32_t i = 0; i < cells; ++i) {
+        const std::uint32_t l = i + cells - 1, r = i + 1;
+        c.sources.push_back(a + " + " + u(i) + "^2*" + v(i) + " - (" + b + " + 1)*" + u(i) + " + " +
+                            alpha + "*(" + u(l) + " - 2*" + u(i) + " + " + u(r) + ")");
+        c.sources.push_back(b + "*" + u(i) + " - " + u(i) + "^2*" + v(i) + " + " + alpha + "*(" + v(l) +
+                            " - 2*" + v(i) + " + " + v(r) + ")");
+    }
+    return c;
+}
+
+/// Extended Rosenbrock function: every term couples two neighbours.
+Case rosenbrock(std::uint32_t n) {
+    Case c{"sparse_rosenbrock_" + std::to_string(n), "sparse", n, {}, -1.0, 1.0};
+    std::string s;
+    for (std::uint32_t i = 0; i + 1 < n; ++i) {
+        if (!s.empty())
+            s += " + ";
+        s += "100*(" + var(i + 1) + " - " + var(i) + "^2)^2 + (1 - " + var(i) + ")^2";
+    }
+    c.sources.push_back(std::move(s));
+    return c;
+}
+
+/// Banded objective with transcendental couplings at distance 1 and `band`.
+Case banded(std::uint32_t n, std::uint32_t band) {
+    Case c{"sparse_banded_" + std::to_string(n), "sparse", n, {}};
+    std::string s;
+    for (std::uint32_t i = 0; i < n; ++i) {
+        if (!s.empty())
+            s += " + ";
+        s += "sin(" + var(i) + "*" + var((i + band) % n) + ") + exp(-" + var(i) + "*" +
+             var((i + 1) % n) + ") + " + var(i) + "^2/(1 + " + var((i + 1) % n) + "^2)";
+    }
+    c.sources.push_back(std::move(s));
+    return c;
+}
+
+}  // namespace
+
+std::vector<Case> standard_corpus() {
+    std::vector<Case> corpus;
+    corpus.push_back(dense_polynomial(12));
+    corpus.push_back(horner_polynomial(64));
+    corpus.push_back(composition(64));
+    corpus.push_back(composition(256));
+    corpus.push_back(mlp(8, {16, 16}));
+    corpus.push_back(mlp(16, {32, 32, 16}));
+    corpus.push_back(robertson());
+    corpus.push_back(brusselator(64));
+    corpus.push_back(rosenbrock(256));
+    corpus.push_back(banded(256, 7));
+    return corpus;
+}
+
+}  // namespace fte::bench
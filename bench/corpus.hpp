@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fte::bench {
+
+/// One benchmark problem: formulas over the variables `x0 .. x{n-1}`.
+struct Case {
+    std::string name;
+    std::string family;
+    std::uint32_t num_vars = 0;
+    std::vector<std::string> sources;  // one per output
+    /// Inputs are drawn uniformly from `[lo, hi]`.
+    double lo = 0.1;
+    double hi = 0.9;
+};
+
+/// The standard corpus: polynomials, deep compositions, neural-network-like
+/// layers, stiff ODE right-hand sides and sparse objectives. Deterministic,
+/// so results are comparable across runs and machines.
+std::vector<Case> standard_corpus();
+
+}  // namespace fte::bench
@@ -0,0 +1,295 @@
+// Differentiation and evaluation benchmarks over the standard corpus.
+//
+// Usage: fte_bench [--filter=SUBSTR] [--reps=N] [--points=N] [--threads=N]
+//                  [--output=FILE]
+//
+// Writes one JSON document (to stdout unless --output is given) with a
+// record per case, so that runs can be archived and compared over time.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "corpus.hpp"
+#include "fte/batch.hpp"
+#include "fte/derivative.hpp"
+#include "fte/parallel.hpp"
+#include "fte/parser.hpp"
+#include "fte/program.hpp"
+#include "fte/thread_pool.hpp"
+
+#ifndef FTE_VERSION
+#define FTE_VERSION "unknown"
+#endif
+#ifdef __VERSION__
+#define FTE_BENCH_COMPILER __VERSION__
+#else
+#define FTE_BENCH_COMPILER "unknown"
+#endif
+
+namespace {
+
+using namespace fte;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string filter;
+    std::string output;
+    int reps = 7;
+    std::size_t points = 1 << 16;
+    unsigned threads = 0;
+};
+
+/// Median and minimum of repeated measurements.
+struct Sample {
+    double median = 0.0;
+    double min = 0.0;
+};
+
+/// Time `run` `reps` times, or take the duration it returns if it times
+/// only part of its own work.
+template <class F>
+Sample measure(int reps, F&& run) {
+    std::vector<double> t;
+    for (int r = 0; r < reps; ++r) {
+        const auto t0 = Clock::now();
+        if constexpr (std::is_void_v<decltype(run())>) {
+            run();
+            t.push_back(std::chrono::duration<double>(Clock::now() - t0).count());
+        } else {
+            t.push_back(std::chrono::duration<double>(run()).count());
+        }
+    }
+    std::sort(t.begin(), t.end());
+    return {t[t.size() / 2], t.front()};
+}
+
+/// Restart the kernel's resident-set high-water mark for this process.
+/// Returns false where that is not supported, in which case the reported
+/// peak covers the whole run so far.
+bool reset_peak_rss() {
+#if defined(__GLIBC__)
+    // Hand memory freed by earlier cases back first; the allocator would
+    // otherwise keep it resident and count it again.
+    malloc_trim(0);
+#endif
+    std::ofstream f("/proc/self/clear_refs");
+    return f && (f << "5").flush();
+}
+
+long peak_rss_kb() {
+    std::ifstream f("/proc/self/status");
+    std::string line;
+    while (std::getline(f, line))
+        if (line.rfind("VmHWM:", 0) == 0)
+            return std::strtol(line.c_str() + 6, nullptr, 10);
+    return -1;
+}
+
+/// Roots and their first partials: the full gradient of a scalar objective,
+/// the nonzero Jacobian entries of a system.
+struct Derived {
+    std::vector<const Node*> roots;
+    std::vector<const Node*> partials;
+};
+
+std::vector<const Node*> parse_case(const bench::Case& c, ExprPool& pool, SymbolTable& symbols) {
+    char name[16];
+    for (std::uint32_t i = 0; i < c.num_vars; ++i)
+        symbols.intern(std::string_view(name, std::snprintf(name, sizeof name, "x%u", i)));
+    std::vector<const Node*> roots;
+    for (const std::string& s : c.sources)
+        roots.push_back(parse(s, pool, symbols));
+    return roots;
+}
+
+/// Scalar objectives use reverse accumulation, systems one forward
+/// `Differentiator` whose memo is shared by all outputs.
+Derived differentiate_case(ExprPool& pool, std::vector<const Node*> roots, std::uint32_t n) {
+    Derived d{std::move(roots), {}};
+    if (d.roots.size() == 1) {
+        d.partials = adjoint_gradient(pool, d.roots[0], n);
+    } else {
+        // Only the structurally nonzero Jacobian entries are kept.
+        Differentiator diff(pool);
+        for (const Node* r : d.roots)
+            for (std::uint32_t v = 0; v < n; ++v)
+                if (const Node* p = diff(r, v); !p->is_const(0.0))
+                    d.partials.push_back(p);
+    }
+    return d;
+}
+
+std::string json_string(std::string_view s) {
+    std::string out = "\"";
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\')
+            out += '\\';
+        out += ch;
+    }
+    return out + "\"";
+}
+
+std::string json_sample(const Sample& s, double scale) {
+    char buf[96];
+    std::snprintf(buf, sizeof buf, "{\"median\": %.6g, \"min\": %.6g}", s.median * scale, s.min * scale);
+    return buf;
+}
+
+std::string run_case(const bench::Case& c, const Options& opt, ThreadPool& threads) {
+    const bool per_case_peak = reset_peak_rss();
+    std::size_t source_bytes = 0;
+    for (const std::string& s : c.sources)
+        source_bytes += s.size();
+
+    const Sample parse_t = measure(opt.reps, [&] {
+        ExprPool pool;
+        SymbolTable symbols;
+        parse_case(c, pool, symbols);
+    });
+    const Sample diff_t = measure(opt.reps, [&] {
+        ExprPool pool;
+        SymbolTable symbols;
+        auto roots = parse_case(c, pool, symbols);
+        const auto t0 = Clock::now();
+        differentiate_case(pool, std::move(roots), c.num_vars);
+        return Clock::now() - t0;
+    });
+
+    ExprPool pool;
+    SymbolTable symbols;
+    const Derived d = differentiate_case(pool, parse_case(c, pool, symbols), c.num_vars);
+    std::vector<const Node*> all = d.roots;
+    all.insert(all.end(), d.partials.begin(), d.partials.end());
+    const Program program = linearize(all, c.num_vars);
+
+    // Single-point latency of values and all partials together.
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> u(c.lo, c.hi);
+    std::vector<double> x(c.num_vars), out(program.num_outputs()), slots(program.num_slots());
+    for (double& v : x)
+        v = u(rng);
+    constexpr int kCalls = 256;
+    const Sample latency = measure(opt.reps, [&] {
+        for (int k = 0; k < kCalls; ++k)
+            program.eval(x, out, slots);
+    });
+
+    // Batch throughput, single-threaded and on the pool, over at most
+    // `kBatchBytes` of columns.
+    constexpr std::size_t kBatchBytes = std::size_t(256) << 20;
+    const std::size_t columns = c.num_vars + program.num_outputs();
+    const std::size_t n = std::max<std::size_t>(
+        1, std::min(opt.points, kBatchBytes / (columns * sizeof(double))));
+    std::vector<std::vector<double>> in_cols(c.num_vars, std::vector<double>(n));
+    for (auto& col : in_cols)
+        for (double& v : col)
+            v = u(rng);
+    std::vector<std::vector<double>> out_cols(program.num_outputs(), std::vector<double>(n));
+    std::vector<const double*> in_ptrs;
+    std::vector<double*> out_ptrs;
+    for (const auto& col : in_cols)
+        in_ptrs.push_back(col.data());
+    for (auto& col : out_cols)
+        out_ptrs.push_back(col.data());
+    BatchEvaluator batch(program);
+    const Sample serial = measure(opt.reps, [&] { batch(in_ptrs, out_ptrs, n); });
+    const Sample parallel =
+        measure(opt.reps, [&] { evaluate_batch_parallel(threads, program, in_ptrs, out_ptrs, n); });
+
+    std::string j = "    {\"name\": " + json_string(c.name) + ", \"family\": " + json_string(c.family);
+    char buf[512];
+    std::snprintf(buf, sizeof buf,
+                  ", \"variables\": %u, \"outputs\": %zu, \"program_outputs\": %zu,\n"
+                  "     \"source_bytes\": %zu, \"batch_points\": %zu,\n"
+                  "     \"expression_nodes\": %zu, \"derivative_nodes\": %zu, \"total_nodes\": %zu,\n"
+                  "     \"program_instructions\": %zu, \"program_slots\": %u, \"diff_mode\": \"%s\",\n",
+                  c.num_vars, d.roots.size(), program.num_outputs(), source_bytes, n, dag_size(d.roots), dag_size(d.partials),
+                  dag_size(all), program.code().size(), program.num_slots(),
+                  d.roots.size() == 1 ? "reverse" : "forward");
+    j += buf;
+    j += "     \"parse_us\": " + json_sample(parse_t, 1e6) + ",\n";
+    j += "     \"diff_us\": " + json_sample(diff_t, 1e6) + ",\n";
+    j += "     \"latency_ns\": " + json_sample(latency, 1e9 / kCalls) + ",\n";
+    // Rates from the fastest and median times, in points per second.
+    std::snprintf(buf, sizeof buf,
+                  "     \"batch_points_per_s\": {\"median\": %.6g, \"max\": %.6g},\n"
+                  "     \"parallel_points_per_s\": {\"median\": %.6g, \"max\": %.6g},\n"
+                  "     \"peak_rss_kb\": %ld, \"peak_rss_scope\": \"%s\"}",
+                  n / serial.median, n / serial.min, n / parallel.median, n / parallel.min,
+                  peak_rss_kb(), per_case_peak ? "case" : "process");
+    j += buf;
+    return j;
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view a = argv[i];
+        auto value = [&](std::string_view key) -> const char* {
+            return a.substr(0, key.size()) == key ? argv[i] + key.size() : nullptr;
+        };
+        if (const char* v = value("--filter="))
+            opt.filter = v;
+        else if (const char* v = value("--output="))
+            opt.output = v;
+        else if (const char* v = value("--reps="))
+            opt.reps = std::max(1, std::atoi(v));
+        else if (const char* v = value("--points="))
+            opt.points = std::max<std::size_t>(1, std::strtoull(v, nullptr, 10));
+        else if (const char* v = value("--threads="))
+            opt.threads = static_cast<unsigned>(std::atoi(v));
+        else
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        std::fprintf(stderr,
+                     "usage: %s [--filter=SUBSTR] [--reps=N] [--points=N] [--threads=N] "
+                     "[--output=FILE]\n",
+                     argv[0]);
+        return 2;
+    }
+    ThreadPool threads(opt.threads);
+
+    std::string doc = "{\"benchmark\": \"fte_bench\", \"version\": \"" FTE_VERSION "\",\n";
+    doc += " \"compiler\": " + json_string(FTE_BENCH_COMPILER) + ", \"threads\": " +
+           std::to_string(threads.size()) + ", \"reps\": " + std::to_string(opt.reps) +
+           ", \"points\": " + std::to_string(opt.points) + ",\n \"cases\": [\n";
+    bool first = true;
+    for (const bench::Case& c : bench::standard_corpus()) {
+        if (c.name.find(opt.filter) == std::string::npos)
+            continue;
+        std::fprintf(stderr, "%s\n", c.name.c_str());
+        doc += (first ? "" : ",\n") + run_case(c, opt, threads);
+        first = false;
+    }
+    doc += "\n ]}\n";
+
+    if (opt.output.empty()) {
+        std::fputs(doc.c_str(), stdout);
+    } else {
+        std::ofstream f(opt.output);
+        if (!(f << doc)) {
+            std::fprintf(stderr, "fte_bench: cannot write %s\n", opt.output.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
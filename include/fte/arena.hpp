@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fte {
+
+/// Bump-pointer allocator.
+///
+/// Objects are carved out of large blocks and are never freed individually;
+/// `reset()` rewinds the arena while keeping its blocks for reuse, so a
+/// long-lived arena stops touching the system allocator once warmed up.
+/// Only trivially destructible objects may be placed in an arena.
+class Arena {
+public:
+    explicit Arena(std::size_t block_size = 64 * 1024);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) noexcept = default;
+    Arena& operator=(Arena&&) noexcept = default;
+
+    void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t)) {
+        auto p = reinterpret_cast<std::uintptr_t>(ptr_);
+        auto aligned = (p + (align - 1)) & ~(static_cast<std::uintptr_t>(align) - 1);
+        if (aligned + size > reinterpret_cast<std::uintptr_t>(end_))
+            return allocate_slow(size, align);
+        ptr_ = reinterpret_cast<std::byte*>(aligned + size);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    template <class T, class... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena objects are never destroyed");
+        return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template <class T>
+    T* allocate_array(std::size_t n) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena objects are never destroyed");
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /// Forget every allocation but keep the blocks for reuse.
+    void reset() noexcept;
+
+    std::size_t bytes_used() const noexcept;
+    std::size_t bytes_reserved() const noexcept;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    void* allocate_slow(std::size_t size, std::size_t align);
+
+    std::vector<Block> blocks_;
+    std::size_t block_size_;
+    std::size_t current_ = 0;
+    std::size_t used_before_current_ = 0;
+    std::byte* ptr_ = nullptr;
+    std::byte* end_ = nullptr;
+};
+
+}  // namespace fte
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "fte/program.hpp"
+
+namespace fte {
+
+/// Evaluates a `Program` over many points in structure-of-arrays layout.
+///
+/// Points are processed in tiles: each instruction runs as one tight loop
+/// over the tile's lanes, which the compiler vectorizes, and the slot
+/// scratch is allocated once per evaluator rather than per point or call.
+/// An evaluator is not thread-safe; give each thread its own.
+///
+/// With `vector_math`, exponentials, logarithms, sines and cosines run on
+/// the vectorized routines of `fte/vmath.hpp`, within 1 ulp, and pairs a
+/// derivative typically holds are evaluated together: a sine and a cosine
+/// of one value as one `sincos`, and `x^p` next to `x^(p-1)` (constant
+/// `p >= 1`) as one `pow` and a product. Without it every instruction calls
+/// libm and results are bitwise those of `Program::eval`.
+class BatchEvaluator {
+public:
+    static constexpr std::size_t kDefaultTile = 256;
+
+    explicit BatchEvaluator(const Program& program, std::size_t tile = kDefaultTile,
+                            bool vector_math = true);
+
+    /// `inputs[i][p]` is input `i` at point `p`; `outputs[r][p]` receives
+    /// output `r`. Both must provide at least `n` values per column.
+    void operator()(std::span<const double* const> inputs, std::span<double* const> outputs,
+                    std::size_t n);
+
+    const Program& program() const noexcept { return program_; }
+    std::size_t tile() const noexcept { return tile_; }
+    /// Program instructions evaluated as the second half of a fused pair.
+    std::size_t num_fused() const noexcept { return num_fused_; }
+
+private:
+    enum class Kind : std::uint8_t {
+        Single,   ///< one instruction
+        SinCos,   ///< `dst = sin(a)`, `second = cos(a)`
+        PowPair,  ///< `dst = a^b`, `second = a^(b-1)`, `b` a constant
+        Copy,     ///< `dst = a`, a result parked by an earlier pair
+    };
+    struct Step {
+        Kind kind;
+        Op op;
+        std::uint32_t dst, a, b, second;
+    };
+
+    std::uint32_t plan(std::uint32_t base, std::span<const double> constants);
+    void run_tile(std::size_t len);
+
+    const Program& program_;
+    std::size_t tile_;
+    bool vector_math_;
+    std::vector<Step> steps_;
+    std::size_t num_fused_ = 0;
+    std::unique_ptr<double[]> scratch_;  // [slot][lane], 64-byte aligned rows
+    std::vector<double*> slot_ptr_;      // temporaries, constants, spare rows
+    std::vector<const double*> src_;     // operand base per slot for the tile
+};
+
+/// One-shot convenience wrapper around `BatchEvaluator`.
+void evaluate_batch(const Program& program, std::span<const double* const> inputs,
+                    std::span<double* const> outputs, std::size_t n);
+
+}  // namespace fte
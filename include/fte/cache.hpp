@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fte/expr.hpp"
+#include "fte/jit.hpp"
+#include "fte/program.hpp"
+
+namespace fte {
+
+/// Structural identity of an expression up to the order of commutative
+/// operands and the naming of its variables.
+struct CanonicalForm {
+    std::uint64_t hash = 0;
+    /// The canonical DAG itself, serialized: equal for two forms exactly when
+    /// they are the same expression, so a hash collision is detected.
+    std::vector<std::uint64_t> structure;
+    /// `variables[k]` is the variable of the original expression that became
+    /// canonical variable `k`, numbered by first occurrence.
+    std::vector<std::uint32_t> variables;
+};
+
+/// Canonical form of `f`. Commutative operands are ordered by a hash that
+/// treats every variable alike, and variables are then numbered in the order
+/// a traversal meets them, so `x*sin(y)` and `sin(a)*b` agree. Renamings are
+/// only found up to ties between operands of identical shape; a missed tie
+/// costs a cache miss, never a wrong result.
+CanonicalForm canonical_form(const Node* f);
+
+/// Symbolic gradient of one canonical expression, with its fused program and
+/// an optional native kernel. Variables are canonical; see `CachedGradient`.
+class GradientEntry {
+public:
+    GradientEntry(const Node* f, const CanonicalForm& form, const JitOptions& jit);
+
+    GradientEntry(const GradientEntry&) = delete;
+    GradientEntry& operator=(const GradientEntry&) = delete;
+
+    std::uint64_t key() const noexcept { return key_; }
+    std::span<const std::uint64_t> structure() const noexcept { return structure_; }
+    std::uint32_t num_variables() const noexcept { return program_.num_inputs(); }
+    const Node* function() const noexcept { return function_; }
+    /// d f / d (canonical variable k)
+    std::span<const Node* const> gradient() const noexcept { return gradient_; }
+    /// Outputs `[f, df/dv_0, ..., df/dv_{n-1}]` over canonical variables.
+    const Program& program() const noexcept { return program_; }
+    /// Native code for `program()`, compiled on first use. Thread-safe.
+    const CompiledKernel& kernel() const;
+    /// Approximate memory footprint, used for size-based eviction.
+    std::size_t bytes() const noexcept { return bytes_; }
+
+private:
+    std::uint64_t key_;
+    std::vector<std::uint64_t> structure_;
+    ExprPool pool_;
+    const Node* function_ = nullptr;
+    std::vector<const Node*> gradient_;
+    Program program_;
+    JitOptions jit_;
+    std::size_t bytes_ = 0;
+    mutable std::once_flag kernel_once_;
+    mutable CompiledKernel kernel_;
+};
+
+/// A cache result: the shared entry plus the mapping from the caller's
+/// variables to the entry's canonical ones. Holding it keeps the entry alive
+/// after eviction.
+struct CachedGradient {
+    std::shared_ptr<const GradientEntry> entry;
+    std::vector<std::uint32_t> variables;  ///< caller variable of canonical `k`
+    bool hit = false;
+
+    /// f(x) and the gradient `grad[v] = df/dx_v` in the caller's numbering;
+    /// `grad` entries of variables `f` does not use are left untouched.
+    double evaluate(std::span<const double> x, std::span<double> grad) const;
+
+    /// Caller names permuted into canonical order, for `to_string`.
+    std::vector<std::string> names(std::span<const std::string> caller_names) const;
+};
+
+struct DerivativeCacheOptions {
+    std::size_t max_entries = 4096;
+    std::size_t max_bytes = std::size_t{256} << 20;
+    JitOptions jit;
+};
+
+struct DerivativeCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+
+    double hit_rate() const noexcept {
+        const std::uint64_t n = hits + misses;
+        return n ? static_cast<double>(hits) / static_cast<double>(n) : 0.0;
+    }
+};
+
+/// Bounded, thread-safe cache of symbolic gradients keyed by
+/// `canonical_form`, so repeated formulas that differ only in term order or
+/// variable names share one entry.
+///
+/// Entries are evicted least recently used first once either the entry or
+/// the byte limit is exceeded. Misses build the entry outside the lock; if
+/// two threads race on the same key the first insertion wins. A hit also
+/// compares the canonical structure; on a hash collision the formula gets
+/// a fresh entry that is not cached.
+class DerivativeCache {
+public:
+    explicit DerivativeCache(DerivativeCacheOptions options = {});
+
+    CachedGradient gradient(const Node* f);
+
+    DerivativeCacheStats stats() const;
+    void clear();
+
+private:
+    using Lru = std::list<std::uint64_t>;
+    struct Slot {
+        std::shared_ptr<const GradientEntry> entry;
+        Lru::iterator position;
+    };
+
+    void evict_locked();
+
+    DerivativeCacheOptions options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::uint64_t, Slot> map_;
+    Lru lru_;  // most recently used first
+    DerivativeCacheStats stats_;
+};
+
+}  // namespace fte
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+
+#include "fte/tape.hpp"
+
+namespace fte {
+
+/// One iteration `next = step_i(state, params)`. Called with active `Real`s
+/// while a step is being recorded and with passive ones while advancing, so
+/// it must not keep values between calls.
+using StepFunction = std::function<void(std::size_t i, std::span<const Real> state,
+                                        std::span<const Real> params, std::span<Real> next)>;
+
+/// Scalar result computed from the final state.
+using ObjectiveFunction =
+    std::function<Real(std::span<const Real> state, std::span<const Real> params)>;
+
+struct CheckpointOptions {
+    /// Bytes available for stored states; determines the snapshot count.
+    std::size_t memory_budget = std::size_t{64} << 20;
+    /// Explicit snapshot count, overriding `memory_budget` when nonzero.
+    std::size_t max_snapshots = 0;
+};
+
+struct CheckpointStats {
+    std::size_t snapshots = 0;          ///< states that could be held at once
+    std::size_t advanced_steps = 0;     ///< passive (re)computations
+    std::size_t recorded_steps = 0;     ///< steps taped and swept backward
+    std::size_t peak_tape_entries = 0;  ///< largest single recording
+};
+
+/// Smallest number of forward (re)computations per step, `t`, such that
+/// `num_steps` can be reversed with `snapshots` stored states: the least `t`
+/// with `C(snapshots + t, t) >= num_steps` (Griewank's binomial bound).
+std::size_t binomial_repetitions(std::size_t num_steps, std::size_t snapshots);
+
+/// Gradient of `objective(x_N, p)` where `x_{i+1} = step(i, x_i, p)` and
+/// `x_0 = x0`, with respect to `x0` and `params`.
+///
+/// Only one step is ever on the tape. States are kept in at most
+/// `snapshots` stored copies placed by binomial (Revolve-style)
+/// checkpointing: the backward sweep restores the nearest snapshot and
+/// recomputes forward from it, so stored memory is bounded by the budget
+/// while each step is recomputed at most `binomial_repetitions` times. A
+/// budget of one state degenerates to quadratic recomputation; a budget of
+/// `num_steps` states to plain taping. Returns the objective value.
+double checkpointed_gradient(Tape& tape, const StepFunction& step,
+                             const ObjectiveFunction& objective, std::size_t num_steps,
+                             std::span<const double> x0, std::span<const double> params,
+                             std::span<double> grad_x0, std::span<double> grad_params,
+                             const CheckpointOptions& options = {},
+                             CheckpointStats* stats = nullptr);
+
+}  // namespace fte
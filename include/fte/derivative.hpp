@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "fte/expr.hpp"
+
+namespace fte {
+
+/// Symbolic differentiation over a hash-consed DAG.
+///
+/// Derivatives are memoized per (node, variable) for the lifetime of the
+/// differentiator, so the work for one variable is linear in the number of
+/// unique subterms, and the result shares every subterm it has in common with
+/// the input and with previously computed derivatives. A call only visits
+/// the subterms not memoized yet, so differentiating an edited formula costs
+/// time in the size of the edit rather than of the formula.
+class Differentiator {
+public:
+    /// Work done over the differentiator's lifetime, in (node, variable)
+    /// derivatives.
+    struct Stats {
+        std::size_t computed = 0;  ///< derived by a rule or as a leaf
+        std::size_t reused = 0;    ///< found in the memo where a walk stopped
+    };
+
+    explicit Differentiator(ExprPool& pool) : pool_(pool) {}
+
+    /// d f / d x_var
+    const Node* operator()(const Node* f, std::uint32_t var);
+
+    ExprPool& pool() noexcept { return pool_; }
+    const Stats& stats() const noexcept { return stats_; }
+
+    /// Forget all memoized derivatives.
+    void clear() noexcept { memo_.clear(); }
+
+private:
+    const Node* rule(const Node* n, const Node* da, const Node* db);
+
+    ExprPool& pool_;
+    std::vector<std::vector<const Node*>> memo_;  // [var][node id]
+    Stats stats_;
+    // Walk scratch, kept between calls.
+    std::vector<std::uint32_t> visit_;  // [node id] epoch of the last visit
+    std::uint32_t epoch_ = 0;
+    std::vector<const Node*> order_;
+    std::vector<std::pair<const Node*, int>> stack_;
+};
+
+/// d f / d x_var
+const Node* differentiate(ExprPool& pool, const Node* f, std::uint32_t var);
+
+/// All first partials of `f` with respect to `x_0 .. x_{num_vars-1}`.
+std::vector<const Node*> gradient(ExprPool& pool, const Node* f, std::uint32_t num_vars);
+
+/// The same partials built by symbolic reverse accumulation: adjoint
+/// expressions are propagated from `f` to the leaves in a single pass, so the
+/// cost is linear in the size of `f` however many variables there are.
+std::vector<const Node*> adjoint_gradient(ExprPool& pool, const Node* f, std::uint32_t num_vars);
+
+}  // namespace fte
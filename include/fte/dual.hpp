@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "fte/eval.hpp"
+#include "fte/expr.hpp"
+#include "fte/simd.hpp"
+
+namespace fte {
+
+/// Forward-mode dual number carrying `N` tangents at once.
+///
+/// The tangents are a `simd::Pack`, so every elementary operation updates all
+/// directions with a handful of vector instructions: `Dual<8>` fills one
+/// AVX-512 register (two AVX2 registers), `Dual<16>` two AVX-512 registers.
+template <std::size_t N>
+struct Dual {
+    using Tangent = simd::Pack<double, N>;
+
+    Tangent d;
+    double v;
+
+    Dual(double value = 0.0) noexcept : d(Tangent::zero()), v(value) {}  // NOLINT: implicit
+    Dual(double value, const Tangent& tangent) noexcept : d(tangent), v(value) {}
+
+    static constexpr std::size_t width = N;
+
+    Dual& operator+=(const Dual& o) noexcept { return *this = *this + o; }
+    Dual& operator-=(const Dual& o) noexcept { return *this = *this - o; }
+    Dual& operator*=(const Dual& o) noexcept { return *this = *this * o; }
+    Dual& operator/=(const Dual& o) noexcept { return *this = *this / o; }
+
+    friend Dual operator-(const Dual& a) noexcept { return {-a.v, -a.d}; }
+    friend Dual operator+(const Dual& a, const Dual& b) noexcept { return {a.v + b.v, a.d + b.d}; }
+    friend Dual operator-(const Dual& a, const Dual& b) noexcept { return {a.v - b.v, a.d - b.d}; }
+    friend Dual operator*(const Dual& a, const Dual& b) noexcept {
+        return {a.v * b.v, a.d * b.v + a.v * b.d};
+    }
+    friend Dual operator/(const Dual& a, const Dual& b) noexcept {
+        const double q = a.v / b.v;
+        return {q, (a.d - q * b.d) * (1.0 / b.v)};
+    }
+
+    friend Dual sqrt(const Dual& a) noexcept {
+        const double r = std::sqrt(a.v);
+        return {r, a.d * (0.5 / r)};
+    }
+    friend Dual exp(const Dual& a) noexcept {
+        const double e = std::exp(a.v);
+        return {e, a.d * e};
+    }
+    friend Dual log(const Dual& a) noexcept { return {std::log(a.v), a.d * (1.0 / a.v)}; }
+    friend Dual sin(const Dual& a) noexcept { return {std::sin(a.v), a.d * std::cos(a.v)}; }
+    friend Dual cos(const Dual& a) noexcept { return {std::cos(a.v), a.d * -std::sin(a.v)}; }
+    friend Dual tan(const Dual& a) noexcept {
+        const double t = std::tan(a.v);
+        return {t, a.d * (1.0 + t * t)};
+    }
+    friend Dual tanh(const Dual& a) noexcept {
+        const double t = std::tanh(a.v);
+        return {t, a.d * (1.0 - t * t)};
+    }
+    friend Dual pow(const Dual& a, const Dual& b) noexcept {
+        const double p = std::pow(a.v, b.v);
+        const double pa = b.v == 0.0 ? 0.0 : b.v * std::pow(a.v, b.v - 1.0);
+        const double pb = a.v > 0.0 ? p * std::log(a.v) : 0.0;
+        return {p, a.d * pa + b.d * pb};
+    }
+};
+
+/// Default batch of directions: one full register of doubles, at least 8.
+inline constexpr std::size_t kDualWidth =
+    simd::native_width<double> < 8 ? 8 : simd::native_width<double>;
+
+/// Directional derivatives of every root at `x` along `N` seed directions.
+///
+/// `seeds` is `N` rows of `x.size()` entries (row-major, one direction per
+/// row); `out` receives `roots.size()` rows of `N` entries, so
+/// `out[r*N + k] = grad(roots[r]) . seeds[k]`. Returns the primal values.
+template <std::size_t N>
+std::vector<double> directional_derivatives(std::span<const Node* const> roots,
+                                            std::span<const double> x,
+                                            std::span<const double> seeds,
+                                            std::span<double> out) {
+    const std::size_t n = x.size();
+    if (seeds.size() != N * n || out.size() != N * roots.size())
+        throw std::invalid_argument("directional_derivatives: span sizes do not match");
+
+    std::vector<Dual<N>> xs(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        xs[i].v = x[i];
+        for (std::size_t k = 0; k < N; ++k)
+            xs[i].d.set(k, seeds[k * n + i]);
+    }
+    const std::vector<Dual<N>> ys = evaluate<Dual<N>>(roots, std::span<const Dual<N>>(xs));
+
+    std::vector<double> primal(ys.size());
+    for (std::size_t r = 0; r < ys.size(); ++r) {
+        primal[r] = ys[r].v;
+        ys[r].d.store(&out[r * N]);
+    }
+    return primal;
+}
+
+/// Dense Jacobian of `roots` at `x` in row-major order (`roots.size()` rows,
+/// `x.size()` columns), computed `N` columns per forward pass.
+template <std::size_t N = kDualWidth>
+std::vector<double> jacobian(std::span<const Node* const> roots, std::span<const double> x) {
+    const std::size_t n = x.size();
+    const std::size_t m = roots.size();
+    std::vector<double> jac(m * n);
+    std::vector<double> seeds(N * n);
+    std::vector<double> block(N * m);
+    for (std::size_t col = 0; col < n; col += N) {
+        std::fill(seeds.begin(), seeds.end(), 0.0);
+        for (std::size_t k = 0; k < N && col + k < n; ++k)
+            seeds[k * n + col + k] = 1.0;
+        directional_derivatives<N>(roots, x, seeds, block);
+        for (std::size_t r = 0; r < m; ++r)
+            for (std::size_t k = 0; k < N && col + k < n; ++k)
+                jac[r * n + col + k] = block[r * N + k];
+    }
+    return jac;
+}
+
+}  // namespace fte
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "fte/expr.hpp"
+
+namespace fte {
+
+/// Apply a non-leaf operation to already evaluated operands.
+///
+/// Elementary functions are found by argument-dependent lookup, so any number
+/// type that provides `sin`, `exp`, `pow`, ... overloads in its own namespace
+/// can be pushed through the same evaluators as `double`.
+template <class T>
+T apply_op(Op op, const T& a, const T& b) {
+    using std::cos;
+    using std::exp;
+    using std::log;
+    using std::pow;
+    using std::sin;
+    using std::sqrt;
+    using std::tan;
+    using std::tanh;
+    switch (op) {
+        case Op::Neg: return -a;
+        case Op::Sqrt: return sqrt(a);
+        case Op::Exp: return exp(a);
+        case Op::Log: return log(a);
+        case Op::Sin: return sin(a);
+        case Op::Cos: return cos(a);
+        case Op::Tan: return tan(a);
+        case Op::Tanh: return tanh(a);
+        case Op::Add: return a + b;
+        case Op::Sub: return a - b;
+        case Op::Mul: return a * b;
+        case Op::Div: return a / b;
+        case Op::Pow: return pow(a, b);
+        case Op::Const:
+        case Op::Var: break;
+    }
+    throw std::invalid_argument("apply_op: leaf operation");
+}
+
+/// Evaluate every root at the point `x`, visiting each shared subterm once.
+///
+/// This is the reference tree-walking evaluator; hot paths should linearize
+/// the expression first.
+template <class T>
+std::vector<T> evaluate(std::span<const Node* const> roots, std::span<const T> x) {
+    const std::vector<const Node*> order = topo_order(roots);
+    std::uint32_t max_id = 0;
+    for (const Node* n : order)
+        max_id = n->id > max_id ? n->id : max_id;
+    std::vector<T> val(order.empty() ? 0 : max_id + 1);
+    for (const Node* n : order) {
+        switch (n->op) {
+            case Op::Const: val[n->id] = T(n->value); break;
+            case Op::Var:
+                if (n->var >= x.size())
+                    throw std::out_of_range("evaluate: variable index out of range");
+                val[n->id] = x[n->var];
+                break;
+            default:
+                val[n->id] = apply_op<T>(n->op, val[n->arg[0]->id],
+                                         n->arg[1] ? val[n->arg[1]->id] : T(0.0));
+                break;
+        }
+    }
+    std::vector<T> out;
+    out.reserve(roots.size());
+    for (const Node* r : roots)
+        out.push_back(val[r->id]);
+    return out;
+}
+
+inline double evaluate(const Node* root, std::span<const double> x) {
+    return evaluate<double>(std::span<const Node* const>(&root, 1), x)[0];
+}
+
+}  // namespace fte
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "fte/arena.hpp"
+
+namespace fte {
+
+/// Expression node kinds. Unary operations use `arg[0]` only.
+enum class Op : std::uint8_t {
+    Const,
+    Var,
+    // unary
+    Neg,
+    Sqrt,
+    Exp,
+    Log,
+    Sin,
+    Cos,
+    Tan,
+    Tanh,
+    // binary
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Pow,
+};
+
+inline constexpr int kNumOps = static_cast<int>(Op::Pow) + 1;
+
+constexpr int arity(Op op) noexcept {
+    if (op == Op::Const || op == Op::Var)
+        return 0;
+    return op < Op::Add ? 1 : 2;
+}
+
+constexpr bool is_commutative(Op op) noexcept { return op == Op::Add || op == Op::Mul; }
+
+/// Lower-case mnemonic, also the surface syntax of unary functions.
+const char* op_name(Op op) noexcept;
+
+/// A node of the expression DAG.
+///
+/// Nodes are immutable and owned by the `ExprPool` that created them. Because
+/// the pool hash-conses every node, two nodes from the same pool are
+/// structurally equal exactly when their pointers are equal.
+struct Node {
+    Op op;
+    std::uint32_t id;    ///< dense index within the owning pool
+    std::uint64_t hash;  ///< structural hash, identical across pools and runs
+    double value;        ///< payload of `Op::Const`
+    std::uint32_t var;   ///< payload of `Op::Var`
+    const Node* arg[2];
+
+    bool is_const() const noexcept { return op == Op::Const; }
+    bool is_const(double v) const noexcept { return op == Op::Const && value == v; }
+};
+
+/// Arena-backed, hash-consed store of expression nodes.
+///
+/// Every constructor first applies cheap local identities (constant folding,
+/// `x+0`, `x*1`, `x*0`, `x-x`, ...) and canonicalizes the operand order of
+/// commutative operations, then returns the existing node if an equal one is
+/// already in the pool. Shared subterms are therefore stored once no matter
+/// how often the product and chain rules replicate them.
+class ExprPool {
+public:
+    explicit ExprPool(std::size_t arena_block_size = 64 * 1024);
+
+    ExprPool(const ExprPool&) = delete;
+    ExprPool& operator=(const ExprPool&) = delete;
+
+    const Node* constant(double v);
+    const Node* variable(std::uint32_t index);
+    const Node* unary(Op op, const Node* a);
+    const Node* binary(Op op, const Node* a, const Node* b);
+    /// Dispatches to `unary` or `binary` by the arity of `op`.
+    const Node* make(Op op, const Node* a, const Node* b = nullptr);
+
+    const Node* neg(const Node* a) { return unary(Op::Neg, a); }
+    const Node* sqrt(const Node* a) { return unary(Op::Sqrt, a); }
+    const Node* exp(const Node* a) { return unary(Op::Exp, a); }
+    const Node* log(const Node* a) { return unary(Op::Log, a); }
+    const Node* sin(const Node* a) { return unary(Op::Sin, a); }
+    const Node* cos(const Node* a) { return unary(Op::Cos, a); }
+    const Node* tan(const Node* a) { return unary(Op::Tan, a); }
+    const Node* tanh(const Node* a) { return unary(Op::Tanh, a); }
+    const Node* add(const Node* a, const Node* b) { return binary(Op::Add, a, b); }
+    const Node* sub(const Node* a, const Node* b) { return binary(Op::Sub, a, b); }
+    const Node* mul(const Node* a, const Node* b) { return binary(Op::Mul, a, b); }
+    const Node* div(const Node* a, const Node* b) { return binary(Op::Div, a, b); }
+    const Node* pow(const Node* a, const Node* b) { return binary(Op::Pow, a, b); }
+
+    /// Number of unique nodes created so far; ids are `0 .. size()-1`.
+    std::size_t size() const noexcept { return nodes_.size(); }
+    const Node* node(std::uint32_t id) const noexcept { return nodes_[id]; }
+    /// One past the largest variable index seen.
+    std::uint32_t num_variables() const noexcept { return num_vars_; }
+    std::size_t bytes_used() const noexcept;
+
+    /// Drop every node. Pointers obtained earlier become dangling.
+    void clear();
+
+private:
+    const Node* intern(Op op, double value, std::uint32_t var, const Node* a, const Node* b);
+    void grow_table();
+
+    Arena arena_;
+    std::vector<const Node*> nodes_;
+    std::vector<const Node*> table_;  // open addressing, power-of-two size
+    std::uint32_t num_vars_ = 0;
+};
+
+/// Unique nodes reachable from `roots`, children before parents.
+std::vector<const Node*> topo_order(std::span<const Node* const> roots);
+
+inline std::vector<const Node*> topo_order(const Node* root) {
+    return topo_order(std::span<const Node* const>(&root, 1));
+}
+
+/// Number of unique nodes reachable from `roots`.
+std::size_t dag_size(std::span<const Node* const> roots);
+
+}  // namespace fte
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "fte/dual.hpp"
+#include "fte/expr.hpp"
+#include "fte/simd.hpp"
+#include "fte/tape.hpp"
+
+namespace fte {
+
+/// Hessian-vector products `H v` of a function recorded on a `Tape`, by
+/// forward over reverse.
+///
+/// Construction runs the one backward sweep and stores, per tape entry, the
+/// operand indices, the local partials and the local second derivatives.
+/// Every product then replays that copy: a forward tangent sweep along the
+/// directions and a reverse sweep of the tangents of the adjoints. Both
+/// sweeps carry `kWidth` directions in one `simd::Pack`, so a batch of
+/// `kWidth` products costs about two sweeps of packed arithmetic, a small
+/// multiple of the gradient's one. The tape is not used after construction
+/// and can be cleared or recorded again. An evaluator keeps its scratch
+/// between calls and is not thread-safe.
+class HvpEvaluator {
+public:
+    static constexpr std::size_t kWidth = kDualWidth;
+
+    /// `output` must have been recorded on `tape`.
+    HvpEvaluator(Tape& tape, const Real& output);
+
+    std::size_t num_inputs() const noexcept { return num_inputs_; }
+    /// The recorded function value and its gradient.
+    double value() const noexcept { return value_; }
+    std::span<const double> gradient() const noexcept { return gradient_; }
+
+    /// `v` is `k` rows of `num_inputs()` entries, one direction per row;
+    /// `hv` receives `k` rows, row `j` being `H v_j`.
+    void operator()(std::span<const double> v, std::size_t k, std::span<double> hv);
+
+private:
+    using Lanes = simd::Pack<double, kWidth>;
+
+    /// One tape entry as the sweeps need it. Inputs read their tangent from
+    /// a seed row past the end of the tape, so no entry is special.
+    struct Local {
+        std::uint32_t a, b;
+        double pa, pb;          // first partials
+        double haa, hab, hbb;   // second partials
+        double adjoint;
+    };
+
+    void batch(const double* v, std::size_t lanes, double* hv);
+
+    std::size_t num_inputs_ = 0;
+    std::uint32_t output_ = 0;  // entry of the output, 0 if passive
+    double value_ = 0.0;
+    std::vector<double> gradient_;
+    std::vector<Local> local_;
+    std::vector<std::uint32_t> inputs_;  // entry of each input
+    std::vector<Lanes> tangent_;         // [entry or seed row]
+    std::vector<Lanes> adjoint_tangent_;
+};
+
+/// Record `f` at `x` on `tape` and write `k` Hessian-vector products to
+/// `hv`, as `HvpEvaluator`. Returns f(x).
+double hessian_vector_products(Tape& tape, const Node* f, std::span<const double> x,
+                               std::span<const double> v, std::size_t k, std::span<double> hv);
+
+}  // namespace fte
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "fte/derivative.hpp"
+#include "fte/expr.hpp"
+#include "fte/parser.hpp"
+
+namespace fte {
+
+/// What one `IncrementalGradient::update` did.
+struct EditStats {
+    std::size_t changed_nodes = 0;  ///< subterms no earlier version had
+    std::size_t recomputed = 0;     ///< (node, variable) derivatives computed
+    std::size_t reused = 0;         ///< (node, variable) derivatives taken from the memo
+    std::uint32_t variables = 0;    ///< variables differentiated for
+    std::uint32_t new_variables = 0;
+};
+
+/// The gradient of a formula that is edited and differentiated again.
+///
+/// Every version is parsed into one pool, so hash-consing is the diff: the
+/// subterms an edit leaves alone intern to the nodes the previous version
+/// used, and only the edited terms and their ancestors are new. One
+/// `Differentiator` is kept across versions and stops at memoized subterms,
+/// so it derives exactly those new nodes: differentiation costs time in the
+/// size of the edit, not of the formula. The exception is a variable seen
+/// for the first time, whose derivative takes one full pass. Parsing text
+/// is still linear in its length; tooling that edits the DAG directly can
+/// pass the new version as a node and skip it.
+///
+/// Old versions stay in the pool, where a later edit that undoes a change
+/// finds them again; `reset()` drops them.
+class IncrementalGradient {
+public:
+    explicit IncrementalGradient(std::size_t arena_block_size = 64 * 1024);
+
+    /// Parse `text` as the new version and update the gradient. Throws
+    /// `ParseError`, leaving the previous version current.
+    EditStats update(std::string_view text);
+    /// Make `f`, built in `pool()` over the variables of `symbols()`, the new
+    /// version.
+    EditStats update(const Node* f);
+
+    const Node* function() const noexcept { return function_; }
+    /// `d function / d x_v` for every variable `v` in `symbols()`, including
+    /// ones earlier versions used.
+    std::span<const Node* const> gradient() const noexcept { return gradient_; }
+
+    ExprPool& pool() noexcept { return pool_; }
+    SymbolTable& symbols() noexcept { return symbols_; }
+    /// Totals over all updates since construction.
+    const Differentiator::Stats& stats() const noexcept { return differentiator_.stats(); }
+
+    void reset();
+
+private:
+    ExprPool pool_;
+    SymbolTable symbols_;
+    Differentiator differentiator_;
+    const Node* function_ = nullptr;
+    std::vector<const Node*> gradient_;
+};
+
+}  // namespace fte
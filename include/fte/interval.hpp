@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <vector>
+
+#include "fte/program.hpp"
+
+namespace fte {
+
+/// Outward rounding for enclosures.
+///
+/// Results are computed in the default rounding mode and then moved outward
+/// by a whole number of units in the last place, which dominates the error
+/// of a correctly rounded operation (half an ulp) or of a libm function
+/// (`kLibmUlps`). Unlike switching the FPU rounding mode this is branch-free,
+/// leaves the rest of the program unaffected and keeps loops vectorizable.
+namespace rounding {
+
+inline constexpr double kUlp = 0x1p-52;
+/// Documented worst-case error of glibc's double elementary functions is
+/// below this many ulps.
+inline constexpr double kLibmUlps = 4.0;
+inline constexpr double kMax = std::numeric_limits<double>::max();
+inline constexpr double kInf = std::numeric_limits<double>::infinity();
+
+/// A value no greater than the exact result `x` approximates to within `ulps`.
+inline double down(double x, double ulps = 1.0) noexcept {
+    const double r = x - (std::abs(x) * (ulps * kUlp) + std::numeric_limits<double>::denorm_min());
+    return x == kInf ? kMax : r;
+}
+
+inline double up(double x, double ulps = 1.0) noexcept {
+    const double r = x + (std::abs(x) * (ulps * kUlp) + std::numeric_limits<double>::denorm_min());
+    return x == -kInf ? -kMax : r;
+}
+
+/// Product in which `0 * inf` is 0, as needed for interval endpoints.
+inline double mul0(double a, double b) noexcept { return (a == 0.0 || b == 0.0) ? 0.0 : a * b; }
+
+}  // namespace rounding
+
+/// Closed interval `[lo, hi]` with outward-rounded arithmetic: the result
+/// of every operation contains the exact image of its operands. Operations
+/// outside their domain are restricted to it (`sqrt([-1, 4]) = [0, 2]`); an
+/// empty result is `[NaN, NaN]`. Works with the generic `evaluate<T>`.
+struct Interval {
+    double lo;
+    double hi;
+
+    Interval() noexcept : lo(0.0), hi(0.0) {}
+    Interval(double v) noexcept : lo(v), hi(v) {}  // NOLINT: implicit by design
+    Interval(double l, double h) noexcept : lo(l), hi(h) {}
+
+    static Interval entire() noexcept { return {-rounding::kInf, rounding::kInf}; }
+    static Interval empty() noexcept {
+        return {std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN()};
+    }
+
+    double mid() const noexcept { return 0.5 * lo + 0.5 * hi; }
+    double width() const noexcept { return hi - lo; }
+    bool is_empty() const noexcept { return !(lo <= hi); }
+    bool contains(double x) const noexcept { return lo <= x && x <= hi; }
+
+    friend Interval operator-(const Interval& a) noexcept { return {-a.hi, -a.lo}; }
+    friend Interval operator+(const Interval& a, const Interval& b) noexcept {
+        return {rounding::down(a.lo + b.lo), rounding::up(a.hi + b.hi)};
+    }
+    friend Interval operator-(const Interval& a, const Interval& b) noexcept {
+        return {rounding::down(a.lo - b.hi), rounding::up(a.hi - b.lo)};
+    }
+    friend Interval operator*(const Interval& a, const Interval& b) noexcept {
+        using rounding::mul0;
+        const double p0 = mul0(a.lo, b.lo), p1 = mul0(a.lo, b.hi);
+        const double p2 = mul0(a.hi, b.lo), p3 = mul0(a.hi, b.hi);
+        return {rounding::down(std::min(std::min(p0, p1), std::min(p2, p3))),
+                rounding::up(std::max(std::max(p0, p1), std::max(p2, p3)))};
+    }
+    friend Interval operator/(const Interval& a, const Interval& b) noexcept {
+        if (b.lo <= 0.0 && b.hi >= 0.0)
+            return entire();
+        const double q0 = a.lo / b.lo, q1 = a.lo / b.hi, q2 = a.hi / b.lo, q3 = a.hi / b.hi;
+        return {rounding::down(std::min(std::min(q0, q1), std::min(q2, q3))),
+                rounding::up(std::max(std::max(q0, q1), std::max(q2, q3)))};
+    }
+
+    friend Interval sqrt(const Interval& a) noexcept {
+        if (a.hi < 0.0)
+            return empty();
+        return {a.lo <= 0.0 ? 0.0 : std::max(0.0, rounding::down(std::sqrt(a.lo))),
+                rounding::up(std::sqrt(a.hi))};
+    }
+    friend Interval exp(const Interval& a) noexcept {
+        return {std::max(0.0, rounding::down(std::exp(a.lo), rounding::kLibmUlps)),
+                rounding::up(std::exp(a.hi), rounding::kLibmUlps)};
+    }
+    friend Interval log(const Interval& a) noexcept {
+        if (a.hi < 0.0)
+            return empty();
+        return {a.lo <= 0.0 ? -rounding::kInf : rounding::down(std::log(a.lo), rounding::kLibmUlps),
+                rounding::up(std::log(a.hi), rounding::kLibmUlps)};
+    }
+    friend Interval tanh(const Interval& a) noexcept {
+        return {std::max(-1.0, rounding::down(std::tanh(a.lo), rounding::kLibmUlps)),
+                std::min(1.0, rounding::up(std::tanh(a.hi), rounding::kLibmUlps))};
+    }
+    friend Interval sin(const Interval& a) noexcept {
+        return periodic(a, std::sin(a.lo), std::sin(a.hi), std::numbers::pi / 2);
+    }
+    friend Interval cos(const Interval& a) noexcept {
+        return periodic(a, std::cos(a.lo), std::cos(a.hi), 0.0);
+    }
+    friend Interval tan(const Interval& a) noexcept {
+        // Monotone between poles at pi/2 + k pi.
+        if (!(a.hi - a.lo < std::numbers::pi) || hits(a, std::numbers::pi / 2, std::numbers::pi))
+            return entire();
+        return {rounding::down(std::tan(a.lo), rounding::kLibmUlps),
+                rounding::up(std::tan(a.hi), rounding::kLibmUlps)};
+    }
+    friend Interval pow(const Interval& a, const Interval& b) noexcept {
+        if (b.lo == b.hi && b.lo == std::round(b.lo) && std::abs(b.lo) < 0x1p53)
+            return ipow(a, b.lo);
+        // x^y = exp(y log x) on the domain x >= 0.
+        if (a.hi < 0.0)
+            return empty();
+        return exp(b * log(Interval(std::max(a.lo, 0.0), a.hi)));
+    }
+
+private:
+    /// Does `[lo - tol, hi + tol]` contain a point `phase + k * period`?
+    static bool hits(const Interval& a, double phase, double period) noexcept {
+        const double tol = 1e-12 * (1.0 + std::max(std::abs(a.lo), std::abs(a.hi)));
+        const double k = std::floor((a.lo - phase) / period);
+        for (int j = 0; j <= 2; ++j) {
+            const double t = phase + (k + j) * period;
+            if (t >= a.lo - tol && t <= a.hi + tol)
+                return true;
+        }
+        return false;
+    }
+
+    /// sin or cos, whose maxima lie at `peak + 2k pi` and minima half a
+    /// period later, from their values at the endpoints.
+    static Interval periodic(const Interval& a, double at_lo, double at_hi, double peak) noexcept {
+        constexpr double two_pi = 2 * std::numbers::pi;
+        if (!(a.hi - a.lo < two_pi) || std::max(std::abs(a.lo), std::abs(a.hi)) > 0x1p40)
+            return {-1.0, 1.0};
+        double lo = rounding::down(std::min(at_lo, at_hi), rounding::kLibmUlps);
+        double hi = rounding::up(std::max(at_lo, at_hi), rounding::kLibmUlps);
+        if (hits(a, peak, two_pi))
+            hi = 1.0;
+        if (hits(a, peak + std::numbers::pi, two_pi))
+            lo = -1.0;
+        return {std::max(lo, -1.0), std::min(hi, 1.0)};
+    }
+
+    /// Integer power, exact in the sign structure of even exponents.
+    static Interval ipow(const Interval& a, double k) noexcept {
+        if (k == 0.0)
+            return Interval(1.0);
+        if (k < 0.0)
+            return Interval(1.0) / ipow(a, -k);
+        const double plo = std::pow(a.lo, k), phi = std::pow(a.hi, k);
+        const bool odd = std::fmod(k, 2.0) != 0.0;
+        double lo, hi;
+        if (odd || a.lo >= 0.0) {
+            lo = plo;
+            hi = phi;
+        } else if (a.hi <= 0.0) {
+            lo = phi;
+            hi = plo;
+        } else {
+            lo = 0.0;
+            hi = std::max(plo, phi);
+        }
+        lo = rounding::down(lo, rounding::kLibmUlps);
+        return {odd ? lo : std::max(0.0, lo), rounding::up(hi, rounding::kLibmUlps)};
+    }
+};
+
+/// Evaluates a `Program` over boxes of intervals in structure-of-arrays
+/// layout, so that many regions are bounded in one pass, for instance the
+/// outputs of a `gradient_program` to prune a branch-and-bound search.
+///
+/// Each instruction runs as one loop over a tile of lanes in which the
+/// arithmetic operations are branch-free and vectorize; elementary functions
+/// call libm per endpoint. Not thread-safe; give each thread its own.
+class IntervalEvaluator {
+public:
+    static constexpr std::size_t kDefaultTile = 256;
+
+    explicit IntervalEvaluator(const Program& program, std::size_t tile = kDefaultTile);
+
+    /// Input `i` of box `p` is `[lo[i][p], hi[i][p]]`; output `r` of box `p`
+    /// is written to `out_lo[r][p]` and `out_hi[r][p]`.
+    void operator()(std::span<const double* const> lo, std::span<const double* const> hi,
+                    std::span<double* const> out_lo, std::span<double* const> out_hi,
+                    std::size_t n);
+
+    const Program& program() const noexcept { return program_; }
+
+private:
+    const Program& program_;
+    std::size_t tile_;
+    std::unique_ptr<double[]> scratch_;  // [slot][lo | hi][lane]
+    std::vector<double*> lo_, hi_;       // per slot, into the scratch
+    std::vector<const double*> src_lo_, src_hi_;
+};
+
+/// Evaluates a `Program` in affine arithmetic: each value is
+/// `x_0 + sum_i x_i e_i + [-d, d]` with one noise symbol `e_i in [-1, 1]` per
+/// program input, so that correlations between subterms survive and
+/// dependent expressions such as `x - x` or `x * (1 - x)` get much tighter
+/// bounds than in interval arithmetic.
+///
+/// `exp`, `log`, `sqrt` and reciprocals use min-range linearizations; the
+/// other functions fall back to their interval range, folded into `d`.
+/// Rounding errors of every coefficient are accounted for in `d`, so the
+/// reported bounds are guaranteed. A value without finite bounds, such as a
+/// quotient by a range that contains zero, becomes the whole line and stays
+/// so through later operations; domain errors widen to it too. Batched like `IntervalEvaluator`, with
+/// lanes innermost so the coefficient updates vectorize.
+class AffineEvaluator {
+public:
+    static constexpr std::size_t kDefaultTile = 64;
+
+    explicit AffineEvaluator(const Program& program, std::size_t tile = kDefaultTile);
+
+    void operator()(std::span<const double* const> lo, std::span<const double* const> hi,
+                    std::span<double* const> out_lo, std::span<double* const> out_hi,
+                    std::size_t n);
+
+    const Program& program() const noexcept { return program_; }
+
+private:
+    struct Form;
+    void apply(const Instr& in, std::size_t len);
+
+    const Program& program_;
+    std::size_t tile_;
+    std::size_t terms_;  // center, one coefficient per input, radius d
+    std::vector<double> scratch_;  // [slot][term][lane]
+    std::vector<double> tmp_;      // two spare forms and per-lane scalars
+};
+
+}  // namespace fte
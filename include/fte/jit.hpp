@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "fte/expr.hpp"
+
+namespace fte {
+
+/// Straight-line C++ source evaluating `roots`.
+///
+/// The translation unit defines two C entry points:
+///
+///     void fte_eval(const double* x, double* out);
+///     void fte_eval_batch(size_t n, const double* const* x, double* const* out);
+///
+/// `fte_eval` reads variable `i` from `x[i]` and writes root `r` to `out[r]`.
+/// `fte_eval_batch` takes structure-of-arrays spans: `x[i][p]` is variable
+/// `i` at point `p`, `out[r][p]` receives root `r` at point `p`.
+std::string emit_cpp(std::span<const Node* const> roots);
+
+struct JitOptions {
+    /// Compiler driver; empty means `$FTE_JIT_CXX` or the compiler that built
+    /// the library.
+    std::string compiler;
+    /// Flags for the kernel; empty means `-O3 -march=native -fno-math-errno`.
+    std::string flags;
+    /// Kernel cache; empty means `$FTE_CACHE_DIR`, then `$XDG_CACHE_HOME/fte`,
+    /// then `~/.cache/fte`.
+    std::filesystem::path cache_dir;
+};
+
+/// Native code for a set of expressions, compiled by the system compiler and
+/// loaded with `dlopen`.
+///
+/// Shared objects are cached on disk under a key derived from the structural
+/// hash of the roots, the compiler and the flags, so a restarted process
+/// loads a previously built kernel without invoking the compiler. The source
+/// each object was built from is kept next to it and compared before a
+/// cached object is loaded, so a key collision costs a private compile
+/// rather than a wrong kernel. Publishing into the cache is an atomic rename,
+/// which makes concurrent builds of the same kernel safe.
+class CompiledKernel {
+public:
+    using PointFn = void (*)(const double* x, double* out);
+    using BatchFn = void (*)(std::size_t n, const double* const* x, double* const* out);
+
+    /// Throws `std::runtime_error` if the compiler fails or the object cannot
+    /// be loaded.
+    static CompiledKernel compile(std::span<const Node* const> roots,
+                                  const JitOptions& options = {});
+
+    CompiledKernel() = default;
+    CompiledKernel(CompiledKernel&& other) noexcept;
+    CompiledKernel& operator=(CompiledKernel&& other) noexcept;
+    ~CompiledKernel();
+
+    CompiledKernel(const CompiledKernel&) = delete;
+    CompiledKernel& operator=(const CompiledKernel&) = delete;
+
+    void operator()(const double* x, double* out) const { point_(x, out); }
+    void batch(std::size_t n, const double* const* x, double* const* out) const {
+        batch_(n, x, out);
+    }
+
+    explicit operator bool() const noexcept { return handle_ != nullptr; }
+    PointFn point_function() const noexcept { return point_; }
+    BatchFn batch_function() const noexcept { return batch_; }
+    std::uint64_t key() const noexcept { return key_; }
+    /// The loaded object; after a key collision, a private file that is
+    /// already gone.
+    const std::filesystem::path& path() const noexcept { return path_; }
+    /// True when the kernel was loaded from the disk cache without compiling.
+    bool from_cache() const noexcept { return from_cache_; }
+
+private:
+    void* handle_ = nullptr;
+    PointFn point_ = nullptr;
+    BatchFn batch_ = nullptr;
+    std::uint64_t key_ = 0;
+    std::filesystem::path path_;
+    bool from_cache_ = false;
+};
+
+/// Cache key `CompiledKernel::compile` would use for `roots` and `options`.
+std::uint64_t kernel_key(std::span<const Node* const> roots, const JitOptions& options = {});
+
+}  // namespace fte
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "fte/program.hpp"
+
+namespace fte {
+
+/// Jacobian-vector products `J v` of a `Program` at one point, for a batch
+/// of directions, in one forward pass.
+///
+/// Each instruction computes its value and local partials once and then
+/// updates the tangents of all directions with one vectorizable loop, so
+/// the Jacobian is never formed: the scratch is one value and `k` tangents
+/// per slot, whatever the number of inputs and outputs. An evaluator keeps
+/// its scratch between calls and is not thread-safe.
+class JvpEvaluator {
+public:
+    explicit JvpEvaluator(const Program& program) : program_(program) {}
+
+    /// `v` is `k` rows of `num_inputs()` entries, one direction per row;
+    /// `jv` receives `k` rows of `num_outputs()` entries, row `j` being
+    /// `J v_j`. `y` receives the outputs themselves and may be empty.
+    void operator()(std::span<const double> x, std::span<const double> v, std::size_t k,
+                    std::span<double> y, std::span<double> jv);
+
+    const Program& program() const noexcept { return program_; }
+
+private:
+    const Program& program_;
+    std::vector<double> value_;    // [slot]
+    std::vector<double> tangent_;  // [slot][direction]
+};
+
+/// Vector-Jacobian products `w^T J` of a `Program` at one point, for a batch
+/// of adjoint seeds: one forward pass that keeps the local partials of every
+/// instruction, then one reverse sweep over all seeds at once.
+///
+/// Programs whose slots are reused work too: the sweep clears a slot's
+/// adjoint where the value it belongs to is defined. The scratch is two
+/// partials per instruction and `k` adjoints per slot; the Jacobian is never
+/// formed. An evaluator keeps its scratch between calls and is not
+/// thread-safe.
+class VjpEvaluator {
+public:
+    explicit VjpEvaluator(const Program& program) : program_(program) {}
+
+    /// `w` is `k` rows of `num_outputs()` entries, one seed per row; `wj`
+    /// receives `k` rows of `num_inputs()` entries, row `j` being `w_j^T J`.
+    /// `y` receives the outputs themselves and may be empty.
+    void operator()(std::span<const double> x, std::span<const double> w, std::size_t k,
+                    std::span<double> y, std::span<double> wj);
+
+    const Program& program() const noexcept { return program_; }
+
+private:
+    const Program& program_;
+    std::vector<double> value_;     // [slot]
+    std::vector<double> partial_;   // [instruction][operand]
+    std::vector<double> adjoint_;   // [slot][seed]
+};
+
+/// One-shot convenience wrappers around `JvpEvaluator` and `VjpEvaluator`.
+void jvp(const Program& program, std::span<const double> x, std::span<const double> v,
+         std::size_t k, std::span<double> y, std::span<double> jv);
+void vjp(const Program& program, std::span<const double> x, std::span<const double> w,
+         std::size_t k, std::span<double> y, std::span<double> wj);
+
+}  // namespace fte
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "fte/batch.hpp"
+#include "fte/program.hpp"
+
+namespace fte {
+
+/// Arithmetic formats for reduced precision evaluation. Every instruction
+/// computes in `float` and rounds its result to the format; the 16-bit
+/// formats are emulated in float lanes, so they give their accuracy but not
+/// more speed than `Float`.
+enum class Precision : std::uint8_t {
+    Float,     ///< binary32, unit roundoff 6.0e-8
+    Half,      ///< IEEE binary16, unit roundoff 4.9e-4
+    BFloat16,  ///< bfloat16, unit roundoff 3.9e-3
+};
+
+/// Unit roundoff of `precision`.
+double unit_roundoff(Precision precision) noexcept;
+
+struct MixedPrecisionOptions {
+    Precision precision = Precision::Float;
+    /// Accepted error of each output over a tile's sampled points, relative
+    /// to the largest magnitude of that output among them. Keep it well
+    /// above the format's unit roundoff: about 1e-2 for `Half` and
+    /// `BFloat16`.
+    double tolerance = 1e-4;
+    /// Added to the allowed error, for outputs that are zero on all samples.
+    double absolute_tolerance = 0.0;
+    /// Shadow-evaluate one point in this many in double; 0 disables sampling.
+    std::size_t sample_stride = 64;
+    /// Lanes whose additions or subtractions cancel more than this factor,
+    /// `(|a| + |b|) / |a ± b|`, are redone in double. 0 derives it as
+    /// `tolerance / unit_roundoff(precision)`.
+    double max_cancellation = 0.0;
+    /// When more than this fraction of a tile's lanes is flagged, the whole
+    /// tile is redone in double instead of lane by lane.
+    double max_flagged_fraction = 0.125;
+};
+
+/// What a `MixedPrecisionEvaluator` has done since construction or the last
+/// `reset_stats`.
+struct MixedPrecisionStats {
+    std::size_t points = 0;
+    std::size_t reduced_points = 0;     ///< outputs taken from the reduced run
+    std::size_t sampled_points = 0;     ///< shadow-evaluated in double
+    std::size_t recomputed_points = 0;  ///< flagged lanes redone in double one by one
+    std::size_t fallback_tiles = 0;     ///< tiles evaluated in double as a whole
+    std::size_t fallback_points = 0;
+    double max_sampled_error = 0.0;     ///< largest relative error seen on samples
+};
+
+/// Evaluates a `Program` like `BatchEvaluator`, but in single precision,
+/// which fits twice as many lanes in a vector register, falling back to
+/// double where that is unsafe.
+///
+/// Exponentials, logarithms, sines, cosines and tanh run on the float
+/// routines of `fte/vmath.hpp`.
+///
+/// Two cheap checks guard each tile. During the reduced run, additions and
+/// subtractions flag the lanes where they cancel badly, and lanes whose
+/// outputs are not finite are flagged too; flagged lanes are redone in
+/// double. After it, a sample of the tile's points is evaluated in double
+/// and, if any output's error on the sample exceeds the tolerance, the whole
+/// tile is redone in double. Sampled points keep their double results.
+/// Samples and flagged lanes are gathered and evaluated as one batch each.
+/// After a tile is redone, the next ones go straight to double for a
+/// stretch that doubles with every failed retry, so a program that never
+/// qualifies costs little more than with `BatchEvaluator`.
+/// An evaluator is not thread-safe; give each thread its own.
+class MixedPrecisionEvaluator {
+public:
+    static constexpr std::size_t kDefaultTile = 512;
+
+    explicit MixedPrecisionEvaluator(const Program& program, MixedPrecisionOptions options = {},
+                                     std::size_t tile = kDefaultTile);
+
+    /// Same layout and requirements as `BatchEvaluator::operator()`.
+    void operator()(std::span<const double* const> inputs, std::span<double* const> outputs,
+                    std::size_t n);
+
+    const Program& program() const noexcept { return program_; }
+    const MixedPrecisionOptions& options() const noexcept { return options_; }
+    std::size_t tile() const noexcept { return tile_; }
+    const MixedPrecisionStats& stats() const noexcept { return stats_; }
+    void reset_stats() noexcept { stats_ = {}; }
+
+private:
+    /// Returns whether the tile at `p0` was accepted, possibly after
+    /// redoing some lanes; if not, the caller redoes it in double.
+    bool run_tile(std::span<const double* const> inputs, std::span<double* const> outputs,
+                  std::size_t p0, std::size_t len);
+    /// Evaluate `lanes` of the tile at `p0` in double, as one batch, into
+    /// the columns of `redo_out_`.
+    void redo(std::span<const double* const> inputs, std::size_t p0,
+              std::span<const std::uint32_t> lanes);
+
+    const Program& program_;
+    MixedPrecisionOptions options_;
+    std::size_t tile_;
+    float kappa_;
+    std::unique_ptr<float[]> scratch_;  // [slot][lane], 64-byte aligned rows
+    std::vector<float*> slot_ptr_;      // every slot, inputs included
+    std::vector<float> risk_;             // per lane; flagged when not <= 0
+    std::vector<std::uint32_t> flagged_, sampled_;  // lanes of the tile
+    BatchEvaluator fallback_;
+    std::vector<const double*> in_ptr_;
+    std::vector<double*> out_ptr_;
+    std::vector<std::vector<double>> lanes_;  // gathered inputs, then outputs
+    std::vector<const double*> redo_in_;
+    std::vector<double*> redo_out_;
+    std::size_t tiles_seen_ = 0;
+    std::size_t backoff_ = 0, skip_ = 0;  // tiles to run in double before a retry
+    MixedPrecisionStats stats_;
+};
+
+}  // namespace fte
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "fte/program.hpp"
+#include "fte/thread_pool.hpp"
+
+namespace fte {
+
+/// Points per scheduling chunk such that a chunk's input and output columns
+/// fit in roughly one core's L2 cache, rounded to whole evaluator tiles.
+std::size_t default_chunk(const Program& program);
+
+/// Multithreaded `evaluate_batch`: the points are split into cache-sized
+/// chunks that the pool's workers evaluate and steal from each other. Every
+/// point goes through the same instruction sequence regardless of which
+/// worker handles it, so results are bitwise identical for any schedule or
+/// thread count. `chunk == 0` picks `default_chunk(program)`.
+void evaluate_batch_parallel(ThreadPool& pool, const Program& program,
+                             std::span<const double* const> inputs,
+                             std::span<double* const> outputs, std::size_t n,
+                             std::size_t chunk = 0);
+
+/// Evaluates several independent programs (for instance one per partial
+/// derivative) over the same input columns. `outputs[k]` holds the output
+/// columns of `programs[k]`; every (program, chunk) pair is a separate task.
+void evaluate_batch_parallel(ThreadPool& pool, std::span<const Program* const> programs,
+                             std::span<const double* const> inputs,
+                             std::span<const std::span<double* const>> outputs, std::size_t n,
+                             std::size_t chunk = 0);
+
+}  // namespace fte
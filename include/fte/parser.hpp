@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fte/arena.hpp"
+#include "fte/expr.hpp"
+
+namespace fte {
+
+/// Interned identifiers.
+///
+/// Each distinct name is copied once into the table's arena and assigned the
+/// next integer symbol, which is also the variable index the parser uses for
+/// it. Lookups hash the `string_view` directly and never allocate.
+class SymbolTable {
+public:
+    SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    /// Symbol of `name`, interning it on first use.
+    std::uint32_t intern(std::string_view name);
+    std::optional<std::uint32_t> find(std::string_view name) const noexcept;
+
+    std::string_view name(std::uint32_t symbol) const noexcept { return names_[symbol]; }
+    std::size_t size() const noexcept { return names_.size(); }
+
+    /// Names indexed by symbol, in the form `to_string` accepts.
+    std::vector<std::string> names() const;
+
+    void clear();
+
+private:
+    std::size_t probe(std::string_view name, std::uint64_t hash) const noexcept;
+    void grow_table();
+
+    Arena arena_;
+    std::vector<std::string_view> names_;
+    std::vector<std::uint32_t> table_;  // symbol + 1, 0 = empty; power-of-two size
+};
+
+/// Syntax error with the byte offset at which it was detected.
+class ParseError : public std::invalid_argument {
+public:
+    ParseError(const std::string& what, std::size_t offset)
+        : std::invalid_argument(what), offset_(offset) {}
+
+    std::size_t offset() const noexcept { return offset_; }
+
+private:
+    std::size_t offset_;
+};
+
+/// Parse an infix formula into `pool`.
+///
+/// Grammar: `+ - * /`, right-associative `^` (or `**`) binding tighter than
+/// unary minus, parentheses, decimal and exponent literals, and calls of the
+/// functions named by `op_name` (`sin(x)`, `pow(a, b)`, ...). `inf` and
+/// `nan` are constants; any other identifier not followed by `(` is a
+/// variable whose index is its symbol in `symbols`, so the output of
+/// `to_string(f, symbols.names())` parses back to `f`, up to the sign and
+/// payload of NaN constants, as long as no variable is named `inf` or `nan`.
+///
+/// Single pass, no tokenizer buffer: nodes go straight into the pool's arena
+/// and the only allocations are the pool's and table's own amortized growth.
+/// Throws `ParseError`.
+const Node* parse(std::string_view text, ExprPool& pool, SymbolTable& symbols);
+
+}  // namespace fte
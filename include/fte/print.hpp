@@ -0,0 +1,16 @@
+#pragma once
+
+#include <span>
+#include <string>
+
+#include "fte/expr.hpp"
+
+namespace fte {
+
+/// Infix rendering of `root`. Variables without an entry in `names` print as
+/// `x0`, `x1`, ... Shared subterms are expanded, so the output can be much
+/// larger than the DAG. Non-finite constants print as `inf`, `-inf` and
+/// `nan`, which `parse` reads back.
+std::string to_string(const Node* root, std::span<const std::string> names = {});
+
+}  // namespace fte
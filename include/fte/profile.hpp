@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <x86intrin.h>
+#endif
+
+/// Hot-path instrumentation.
+///
+/// The library's phases are wrapped in `FTE_PROFILE_SCOPE` timers and its
+/// notable events in `FTE_PROFILE_COUNT` counters. Both expand to nothing
+/// unless the library is built with `FTE_ENABLE_PROFILING` (CMake option of
+/// the same name), so the default build pays nothing. When enabled, each
+/// thread updates its own counters without atomic read-modify-writes or
+/// locks, a scope costs two timestamp reads, and readers merge all threads
+/// on demand. Phase times are inclusive: a scope nested in another phase,
+/// such as the differentiation inside `gradient_program`, counts for both.
+namespace fte::profile {
+
+#if defined(FTE_ENABLE_PROFILING)
+inline constexpr bool kEnabled = true;
+#else
+inline constexpr bool kEnabled = false;
+#endif
+
+enum class Phase : std::uint8_t {
+    Parse,
+    Differentiate,
+    Simplify,
+    Codegen,      ///< linearization and JIT compilation
+    CacheLookup,
+    Evaluate,
+};
+inline constexpr std::size_t kNumPhases = static_cast<std::size_t>(Phase::Evaluate) + 1;
+
+enum class Counter : std::uint8_t {
+    ParsedBytes,
+    CacheHits,
+    CacheMisses,
+    CacheEvictions,
+    EvaluatedPoints,
+};
+inline constexpr std::size_t kNumCounters = static_cast<std::size_t>(Counter::EvaluatedPoints) + 1;
+
+/// Snake-case names, as used in the exports.
+const char* phase_name(Phase phase) noexcept;
+const char* counter_name(Counter counter) noexcept;
+
+struct PhaseStats {
+    std::uint64_t calls = 0;
+    std::uint64_t total_ns = 0;
+    std::uint64_t max_ns = 0;
+};
+
+/// Totals over every thread that has recorded anything.
+struct Snapshot {
+    std::array<PhaseStats, kNumPhases> phases{};
+    std::array<std::uint64_t, kNumCounters> counters{};
+    std::size_t threads = 0;
+
+    const PhaseStats& operator[](Phase p) const noexcept { return phases[static_cast<std::size_t>(p)]; }
+    std::uint64_t operator[](Counter c) const noexcept { return counters[static_cast<std::size_t>(c)]; }
+};
+
+Snapshot snapshot();
+
+/// Start counting from zero. Safe while other threads record; a thread
+/// recording concurrently may carry its in-flight update over the reset.
+void reset();
+
+/// Keep individual scopes, up to `events_per_thread` most recent ones per
+/// thread, for `chrome_trace`. Off by default; counters are always kept.
+void set_tracing(bool on, std::size_t events_per_thread = std::size_t(1) << 16);
+bool tracing() noexcept;
+
+/// Recorded scopes in the Chrome trace event format (`chrome://tracing`,
+/// Perfetto), one track per thread.
+std::string chrome_trace();
+
+/// The snapshot in the Prometheus text exposition format.
+std::string prometheus_text();
+
+/// Nanoseconds on a monotonic clock.
+std::uint64_t now_ns() noexcept;
+
+/// Raw timestamp for scopes: the time-stamp counter on x86, which is about
+/// twice as cheap to read as the system clock and is converted against it
+/// when exporting, and `now_ns()` elsewhere.
+inline std::uint64_t ticks() noexcept {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    return __rdtsc();
+#else
+    return now_ns();
+#endif
+}
+
+/// One call of `phase` between two `ticks()` readings.
+void record(Phase phase, std::uint64_t start_ticks, std::uint64_t end_ticks) noexcept;
+void count(Counter counter, std::uint64_t n) noexcept;
+
+/// Times its own lifetime as one call of `phase`.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Phase phase) noexcept : phase_(phase), start_(ticks()) {}
+    ~ScopedTimer() { record(phase_, start_, ticks()); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Phase phase_;
+    std::uint64_t start_;
+};
+
+}  // namespace fte::profile
+
+#if defined(FTE_ENABLE_PROFILING)
+#define FTE_PROFILE_CONCAT_(a, b) a##b
+#define FTE_PROFILE_CONCAT(a, b) FTE_PROFILE_CONCAT_(a, b)
+/// Time the rest of the enclosing block as one call of `Phase::phase`.
+#define FTE_PROFILE_SCOPE(phase) \
+    ::fte::profile::ScopedTimer FTE_PROFILE_CONCAT(fte_profile_scope_, __LINE__)(::fte::profile::Phase::phase)
+/// Add `n` to `Counter::counter`; `n` is not evaluated when compiled out.
+#define FTE_PROFILE_COUNT(counter, n) ::fte::profile::count(::fte::profile::Counter::counter, (n))
+#else
+#define FTE_PROFILE_SCOPE(phase) static_cast<void>(0)
+#define FTE_PROFILE_COUNT(counter, n) static_cast<void>(0)
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "fte/expr.hpp"
+
+namespace fte {
+
+/// One three-address instruction: `slot[dst] = op(slot[a], slot[b])`.
+/// Unary operations ignore `b`.
+struct Instr {
+    Op op;
+    std::uint32_t dst;
+    std::uint32_t a;
+    std::uint32_t b;
+};
+
+struct LinearizeOptions {
+    /// Recycle the slot of a temporary after its last use. Disable to get
+    /// single-assignment code in which every slot keeps its value, as needed
+    /// by sweeps that revisit intermediate values.
+    bool reuse_slots = true;
+};
+
+/// A set of expressions linearized into one straight-line instruction
+/// stream over a slot array.
+///
+/// Slots are laid out as `[inputs | constants | temporaries]`. Every unique
+/// subterm of every output is computed exactly once, so a function and its
+/// partials compiled together share the primal work.
+class Program {
+public:
+    Program() = default;
+
+    std::uint32_t num_inputs() const noexcept { return num_inputs_; }
+    std::uint32_t num_slots() const noexcept { return num_slots_; }
+    std::uint32_t const_base() const noexcept { return num_inputs_; }
+    std::uint32_t temp_base() const noexcept {
+        return num_inputs_ + static_cast<std::uint32_t>(constants_.size());
+    }
+    std::span<const Instr> code() const noexcept { return code_; }
+    std::span<const double> constants() const noexcept { return constants_; }
+    std::span<const std::uint32_t> outputs() const noexcept { return outputs_; }
+    std::size_t num_outputs() const noexcept { return outputs_.size(); }
+    bool is_ssa() const noexcept { return ssa_; }
+
+    /// Evaluate at one point. `slots` is scratch of at least `num_slots()`
+    /// entries, so repeated calls need not allocate.
+    void eval(std::span<const double> x, std::span<double> out, std::span<double> slots) const;
+    void eval(std::span<const double> x, std::span<double> out) const;
+
+private:
+    friend Program linearize(std::span<const Node* const>, std::uint32_t, const LinearizeOptions&);
+
+    std::uint32_t num_inputs_ = 0;
+    std::uint32_t num_slots_ = 0;
+    std::vector<Instr> code_;
+    std::vector<double> constants_;
+    std::vector<std::uint32_t> outputs_;
+    bool ssa_ = false;
+};
+
+/// Linearize `roots` over inputs `x_0 .. x_{num_inputs-1}`. Throws
+/// `std::out_of_range` if an expression uses a variable outside that range.
+Program linearize(std::span<const Node* const> roots, std::uint32_t num_inputs,
+                  const LinearizeOptions& options = {});
+
+/// `f` and all its first partials as one fused program with outputs
+/// `[f, df/dx_0, ..., df/dx_{num_vars-1}]`.
+Program gradient_program(ExprPool& pool, const Node* f, std::uint32_t num_vars,
+                         const LinearizeOptions& options = {});
+
+}  // namespace fte
@@ -0,0 +1,70 @@
+#pragma once
+
+namespace fte::rules {
+
+/// Forward differentiation rules, one per operation, shared by the runtime
+/// `Differentiator` and the compile-time expressions of `static_expr.hpp`.
+///
+/// A rule builds the derivative of node `n = op(a, b)` from its operands and
+/// their derivatives `da`, `db` using only the arithmetic operators, the
+/// elementary functions found by argument-dependent lookup and
+/// `n.template constant<V>()`. Instantiated with a handle to an `ExprPool`
+/// node it adds nodes to the DAG; instantiated with expression types it
+/// computes the derivative's type. The callers skip rules whose operand
+/// derivatives are all zero.
+
+constexpr auto neg(const auto&, const auto&, const auto& da) { return -da; }
+
+constexpr auto add(const auto&, const auto&, const auto&, const auto& da, const auto& db) {
+    return da + db;
+}
+
+constexpr auto sub(const auto&, const auto&, const auto&, const auto& da, const auto& db) {
+    return da - db;
+}
+
+constexpr auto mul(const auto&, const auto& a, const auto& b, const auto& da, const auto& db) {
+    return da * b + a * db;
+}
+
+/// (a/b)' = (a' - (a/b) b') / b reuses the quotient node itself.
+constexpr auto div(const auto& n, const auto&, const auto& b, const auto& da, const auto& db) {
+    return (da - n * db) / b;
+}
+
+constexpr auto sqrt(const auto& n, const auto&, const auto& da) {
+    return da / (n.template constant<2.0>() * n);
+}
+
+constexpr auto exp(const auto& n, const auto&, const auto& da) { return da * n; }
+
+constexpr auto log(const auto&, const auto& a, const auto& da) { return da / a; }
+
+constexpr auto sin(const auto&, const auto& a, const auto& da) { return da * cos(a); }
+
+constexpr auto cos(const auto&, const auto& a, const auto& da) { return -(da * sin(a)); }
+
+constexpr auto tan(const auto& n, const auto&, const auto& da) {
+    return da * (n.template constant<1.0>() + n * n);
+}
+
+constexpr auto tanh(const auto& n, const auto&, const auto& da) {
+    return da * (n.template constant<1.0>() - n * n);
+}
+
+/// `a^b` with a constant exponent: valid for every `a`, including 0.
+constexpr auto pow_constant_exponent(const auto& n, const auto& a, const auto& b, const auto& da) {
+    return b * pow(a, b - n.template constant<1.0>()) * da;
+}
+
+/// `a^b` with a constant base.
+constexpr auto pow_constant_base(const auto& n, const auto& a, const auto& db) {
+    return n * log(a) * db;
+}
+
+/// `a^b` in general, for `a > 0`.
+constexpr auto pow(const auto& n, const auto& a, const auto& b, const auto& da, const auto& db) {
+    return n * (db * log(a) + b * da / a);
+}
+
+}  // namespace fte::rules
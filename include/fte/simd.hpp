@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+
+namespace fte::simd {
+
+/// Width of the widest vector register the translation unit is compiled for.
+#if defined(__AVX512F__)
+inline constexpr std::size_t kRegisterBytes = 64;
+#elif defined(__AVX__)
+inline constexpr std::size_t kRegisterBytes = 32;
+#else
+inline constexpr std::size_t kRegisterBytes = 16;
+#endif
+
+template <class T>
+inline constexpr std::size_t native_width = kRegisterBytes / sizeof(T);
+
+/// Fixed-size lane pack.
+///
+/// With GCC and Clang this is a generic vector type, which the compiler maps
+/// onto one or more SSE/AVX2/AVX-512 registers depending on the target; the
+/// fallback is a plain array whose loops the optimizer vectorizes. `N` must
+/// be a power of two.
+template <class T, std::size_t N>
+struct Pack {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Pack width must be a power of two");
+
+#if defined(__GNUC__)
+    typedef T vector_type __attribute__((vector_size(sizeof(T) * N)));
+    vector_type v;
+
+    T operator[](std::size_t i) const noexcept { return v[i]; }
+    void set(std::size_t i, T x) noexcept { v[i] = x; }
+
+    static Pack broadcast(T x) noexcept {
+        Pack p;
+        p.v = x - vector_type{};
+        return p;
+    }
+
+    friend Pack operator+(const Pack& a, const Pack& b) noexcept { return {a.v + b.v}; }
+    friend Pack operator-(const Pack& a, const Pack& b) noexcept { return {a.v - b.v}; }
+    friend Pack operator*(const Pack& a, const Pack& b) noexcept { return {a.v * b.v}; }
+    friend Pack operator/(const Pack& a, const Pack& b) noexcept { return {a.v / b.v}; }
+    friend Pack operator-(const Pack& a) noexcept { return {-a.v}; }
+    friend Pack operator*(const Pack& a, T s) noexcept { return {a.v * s}; }
+    friend Pack operator*(T s, const Pack& a) noexcept { return {s * a.v}; }
+#else
+    T v[N];
+
+    T operator[](std::size_t i) const noexcept { return v[i]; }
+    void set(std::size_t i, T x) noexcept { v[i] = x; }
+
+    static Pack broadcast(T x) noexcept {
+        Pack p;
+        for (std::size_t i = 0; i < N; ++i) p.v[i] = x;
+        return p;
+    }
+
+#define FTE_PACK_BINARY(OP)                                                  \
+    friend Pack operator OP(const Pack& a, const Pack& b) noexcept {         \
+        Pack r;                                                              \
+        for (std::size_t i = 0; i < N; ++i) r.v[i] = a.v[i] OP b.v[i];       \
+        return r;                                                            \
+    }
+    FTE_PACK_BINARY(+)
+    FTE_PACK_BINARY(-)
+    FTE_PACK_BINARY(*)
+    FTE_PACK_BINARY(/)
+#undef FTE_PACK_BINARY
+    friend Pack operator-(const Pack& a) noexcept {
+        Pack r;
+        for (std::size_t i = 0; i < N; ++i) r.v[i] = -a.v[i];
+        return r;
+    }
+    friend Pack operator*(const Pack& a, T s) noexcept { return a * broadcast(s); }
+    friend Pack operator*(T s, const Pack& a) noexcept { return broadcast(s) * a; }
+#endif
+
+    static Pack zero() noexcept { return broadcast(T(0)); }
+
+    static Pack load(const T* p) noexcept {
+        Pack r;
+        for (std::size_t i = 0; i < N; ++i) r.set(i, p[i]);
+        return r;
+    }
+    void store(T* p) const noexcept {
+        for (std::size_t i = 0; i < N; ++i) p[i] = (*this)[i];
+    }
+
+    Pack& operator+=(const Pack& o) noexcept { return *this = *this + o; }
+    Pack& operator-=(const Pack& o) noexcept { return *this = *this - o; }
+    Pack& operator*=(const Pack& o) noexcept { return *this = *this * o; }
+};
+
+}  // namespace fte::simd
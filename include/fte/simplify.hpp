@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "fte/expr.hpp"
+
+namespace fte {
+
+/// Relative evaluation cost of one operation: 1 for add/sub/mul/neg, more for
+/// division, square root and transcendental functions, 0 for leaves.
+double op_cost(Op op) noexcept;
+
+/// Total `op_cost` of the unique nodes reachable from `roots`.
+double dag_cost(std::span<const Node* const> roots);
+
+struct SimplifyOptions {
+    /// Wall-clock budget for equality saturation; extraction runs after it.
+    std::chrono::microseconds time_budget{2000};
+    /// Stop growing the e-graph beyond this many e-nodes.
+    std::size_t node_limit = 20000;
+    std::size_t max_iterations = 12;
+};
+
+struct SimplifyStats {
+    std::size_t iterations = 0;
+    std::size_t enodes = 0;
+    std::size_t eclasses = 0;
+    bool saturated = false;
+    double cost_before = 0.0;
+    double cost_after = 0.0;
+};
+
+/// Equality-saturation simplifier.
+///
+/// The roots are loaded into an e-graph, algebraic rewrites (commutativity,
+/// associativity, factoring, power and exponential laws, identities,
+/// constant folding) are applied until saturation or until the time or node
+/// budget runs out, and the cheapest representative under `op_cost` is
+/// extracted back into `pool`. The result is never more expensive than the
+/// input. Rewrites assume real arithmetic, e.g. `x/x = 1`.
+std::vector<const Node*> simplify(ExprPool& pool, std::span<const Node* const> roots,
+                                  const SimplifyOptions& options = {},
+                                  SimplifyStats* stats = nullptr);
+
+inline const Node* simplify(ExprPool& pool, const Node* root, const SimplifyOptions& options = {},
+                            SimplifyStats* stats = nullptr) {
+    return simplify(pool, std::span<const Node* const>(&root, 1), options, stats)[0];
+}
+
+}  // namespace fte
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "fte/expr.hpp"
+
+namespace fte {
+
+/// Nonzero structure in compressed sparse row form; column indices are
+/// sorted within each row.
+struct SparsityPattern {
+    std::size_t rows = 0;
+    std::size_t cols = 0;
+    std::vector<std::size_t> row_ptr;  ///< `rows + 1` offsets into `col_idx`
+    std::vector<std::uint32_t> col_idx;
+
+    std::size_t nnz() const noexcept { return col_idx.size(); }
+};
+
+/// Sparse matrix in CSR form.
+struct CsrMatrix {
+    std::size_t rows = 0;
+    std::size_t cols = 0;
+    std::vector<std::size_t> row_ptr;
+    std::vector<std::uint32_t> col_idx;
+    std::vector<double> values;
+
+    std::size_t nnz() const noexcept { return values.size(); }
+};
+
+/// Structural Jacobian pattern of `roots` with respect to `num_vars` inputs,
+/// from the variable dependencies of every node in the graph.
+SparsityPattern jacobian_sparsity(std::span<const Node* const> roots, std::uint32_t num_vars);
+
+/// Symmetric Hessian pattern of `f`: `(i, j)` is present when `x_i` and `x_j`
+/// meet in a nonlinear operation. Conservative, never misses a nonzero.
+SparsityPattern hessian_sparsity(const Node* f, std::uint32_t num_vars);
+
+/// Greedy distance-2 coloring of the Jacobian's columns: columns sharing a
+/// color have no row in common, so one compressed sweep per color recovers
+/// the whole Jacobian. Colors are `0 .. max+1`.
+std::vector<std::uint32_t> column_coloring(const SparsityPattern& jacobian);
+
+/// Greedy star coloring of a symmetric pattern (Gebremedhin, Manne and
+/// Pothen): a distance-1 coloring in which every path on four vertices uses
+/// at least three colors, which admits direct recovery of the Hessian.
+std::vector<std::uint32_t> star_coloring(const SparsityPattern& hessian);
+
+/// Sparse Jacobian of a set of expressions.
+///
+/// Pattern and coloring are computed once; each evaluation runs one
+/// vectorized forward sweep per batch of colors and reads the nonzeros
+/// straight out of the compressed result.
+class SparseJacobian {
+public:
+    SparseJacobian(std::span<const Node* const> roots, std::uint32_t num_vars);
+
+    const SparsityPattern& pattern() const noexcept { return pattern_; }
+    std::span<const std::uint32_t> colors() const noexcept { return colors_; }
+    std::uint32_t num_colors() const noexcept { return num_colors_; }
+
+    CsrMatrix operator()(std::span<const double> x) const;
+
+private:
+    std::vector<const Node*> roots_;
+    SparsityPattern pattern_;
+    std::vector<std::uint32_t> colors_;
+    std::uint32_t num_colors_ = 0;
+};
+
+/// Sparse Hessian of a scalar expression.
+///
+/// The gradient is built once by symbolic reverse accumulation; each
+/// evaluation pushes the star-coloring seeds through it in vectorized
+/// forward sweeps (forward over reverse) and recovers every nonzero
+/// directly from the compressed Hessian-matrix product.
+class SparseHessian {
+public:
+    SparseHessian(ExprPool& pool, const Node* f, std::uint32_t num_vars);
+
+    const SparsityPattern& pattern() const noexcept { return pattern_; }
+    std::span<const std::uint32_t> colors() const noexcept { return colors_; }
+    std::uint32_t num_colors() const noexcept { return num_colors_; }
+
+    CsrMatrix operator()(std::span<const double> x) const;
+
+private:
+    std::vector<const Node*> gradient_;
+    SparsityPattern pattern_;
+    std::vector<std::uint32_t> colors_;
+    std::uint32_t num_colors_ = 0;
+};
+
+}  // namespace fte
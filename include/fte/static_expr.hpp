@@ -0,0 +1,324 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "fte/expr.hpp"
+#include "fte/rules.hpp"
+
+/// Compile-time expressions for formulas known when the program is built.
+///
+/// An expression is an empty type such as
+/// `Binary<Op::Mul, Var<0>, Unary<Op::Sin, Var<1>>>`: the formula lives
+/// entirely in the type, so evaluating it is a chain of inline arithmetic
+/// that the compiler folds into the caller's loop, with no parsing, no
+/// pool and no dispatch at run time. Derivatives are computed on the types
+/// by the rules of `rules.hpp` that the runtime `Differentiator` uses too,
+/// with zero terms pruned as they appear:
+///
+///     using namespace fte::static_expr;
+///     constexpr Var<0> x;
+///     constexpr Var<1> y;
+///     constexpr auto f = x * sin(y) + c<3.0> * x * x;
+///     constexpr auto dfdx = derivative<0>(f);  // sin(y) + (3*x + 3*x)
+///     double v = dfdx(1.0, 2.0);
+///
+/// Expressions evaluate over any number type with the usual operators and
+/// ADL elementary functions (`double`, `float`, `Dual<N>`, `Interval`, ...)
+/// and, when only arithmetic is involved, in constant expressions.
+namespace fte::static_expr {
+
+template <double V>
+struct Constant;
+
+struct ExprTag {};
+
+template <class E>
+concept Expr = std::is_base_of_v<ExprTag, E>;
+
+/// Common interface of the expression types `E`.
+template <class E>
+struct Expression : ExprTag {
+    template <double V>
+    static constexpr Constant<V> constant() noexcept {
+        return {};
+    }
+
+    /// Evaluate at `(x_0, x_1, ...)`.
+    template <class... T>
+    constexpr auto operator()(const T&... x) const {
+        const std::array<std::common_type_t<T...>, sizeof...(T)> point{x...};
+        return E::eval(point);
+    }
+
+    /// Evaluate at the point `x`, anything indexable by `x[i]`.
+    template <class X>
+    constexpr auto at(const X& x) const {
+        return E::eval(x);
+    }
+};
+
+template <double V>
+struct Constant : Expression<Constant<V>> {
+    static constexpr double value = V;
+
+    template <class X>
+    static constexpr auto eval(const X& x) {
+        return static_cast<std::remove_cvref_t<decltype(x[0])>>(V);
+    }
+    template <std::size_t I>
+    static constexpr auto derivative() noexcept {
+        return Constant<0.0>{};
+    }
+    static const Node* build(ExprPool& pool) { return pool.constant(V); }
+};
+
+template <std::size_t I>
+struct Var : Expression<Var<I>> {
+    template <class X>
+    static constexpr auto eval(const X& x) {
+        return std::remove_cvref_t<decltype(x[I])>(x[I]);
+    }
+    template <std::size_t J>
+    static constexpr auto derivative() noexcept {
+        return Constant<I == J ? 1.0 : 0.0>{};
+    }
+    static const Node* build(ExprPool& pool) { return pool.variable(static_cast<std::uint32_t>(I)); }
+};
+
+/// The constant `V` as an expression, as in `c<0.5> * x`.
+template <double V>
+inline constexpr Constant<V> c{};
+
+template <class E>
+inline constexpr bool is_constant = false;
+template <double V>
+inline constexpr bool is_constant<Constant<V>> = true;
+
+template <class E, double V>
+inline constexpr bool is_constant_value = false;
+template <double V>
+inline constexpr bool is_constant_value<Constant<V>, V> = true;
+
+template <class E>
+inline constexpr bool is_zero = is_constant_value<E, 0.0>;
+
+/// Folded constants are normalized so that `-0.0` is the zero too.
+constexpr double folded(double v) noexcept { return v == 0.0 ? 0.0 : v; }
+
+template <Op O, class A>
+struct Unary;
+template <Op O, class A, class B>
+struct Binary;
+
+// Constructors with the local identities of `ExprPool`: constants fold and
+// zeros and ones vanish, so derivative types stay small.
+
+template <Expr A>
+constexpr auto operator-(A) noexcept {
+    if constexpr (is_constant<A>)
+        return Constant<folded(-A::value)>{};
+    else
+        return Unary<Op::Neg, A>{};
+}
+
+template <Expr A>
+constexpr auto operator-(Unary<Op::Neg, A>) noexcept {
+    return A{};
+}
+
+template <Expr A, Expr B>
+constexpr auto operator+(A, B) noexcept {
+    if constexpr (is_constant<A> && is_constant<B>)
+        return Constant<folded(A::value + B::value)>{};
+    else if constexpr (is_zero<A>)
+        return B{};
+    else if constexpr (is_zero<B>)
+        return A{};
+    else
+        return Binary<Op::Add, A, B>{};
+}
+
+template <Expr A, Expr B>
+constexpr auto operator-(A a, B b) noexcept {
+    if constexpr (is_constant<A> && is_constant<B>)
+        return Constant<folded(A::value - B::value)>{};
+    else if constexpr (std::is_same_v<A, B>)
+        return Constant<0.0>{};
+    else if constexpr (is_zero<A>)
+        return -b;
+    else if constexpr (is_zero<B>)
+        return a;
+    else
+        return Binary<Op::Sub, A, B>{};
+}
+
+template <Expr A, Expr B>
+constexpr auto operator*(A a, B b) noexcept {
+    if constexpr (is_constant<A> && is_constant<B>)
+        return Constant<folded(A::value * B::value)>{};
+    else if constexpr (is_zero<A> || is_zero<B>)
+        return Constant<0.0>{};
+    else if constexpr (is_constant_value<A, 1.0>)
+        return b;
+    else if constexpr (is_constant_value<B, 1.0>)
+        return a;
+    else if constexpr (is_constant_value<A, -1.0>)
+        return -b;
+    else if constexpr (is_constant_value<B, -1.0>)
+        return -a;
+    else
+        return Binary<Op::Mul, A, B>{};
+}
+
+template <Expr A, Expr B>
+constexpr auto operator/(A a, B) noexcept {
+    if constexpr (is_constant<A> && is_constant<B>) {
+        if constexpr (B::value != 0.0)
+            return Constant<folded(A::value / B::value)>{};
+        else
+            return Binary<Op::Div, A, B>{};
+    } else if constexpr (is_constant_value<B, 1.0>)
+        return a;
+    else if constexpr (is_zero<A>)
+        return Constant<0.0>{};
+    else
+        return Binary<Op::Div, A, B>{};
+}
+
+template <Expr A, Expr B>
+constexpr auto pow(A a, B) noexcept {
+    if constexpr (is_zero<B>)
+        return Constant<1.0>{};
+    else if constexpr (is_constant_value<B, 1.0> || is_constant_value<A, 1.0>)
+        return a;
+    else
+        return Binary<Op::Pow, A, B>{};
+}
+
+template <Expr A> constexpr auto sqrt(A) noexcept { return Unary<Op::Sqrt, A>{}; }
+template <Expr A> constexpr auto exp(A) noexcept { return Unary<Op::Exp, A>{}; }
+template <Expr A> constexpr auto log(A) noexcept { return Unary<Op::Log, A>{}; }
+template <Expr A> constexpr auto sin(A) noexcept { return Unary<Op::Sin, A>{}; }
+template <Expr A> constexpr auto cos(A) noexcept { return Unary<Op::Cos, A>{}; }
+template <Expr A> constexpr auto tan(A) noexcept { return Unary<Op::Tan, A>{}; }
+template <Expr A> constexpr auto tanh(A) noexcept { return Unary<Op::Tanh, A>{}; }
+
+template <Op O, class A>
+struct Unary : Expression<Unary<O, A>> {
+    template <class X>
+    static constexpr auto eval(const X& x) {
+        using std::cos;
+        using std::exp;
+        using std::log;
+        using std::sin;
+        using std::sqrt;
+        using std::tan;
+        using std::tanh;
+        const auto a = A::eval(x);
+        if constexpr (O == Op::Neg) return -a;
+        else if constexpr (O == Op::Sqrt) return sqrt(a);
+        else if constexpr (O == Op::Exp) return exp(a);
+        else if constexpr (O == Op::Log) return log(a);
+        else if constexpr (O == Op::Sin) return sin(a);
+        else if constexpr (O == Op::Cos) return cos(a);
+        else if constexpr (O == Op::Tan) return tan(a);
+        else return tanh(a);
+    }
+
+    template <std::size_t I>
+    static constexpr auto derivative() noexcept {
+        constexpr auto da = A::template derivative<I>();
+        constexpr Unary n{};
+        constexpr A a{};
+        if constexpr (is_zero<std::remove_const_t<decltype(da)>>) return da;
+        else if constexpr (O == Op::Neg) return rules::neg(n, a, da);
+        else if constexpr (O == Op::Sqrt) return rules::sqrt(n, a, da);
+        else if constexpr (O == Op::Exp) return rules::exp(n, a, da);
+        else if constexpr (O == Op::Log) return rules::log(n, a, da);
+        else if constexpr (O == Op::Sin) return rules::sin(n, a, da);
+        else if constexpr (O == Op::Cos) return rules::cos(n, a, da);
+        else if constexpr (O == Op::Tan) return rules::tan(n, a, da);
+        else return rules::tanh(n, a, da);
+    }
+
+    static const Node* build(ExprPool& pool) { return pool.unary(O, A::build(pool)); }
+};
+
+template <Op O, class A, class B>
+struct Binary : Expression<Binary<O, A, B>> {
+    template <class X>
+    static constexpr auto eval(const X& x) {
+        using std::pow;
+        const auto a = A::eval(x);
+        const auto b = B::eval(x);
+        if constexpr (O == Op::Add) return a + b;
+        else if constexpr (O == Op::Sub) return a - b;
+        else if constexpr (O == Op::Mul) return a * b;
+        else if constexpr (O == Op::Div) return a / b;
+        else return pow(a, b);
+    }
+
+    template <std::size_t I>
+    static constexpr auto derivative() noexcept {
+        constexpr auto da = A::template derivative<I>();
+        constexpr auto db = B::template derivative<I>();
+        using DA = std::remove_const_t<decltype(da)>;
+        using DB = std::remove_const_t<decltype(db)>;
+        constexpr Binary n{};
+        constexpr A a{};
+        constexpr B b{};
+        if constexpr (is_zero<DA> && is_zero<DB>) return da;
+        else if constexpr (O == Op::Add) return rules::add(n, a, b, da, db);
+        else if constexpr (O == Op::Sub) return rules::sub(n, a, b, da, db);
+        else if constexpr (O == Op::Mul) return rules::mul(n, a, b, da, db);
+        else if constexpr (O == Op::Div) return rules::div(n, a, b, da, db);
+        else if constexpr (is_constant<B>) return rules::pow_constant_exponent(n, a, b, da);
+        else if constexpr (is_constant<A>) return rules::pow_constant_base(n, a, db);
+        else return rules::pow(n, a, b, da, db);
+    }
+
+    static const Node* build(ExprPool& pool) { return pool.binary(O, A::build(pool), B::build(pool)); }
+};
+
+/// d f / d x_I, as an expression.
+template <std::size_t I, Expr E>
+constexpr auto derivative(E) noexcept {
+    return E::template derivative<I>();
+}
+
+/// All partials `d f / d x_0 .. d f / d x_{N-1}` evaluated together; the
+/// call returns them as a `std::array`.
+template <class... D>
+struct Gradient {
+    template <class... T>
+    constexpr auto operator()(const T&... x) const {
+        const std::array<std::common_type_t<T...>, sizeof...(T)> point{x...};
+        return at(point);
+    }
+
+    template <class X>
+    constexpr auto at(const X& x) const {
+        using R = std::remove_cvref_t<decltype(x[0])>;
+        return std::array<R, sizeof...(D)>{R(D::eval(x))...};
+    }
+};
+
+template <std::size_t N, Expr E>
+constexpr auto gradient(E f) noexcept {
+    return [f]<std::size_t... I>(std::index_sequence<I...>) {
+        return Gradient<decltype(derivative<I>(f))...>{};
+    }(std::make_index_sequence<N>{});
+}
+
+/// The same formula as a node of `pool`, e.g. to hand it to the runtime
+/// machinery. Subterms repeated in the type are hash-consed once.
+template <Expr E>
+const Node* to_node(ExprPool& pool, E) {
+    return E::build(pool);
+}
+
+}  // namespace fte::static_expr
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+#include "fte/program.hpp"
+#include "fte/thread_pool.hpp"
+
+namespace fte {
+
+/// A file mapped into memory, read-only or read-write. Move-only; unmaps and
+/// closes on destruction. Failures throw `std::system_error`.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    static MappedFile open(const std::filesystem::path& path);
+    /// Create or truncate `path` to `size` bytes and map it writable.
+    static MappedFile create(const std::filesystem::path& path, std::size_t size);
+
+    std::byte* data() noexcept { return data_; }
+    const std::byte* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+
+    /// Start reading `[offset, offset + length)` in the background.
+    void prefetch(std::size_t offset, std::size_t length) const noexcept;
+    /// Drop the pages of a range from this process; written data stays in
+    /// the page cache and reaches the file as usual.
+    void release(std::size_t offset, std::size_t length) const noexcept;
+
+private:
+    int fd_ = -1;
+    std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+/// Layout of a columnar binary file: this 64-byte header, then `columns`
+/// contiguous columns of `rows` native-endian doubles each.
+struct ColumnFileHeader {
+    static constexpr char kMagic[8] = {'F', 'T', 'E', 'C', 'O', 'L', '1', '\0'};
+
+    char magic[8];
+    std::uint64_t rows;
+    std::uint64_t columns;
+    std::uint64_t reserved[5];
+};
+static_assert(sizeof(ColumnFileHeader) == 64);
+
+/// Read view of a columnar binary file.
+class ColumnFile {
+public:
+    /// Throws `std::runtime_error` if the file is not a valid column file.
+    explicit ColumnFile(const std::filesystem::path& path);
+
+    std::size_t rows() const noexcept { return rows_; }
+    std::size_t columns() const noexcept { return columns_; }
+    const double* column(std::size_t c) const noexcept;
+    const MappedFile& file() const noexcept { return file_; }
+
+private:
+    MappedFile file_;
+    std::size_t rows_ = 0;
+    std::size_t columns_ = 0;
+};
+
+/// Write `columns` (all of equal length) as a columnar binary file.
+void write_column_file(const std::filesystem::path& path,
+                       std::span<const std::span<const double>> columns);
+
+struct StreamOptions {
+    /// Rows per window of a columnar input; 0 sizes windows to about 32 MiB
+    /// of input and output. Text input is windowed by 32 MiB of text.
+    std::size_t window_rows = 0;
+    /// Points per scheduling chunk; 0 uses `default_chunk`.
+    std::size_t chunk = 0;
+    /// CSV only: field separator and whether the first line is a header.
+    char delimiter = ',';
+    bool header = false;
+};
+
+/// Evaluate `program` over every row of the columnar file `input` and write
+/// its outputs as a columnar file `output`. Returns the number of rows.
+///
+/// Rows are processed window by window: the next window's pages are
+/// requested from the kernel while the pool's workers evaluate the current
+/// one in place, and finished windows are released from the address space
+/// immediately, so resident memory stays at a few windows whatever the size
+/// of the files. Input column `i` feeds program input `i`; extra columns
+/// are ignored.
+std::size_t stream_evaluate(ThreadPool& pool, const Program& program,
+                            const std::filesystem::path& input,
+                            const std::filesystem::path& output,
+                            const StreamOptions& options = {});
+
+/// As `stream_evaluate`, reading rows of a delimited text file. Each window
+/// is cut into line-aligned pieces that the workers count and parse in
+/// parallel into column buffers reused across windows. Every row must hold
+/// exactly one field per program input, and blank lines are skipped; a
+/// malformed field or a row with too few or too many fields throws
+/// `std::runtime_error` with its byte offset.
+std::size_t stream_evaluate_csv(ThreadPool& pool, const Program& program,
+                                const std::filesystem::path& input,
+                                const std::filesystem::path& output,
+                                const StreamOptions& options = {});
+
+}  // namespace fte
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "fte/expr.hpp"
+
+namespace fte {
+
+/// One recorded elementary operation.
+///
+/// The local partials are evaluated while recording, so the backward sweep is
+/// a single multiply-accumulate pass. Operand indices refer to earlier
+/// entries; entry 0 is a sink that absorbs the unused operand of unary ops.
+struct TapeEntry {
+    std::uint32_t arg[2];
+    double partial[2];
+    double value;
+    Op op;
+};
+
+class Real;
+
+/// Reverse-mode (adjoint) recording.
+///
+/// Entries are appended to one contiguous buffer that behaves like an arena:
+/// `clear()` rewinds it without releasing memory, so recording the same
+/// function again performs no allocation. A gradient costs one forward
+/// recording plus one backward sweep over the tape regardless of how many
+/// inputs the function has.
+class Tape {
+public:
+    explicit Tape(std::size_t reserve = 1 << 16);
+
+    Tape(const Tape&) = delete;
+    Tape& operator=(const Tape&) = delete;
+
+    /// Register a new independent variable.
+    Real input(double value);
+
+    std::uint32_t record(Op op, std::uint32_t a, std::uint32_t b, double value, double pa,
+                         double pb) {
+        if (size_ == capacity_)
+            grow();
+        entries_[size_] = TapeEntry{{a, b}, {pa, pb}, value, op};
+        return static_cast<std::uint32_t>(size_++);
+    }
+
+    /// Run the backward sweep seeded with d(output)/d(output) = 1 and return
+    /// the adjoint of every entry.
+    std::span<const double> backward(const Real& output);
+
+    /// Adjoint of each input after `backward`, in registration order.
+    void input_adjoints(std::span<double> out) const;
+
+    std::span<const TapeEntry> entries() const noexcept { return {entries_.get(), size_}; }
+    std::span<const std::uint32_t> inputs() const noexcept { return inputs_; }
+    std::size_t size() const noexcept { return size_; }
+    std::size_t bytes_reserved() const noexcept {
+        return capacity_ * sizeof(TapeEntry) + adjoints_.capacity() * sizeof(double);
+    }
+
+    /// Discard the recording, keeping the buffers.
+    void clear() noexcept;
+
+    /// The tape that `Real` arithmetic on this thread records onto.
+    static Tape& active() {
+        if (!active_)
+            throw std::logic_error("fte::Tape: no active tape on this thread");
+        return *active_;
+    }
+
+    /// Makes a tape active for the lifetime of the scope.
+    class Scope {
+    public:
+        explicit Scope(Tape& t) noexcept : prev_(active_) { active_ = &t; }
+        ~Scope() { active_ = prev_; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Tape* prev_;
+    };
+
+private:
+    void grow();
+
+    std::unique_ptr<TapeEntry[]> entries_;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+    std::vector<std::uint32_t> inputs_;
+    std::vector<double> adjoints_;
+
+    static thread_local Tape* active_;
+};
+
+/// Active scalar for reverse mode. Arithmetic on `Real` values that depend on
+/// an input is recorded on `Tape::active()`; values built from plain doubles
+/// stay passive and cost nothing.
+class Real {
+public:
+    Real(double v = 0.0) noexcept : value_(v), index_(0) {}  // NOLINT: implicit by design
+    Real(double v, std::uint32_t index) noexcept : value_(v), index_(index) {}
+
+    double value() const noexcept { return value_; }
+    std::uint32_t index() const noexcept { return index_; }
+    bool is_active() const noexcept { return index_ != 0; }
+
+    Real& operator+=(const Real& o) { return *this = *this + o; }
+    Real& operator-=(const Real& o) { return *this = *this - o; }
+    Real& operator*=(const Real& o) { return *this = *this * o; }
+    Real& operator/=(const Real& o) { return *this = *this / o; }
+
+    friend Real operator-(const Real& a) { return unary(Op::Neg, a, -a.value_, -1.0); }
+    friend Real operator+(const Real& a, const Real& b) {
+        return binary(Op::Add, a, b, a.value_ + b.value_, 1.0, 1.0);
+    }
+    friend Real operator-(const Real& a, const Real& b) {
+        return binary(Op::Sub, a, b, a.value_ - b.value_, 1.0, -1.0);
+    }
+    friend Real operator*(const Real& a, const Real& b) {
+        return binary(Op::Mul, a, b, a.value_ * b.value_, b.value_, a.value_);
+    }
+    friend Real operator/(const Real& a, const Real& b) {
+        const double q = a.value_ / b.value_;
+        return binary(Op::Div, a, b, q, 1.0 / b.value_, -q / b.value_);
+    }
+
+    friend bool operator==(const Real& a, const Real& b) noexcept { return a.value_ == b.value_; }
+    friend auto operator<=>(const Real& a, const Real& b) noexcept { return a.value_ <=> b.value_; }
+
+    friend Real sqrt(const Real& a) {
+        const double r = std::sqrt(a.value_);
+        return unary(Op::Sqrt, a, r, 0.5 / r);
+    }
+    friend Real exp(const Real& a) {
+        const double e = std::exp(a.value_);
+        return unary(Op::Exp, a, e, e);
+    }
+    friend Real log(const Real& a) { return unary(Op::Log, a, std::log(a.value_), 1.0 / a.value_); }
+    friend Real sin(const Real& a) {
+        return unary(Op::Sin, a, std::sin(a.value_), std::cos(a.value_));
+    }
+    friend Real cos(const Real& a) {
+        return unary(Op::Cos, a, std::cos(a.value_), -std::sin(a.value_));
+    }
+    friend Real tan(const Real& a) {
+        const double t = std::tan(a.value_);
+        return unary(Op::Tan, a, t, 1.0 + t * t);
+    }
+    friend Real tanh(const Real& a) {
+        const double t = std::tanh(a.value_);
+        return unary(Op::Tanh, a, t, 1.0 - t * t);
+    }
+    friend Real pow(const Real& a, const Real& b) {
+        const double p = std::pow(a.value_, b.value_);
+        const double pa = b.value_ == 0.0 ? 0.0 : b.value_ * std::pow(a.value_, b.value_ - 1.0);
+        const double pb = a.value_ > 0.0 ? p * std::log(a.value_) : 0.0;
+        return binary(Op::Pow, a, b, p, pa, pb);
+    }
+
+private:
+    static Real unary(Op op, const Real& a, double v, double pa) {
+        if (!a.is_active())
+            return Real(v);
+        return Real(v, Tape::active().record(op, a.index_, 0, v, pa, 0.0));
+    }
+
+    static Real binary(Op op, const Real& a, const Real& b, double v, double pa, double pb) {
+        if (!a.is_active() && !b.is_active())
+            return Real(v);
+        Tape& t = Tape::active();
+        // Passive operands are recorded as constants so the tape stays
+        // self-describing for replays and higher-order sweeps.
+        const std::uint32_t ia = a.is_active() ? a.index_ : t.record(Op::Const, 0, 0, a.value_, 0.0, 0.0);
+        const std::uint32_t ib = b.is_active() ? b.index_ : t.record(Op::Const, 0, 0, b.value_, 0.0, 0.0);
+        return Real(v, t.record(op, ia, ib, v, pa, pb));
+    }
+
+    double value_;
+    std::uint32_t index_;
+};
+
+/// Gradient of an expression at `x` by recording it on `tape` and sweeping
+/// backward once. Returns f(x) and writes df/dx_i to `grad[i]`.
+double reverse_gradient(Tape& tape, const Node* f, std::span<const double> x,
+                        std::span<double> grad);
+
+/// Gradient of a callable `f(std::span<const Real>) -> Real` at `x`.
+template <class F>
+double reverse_gradient(Tape& tape, F&& f, std::span<const double> x, std::span<double> grad) {
+    tape.clear();
+    Tape::Scope scope(tape);
+    std::vector<Real> xs;
+    xs.reserve(x.size());
+    for (double v : x)
+        xs.push_back(tape.input(v));
+    const Real y = f(std::span<const Real>(xs));
+    tape.backward(y);
+    tape.input_adjoints(grad);
+    return y.value();
+}
+
+}  // namespace fte
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "fte/expr.hpp"
+#include "fte/program.hpp"
+
+namespace fte {
+
+/// Truncated Taylor propagation along a line.
+///
+/// Every slot of a `Program` carries the coefficients `c_0 .. c_degree` of
+/// its value along `x(t) = x0 + t * dir`; each elementary operation maps its
+/// operands' coefficient arrays to the result's with the standard O(d^2)
+/// recurrences, so n-th derivatives never require n-fold symbolic
+/// differentiation. Products stay direct convolutions even at high degree:
+/// an FFT's error is relative to the largest coefficient and swamps the
+/// small high-order ones. The evaluator owns its coefficient storage and
+/// does not allocate per call; it is not thread-safe.
+class TaylorEvaluator {
+public:
+    TaylorEvaluator(const Program& program, std::size_t degree);
+
+    /// `out[r * (degree + 1) + k]` receives the k-th Taylor coefficient of
+    /// output `r`, i.e. `(1/k!) d^k/dt^k f_r(x0 + t dir)` at `t = 0`.
+    void operator()(std::span<const double> x0, std::span<const double> dir,
+                    std::span<double> out);
+
+    std::size_t degree() const noexcept { return degree_; }
+    const Program& program() const noexcept { return program_; }
+
+private:
+    double* slot(std::uint32_t s) noexcept { return coef_.data() + std::size_t{s} * (degree_ + 1); }
+    void apply(const Instr& in);
+
+    const Program& program_;
+    std::size_t degree_;
+    std::vector<double> coef_;     // [slot][k]
+    std::vector<double> result_;   // result of the current instruction
+    std::vector<double> aux_[2];   // companion series (cos for sin, 1+c^2 for tan, ...)
+};
+
+/// `f^(k)(x)` for `k = 0 .. degree`, differentiating with respect to `x_var`
+/// while the other variables stay at their values in `x`.
+std::vector<double> higher_derivatives(const Node* f, std::uint32_t var,
+                                       std::span<const double> x, std::size_t degree);
+
+}  // namespace fte
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fte {
+
+/// Fixed-size work-stealing thread pool.
+///
+/// Each worker owns a deque: it pops its own tasks from the back and, when
+/// idle, steals from the front of the other workers' deques. Work submitted
+/// from inside a task stays local to that worker until someone steals it,
+/// and a worker waiting on a nested job keeps executing tasks instead of
+/// blocking.
+class ThreadPool {
+public:
+    /// `num_threads == 0` uses `std::thread::hardware_concurrency()`.
+    explicit ThreadPool(unsigned num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const noexcept { return static_cast<unsigned>(workers_.size()); }
+
+    /// Index of the calling thread among this pool's workers, or `size()` if
+    /// the caller is not one of them.
+    unsigned worker_index() const noexcept;
+
+    /// Calls `body(begin, end)` on disjoint ranges of at most `grain`
+    /// iterations covering `[0, n)` and blocks until all have finished. The
+    /// first exception thrown by a range is rethrown here.
+    template <class F>
+    void parallel_for(std::size_t n, std::size_t grain, F&& body) {
+        using Body = std::remove_reference_t<F>;
+        if (n == 0)
+            return;
+        grain = grain == 0 ? 1 : grain;
+        run_chunks(n, grain,
+                   [](void* ctx, std::size_t b, std::size_t e) { (*static_cast<Body*>(ctx))(b, e); },
+                   const_cast<void*>(static_cast<const void*>(&body)));
+    }
+
+    /// Process-wide pool sized to the machine.
+    static ThreadPool& global();
+
+private:
+    struct Job;
+    struct Task {
+        void (*run)(void*, std::size_t, std::size_t);
+        void* ctx;
+        std::size_t begin;
+        std::size_t end;
+        Job* job;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run_chunks(std::size_t n, std::size_t grain, void (*run)(void*, std::size_t, std::size_t),
+                    void* ctx);
+    bool try_run_one(unsigned self);
+    void execute(const Task& t);
+    void worker_loop(unsigned index);
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<unsigned> next_queue_{0};
+    bool stop_ = false;
+};
+
+}  // namespace fte
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fte/expr.hpp"
+#include "fte/jit.hpp"
+#include "fte/program.hpp"
+#include "fte/vm.hpp"
+
+namespace fte {
+
+enum class Tier : std::uint8_t {
+    Interpreted,  ///< running on the bytecode interpreter
+    Compiling,    ///< interpreted while native code is being built
+    Compiled,     ///< running native code
+};
+
+struct TieredOptions {
+    /// Promote after this many calls; 0 disables the trigger.
+    std::uint64_t call_threshold = 10'000;
+    /// Promote after this many evaluated points; 0 disables the trigger.
+    std::uint64_t point_threshold = 1'000'000;
+    /// Compile on a background thread while calls keep being interpreted.
+    /// When false, the call that crosses a threshold compiles before
+    /// returning.
+    bool background = true;
+    BytecodeOptions bytecode;
+    JitOptions jit;
+};
+
+/// A set of expressions that starts on the bytecode interpreter and moves
+/// to a compiled kernel once it proves hot.
+///
+/// While interpreted, each call bumps a call counter and a point counter.
+/// The call that first crosses a threshold starts the compiler, on its own
+/// thread by default, and evaluation stays interpreted until the kernel is
+/// loaded and published with one atomic store; the next call picks it up.
+/// A formula evaluated a handful of times thus costs one linearization and
+/// never waits on or pays for the compiler, while a hot one pays a single
+/// acquire load per call once promoted: counting stops at promotion. If
+/// compilation fails the function stays interpreted and `error()` says why.
+///
+/// Evaluation is thread-safe. The roots' pool must outlive the function;
+/// destruction waits for a compilation in flight.
+class TieredFunction {
+public:
+    TieredFunction(std::span<const Node* const> roots, std::uint32_t num_inputs,
+                   const TieredOptions& options = {});
+    ~TieredFunction();
+
+    TieredFunction(const TieredFunction&) = delete;
+    TieredFunction& operator=(const TieredFunction&) = delete;
+
+    /// Evaluate at one point: `x` holds `num_inputs()` values, `out`
+    /// receives `num_outputs()`.
+    void operator()(std::span<const double> x, std::span<double> out) const;
+    /// Evaluate `n` points in structure-of-arrays layout, as `BatchEvaluator`.
+    void batch(std::span<const double* const> inputs, std::span<double* const> outputs,
+               std::size_t n) const;
+
+    /// Start compiling now, whatever the counters say. Does nothing once
+    /// compilation has been started.
+    void promote() const;
+    /// Block until a started compilation has finished.
+    void wait() const;
+
+    Tier tier() const noexcept;
+    /// Calls and points evaluated on the interpreter before promotion.
+    std::uint64_t calls() const noexcept { return calls_.load(std::memory_order_relaxed); }
+    std::uint64_t points() const noexcept { return points_.load(std::memory_order_relaxed); }
+    /// Wall time of the compilation, once compiled.
+    double compile_seconds() const noexcept;
+    /// Compiler diagnostics when promotion failed, empty otherwise.
+    std::string error() const;
+
+    std::uint32_t num_inputs() const noexcept { return program_.num_inputs(); }
+    std::size_t num_outputs() const noexcept { return program_.num_outputs(); }
+    const Program& program() const noexcept { return program_; }
+    const Bytecode& bytecode() const noexcept { return bytecode_; }
+
+private:
+    enum State : std::uint8_t { Idle, Building, Ready, Failed };
+
+    void count(std::size_t n) const;
+    void compile() const;
+
+    std::vector<const Node*> roots_;
+    TieredOptions options_;
+    Program program_;
+    Bytecode bytecode_;
+
+    mutable std::atomic<std::uint64_t> calls_{0};
+    mutable std::atomic<std::uint64_t> points_{0};
+    mutable std::atomic<std::uint8_t> state_{Idle};
+    mutable std::atomic<const CompiledKernel*> kernel_{nullptr};
+
+    // Written by the compiling thread before `state_` leaves `Building`.
+    mutable std::unique_ptr<CompiledKernel> compiled_;
+    mutable double compile_seconds_ = 0.0;
+    mutable std::string error_;
+    mutable std::mutex thread_mutex_;
+    mutable std::thread compiler_;
+};
+
+}  // namespace fte
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "fte/program.hpp"
+
+namespace fte {
+
+/// Operations of the bytecode: the program's own plus superinstructions
+/// that fuse common pairs.
+enum class VmOp : std::uint8_t {
+    Halt,
+    Neg, Sqrt, Exp, Log, Sin, Cos, Tan, Tanh,
+    Add, Sub, Mul, Div, Pow,
+    MulAdd,     ///< `d = a * b + c`
+    MulSub,     ///< `d = a * b - c`
+    NegMulAdd,  ///< `d = c - a * b`
+    SinCos,     ///< `d = sin(a)`, `e = cos(a)`
+};
+
+struct BytecodeOptions {
+    /// Fuse multiply-add pairs and sines and cosines of the same argument.
+    bool superinstructions = true;
+};
+
+/// A `Program` as compact register bytecode for a threaded interpreter.
+///
+/// Registers are the program's slots. Each instruction is an opcode word
+/// followed by its register operands, with 16-bit words when the registers
+/// fit and 32-bit words otherwise, and the interpreter dispatches with
+/// computed gotos where the compiler supports them. Translating a program
+/// is a single pass with no compiler involved, so a freshly differentiated
+/// expression runs at interpreter speed from its first evaluation.
+///
+/// Superinstructions replace a multiplication whose only use is the
+/// following addition or subtraction by a fused multiply-add, and pair a
+/// sine and a cosine of the same value. Where the target has FMA the fused
+/// form rounds once, so results can differ from `Program::eval` in the last
+/// bit; without superinstructions they are bitwise identical.
+class Bytecode {
+public:
+    Bytecode() = default;
+    explicit Bytecode(const Program& program, const BytecodeOptions& options = {});
+
+    std::uint32_t num_inputs() const noexcept { return num_inputs_; }
+    std::uint32_t num_registers() const noexcept { return num_registers_; }
+    std::size_t num_outputs() const noexcept { return outputs_.size(); }
+    /// Instructions executed per evaluation, superinstructions counting once.
+    std::size_t num_instructions() const noexcept { return num_instructions_; }
+    /// Program instructions folded into superinstructions.
+    std::size_t num_fused() const noexcept { return num_fused_; }
+    std::size_t code_bytes() const noexcept {
+        return code16_.size() * sizeof(std::uint16_t) + code32_.size() * sizeof(std::uint32_t);
+    }
+
+    /// Evaluate at one point. `registers` is scratch of at least
+    /// `num_registers()` entries, so repeated calls need not allocate.
+    void eval(std::span<const double> x, std::span<double> out,
+              std::span<double> registers) const;
+    void eval(std::span<const double> x, std::span<double> out) const;
+
+private:
+    std::uint32_t num_inputs_ = 0;
+    std::uint32_t num_registers_ = 0;
+    std::size_t num_instructions_ = 0;
+    std::size_t num_fused_ = 0;
+    std::vector<double> constants_;
+    std::vector<std::uint32_t> outputs_;
+    std::vector<std::uint16_t> code16_;  // one of the two is used
+    std::vector<std::uint32_t> code32_;
+};
+
+}  // namespace fte
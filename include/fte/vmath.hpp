@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+
+namespace fte::vmath {
+
+/// Elementary functions over arrays, written as branch-free loops that the
+/// compiler vectorizes for the target (`FTE_NATIVE_ARCH`).
+///
+/// The algorithms are fdlibm's: Cody-Waite range reduction and the same
+/// polynomials, with branches turned into selects. `exp` keeps the error of
+/// its last addition but one, and the trigonometric reduction splits pi/2
+/// into three parts, so results near multiples of pi/2 stay accurate. The
+/// largest errors against a binary128 reference, over 2 * 10^7 random
+/// arguments per routine plus the doubles nearest to multiples of ln2 / 2
+/// and of pi/2, are
+///
+///     exp      0.79 ulp   over the whole range, subnormal results included
+///     log      0.76 ulp   over all positive doubles
+///     sin/cos  0.79 ulp   for |x| < 2^20; larger arguments go to libm
+///
+/// so all results are within 0.8 ulp, against libm's 0.52. Special values
+/// (NaN, infinities, signed zeros, negative logarithms) follow C99 Annex F.
+/// Without AVX2, `exp` and `log` call libm, which is then faster. Outputs
+/// may alias their input.
+
+void exp(std::size_t n, const double* x, double* y) noexcept;
+void log(std::size_t n, const double* x, double* y) noexcept;
+void sin(std::size_t n, const double* x, double* y) noexcept;
+void cos(std::size_t n, const double* x, double* y) noexcept;
+
+/// `s = sin(x)` and `c = cos(x)` with one range reduction.
+void sincos(std::size_t n, const double* x, double* s, double* c) noexcept;
+
+/// `hi = x^p` and `lo = x^(p - 1)` for `p >= 1`, the pair a power rule
+/// derivative needs, with one `pow` call: `hi` is `lo * x`, within 1 ulp of
+/// `pow(x, p)`. Zero and infinite bases and results that are not normal
+/// take a second `pow`, so there `hi` is exactly `pow(x, p)`.
+void pow_pair(std::size_t n, const double* x, double p, double* hi, double* lo) noexcept;
+
+/// Single precision versions, for `MixedPrecisionEvaluator`: Cephes'
+/// polynomials in float lanes, twice as many per vector as above, with
+/// sine and cosine reduced in double. Largest errors against double libm
+/// over 10^7 random arguments per routine, plus the floats nearest to
+/// multiples of pi/2:
+///
+///     exp      1.01 ulp   subnormal results included
+///     log      0.79 ulp
+///     sin/cos  1.56 ulp   for |x| < 2^20; larger arguments go to libm
+///     tanh     1.32 ulp
+///
+/// Special values are handled as in the double routines.
+void exp(std::size_t n, const float* x, float* y) noexcept;
+void log(std::size_t n, const float* x, float* y) noexcept;
+void sin(std::size_t n, const float* x, float* y) noexcept;
+void cos(std::size_t n, const float* x, float* y) noexcept;
+void sincos(std::size_t n, const float* x, float* s, float* c) noexcept;
+void tanh(std::size_t n, const float* x, float* y) noexcept;
+
+}  // namespace fte::vmath
@@ -0,0 +1,52 @@
+#include "fte/arena.hpp"
+
+#include <algorithm>
+
+namespace fte {
+
+Arena::Arena(std::size_t block_size) : block_size_(block_size) {}
+
+void* Arena::allocate_slow(std::size_t size, std::size_t align) {
+    // Move on to the next retained block that can hold the request, or grow.
+    if (!blocks_.empty())
+        used_before_current_ += static_cast<std::size_t>(ptr_ - blocks_[current_].data.get());
+    std::size_t next = blocks_.empty() ? 0 : current_ + 1;
+    while (next < blocks_.size() && blocks_[next].size < size + align) {
+        ++next;
+    }
+    if (next >= blocks_.size()) {
+        std::size_t bytes = std::max(block_size_, size + align);
+        blocks_.push_back({std::make_unique<std::byte[]>(bytes), bytes});
+        next = blocks_.size() - 1;
+    }
+    current_ = next;
+    ptr_ = blocks_[current_].data.get();
+    end_ = ptr_ + blocks_[current_].size;
+    return allocate(size, align);
+}
+
+void Arena::reset() noexcept {
+    current_ = 0;
+    used_before_current_ = 0;
+    if (blocks_.empty()) {
+        ptr_ = end_ = nullptr;
+        return;
+    }
+    ptr_ = blocks_[0].data.get();
+    end_ = ptr_ + blocks_[0].size;
+}
+
+std::size_t Arena::bytes_used() const noexcept {
+    if (blocks_.empty())
+        return 0;
+    return used_before_current_ + static_cast<std::size_t>(ptr_ - blocks_[current_].data.get());
+}
+
+std::size_t Arena::bytes_reserved() const noexcept {
+    std::size_t total = 0;
+    for (const auto& b : blocks_)
+        total += b.size;
+    return total;
+}
+
+}  // namespace fte
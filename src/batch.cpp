@@ -0,0 +1,243 @@
+#include "fte/batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "fte/profile.hpp"
+#include "fte/vmath.hpp"
+
+namespace fte {
+
+namespace {
+
+void kernel(Op op, double* d, const double* a, const double* b, std::size_t len,
+            bool vector_math) {
+    switch (op) {
+        case Op::Neg: for (std::size_t j = 0; j < len; ++j) d[j] = -a[j]; break;
+        case Op::Add: for (std::size_t j = 0; j < len; ++j) d[j] = a[j] + b[j]; break;
+        case Op::Sub: for (std::size_t j = 0; j < len; ++j) d[j] = a[j] - b[j]; break;
+        case Op::Mul: for (std::size_t j = 0; j < len; ++j) d[j] = a[j] * b[j]; break;
+        case Op::Div: for (std::size_t j = 0; j < len; ++j) d[j] = a[j] / b[j]; break;
+        case Op::Sqrt: for (std::size_t j = 0; j < len; ++j) d[j] = std::sqrt(a[j]); break;
+        case Op::Exp:
+            if (vector_math)
+                vmath::exp(len, a, d);
+            else
+                for (std::size_t j = 0; j < len; ++j) d[j] = std::exp(a[j]);
+            break;
+        case Op::Log:
+            if (vector_math)
+                vmath::log(len, a, d);
+            else
+                for (std::size_t j = 0; j < len; ++j) d[j] = std::log(a[j]);
+            break;
+        case Op::Sin:
+            if (vector_math)
+                vmath::sin(len, a, d);
+            else
+                for (std::size_t j = 0; j < len; ++j) d[j] = std::sin(a[j]);
+            break;
+        case Op::Cos:
+            if (vector_math)
+                vmath::cos(len, a, d);
+            else
+                for (std::size_t j = 0; j < len; ++j) d[j] = std::cos(a[j]);
+            break;
+        case Op::Tan: for (std::size_t j = 0; j < len; ++j) d[j] = std::tan(a[j]); break;
+        case Op::Tanh: for (std::size_t j = 0; j < len; ++j) d[j] = std::tanh(a[j]); break;
+        case Op::Pow: for (std::size_t j = 0; j < len; ++j) d[j] = std::pow(a[j], b[j]); break;
+        case Op::Const:
+        case Op::Var: break;
+    }
+}
+
+bool reads(const Instr& in, std::uint32_t slot) noexcept {
+    return in.a == slot || (arity(in.op) == 2 && in.b == slot);
+}
+
+/// How far ahead an instruction looks for the other half of a pair.
+constexpr std::size_t kPairWindow = 64;
+
+/// The first instruction after `i`, within the window, that `accept` takes
+/// and whose result can be computed early, at `i`, from the same operand;
+/// 0 if there is none. `direct` tells whether the later result's slot is
+/// left alone in between, so that it can be written early too.
+template <class Accept>
+std::size_t partner(std::span<const Instr> code, std::size_t i, Accept accept, bool& direct) {
+    const std::uint32_t x = code[i].a;
+    if (code[i].dst == x)
+        return 0;
+    std::size_t match = 0;
+    for (std::size_t j = i + 1; j < std::min(code.size(), i + kPairWindow); ++j) {
+        if (code[j].a == x && accept(j)) {
+            match = j;
+            break;
+        }
+        if (code[j].dst == x)
+            return 0;
+    }
+    if (match == 0)
+        return 0;
+    const std::uint32_t late = code[match].dst;
+    direct = late != x && late != code[i].dst;
+    for (std::size_t j = i + 1; direct && j < match; ++j)
+        direct = code[j].dst != late && !reads(code[j], late);
+    return match;
+}
+
+constexpr std::size_t kAlignDoubles = 8;  // 64 bytes
+
+}  // namespace
+
+BatchEvaluator::BatchEvaluator(const Program& program, std::size_t tile, bool vector_math)
+    : program_(program),
+      tile_(std::max<std::size_t>(kAlignDoubles,
+                                  (tile + kAlignDoubles - 1) / kAlignDoubles * kAlignDoubles)),
+      vector_math_(vector_math) {
+    const std::uint32_t base = program_.const_base();
+    const std::uint32_t slots = program_.num_slots();
+    const auto constants = program_.constants();
+    const std::uint32_t spares = plan(base, constants);
+
+    const std::size_t rows = slots + spares - base;
+    scratch_ = std::make_unique<double[]>(rows * tile_ + kAlignDoubles);
+    auto addr = reinterpret_cast<std::uintptr_t>(scratch_.get());
+    double* aligned = scratch_.get() + ((64 - addr % 64) % 64) / sizeof(double);
+
+    slot_ptr_.resize(slots + spares, nullptr);
+    for (std::size_t r = 0; r < rows; ++r)
+        slot_ptr_[base + r] = aligned + r * tile_;
+    // Constants never change, so their rows are filled once.
+    for (std::size_t c = 0; c < constants.size(); ++c)
+        std::fill_n(slot_ptr_[base + c], tile_, constants[c]);
+
+    src_.assign(slot_ptr_.begin(), slot_ptr_.end());
+}
+
+std::uint32_t BatchEvaluator::plan(std::uint32_t base, std::span<const double> constants) {
+    const auto code = program_.code();
+    steps_.reserve(code.size());
+    std::vector<bool> absorbed(code.size(), false);
+    auto constant = [&](std::uint32_t slot, double& value) {
+        if (slot < base || slot - base >= constants.size())
+            return false;
+        value = constants[slot - base];
+        return true;
+    };
+
+    // A pair whose later result cannot go to its own slot early parks it in
+    // a spare row until that instruction's turn. Spares are recycled once
+    // their copy has run.
+    std::uint32_t spares = 0;
+    std::vector<std::uint32_t> free_spares;
+    std::vector<std::pair<std::size_t, Step>> parked;  // copy due at instruction
+
+    for (std::size_t i = 0; i < code.size(); ++i) {
+        for (auto it = parked.begin(); it != parked.end();) {
+            if (it->first == i) {
+                steps_.push_back(it->second);
+                free_spares.push_back(it->second.a);
+                it = parked.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (absorbed[i])
+            continue;
+        const Instr& in = code[i];
+        std::size_t j = 0;
+        bool direct = false;
+        double p = 0.0, q = 0.0;
+        if (vector_math_ && (in.op == Op::Sin || in.op == Op::Cos)) {
+            const Op other = in.op == Op::Sin ? Op::Cos : Op::Sin;
+            j = partner(
+                code, i, [&](std::size_t k) { return !absorbed[k] && code[k].op == other; },
+                direct);
+        } else if (vector_math_ && in.op == Op::Pow && constant(in.b, p)) {
+            // x^p and x^(p-1), as the power rule leaves them.
+            j = partner(
+                code, i,
+                [&](std::size_t k) {
+                    return !absorbed[k] && code[k].op == Op::Pow && constant(code[k].b, q) &&
+                           ((q == p - 1.0 && p >= 1.0) || (q == p + 1.0 && q >= 1.0));
+                },
+                direct);
+        }
+        if (j == 0) {
+            steps_.push_back({Kind::Single, in.op, in.dst, in.a, in.b, 0});
+            continue;
+        }
+        absorbed[j] = true;
+        ++num_fused_;
+
+        std::uint32_t late = code[j].dst;
+        if (!direct) {
+            std::uint32_t spare;
+            if (free_spares.empty()) {
+                spare = program_.num_slots() + spares++;
+            } else {
+                spare = free_spares.back();
+                free_spares.pop_back();
+            }
+            parked.push_back({j, {Kind::Copy, Op::Const, late, spare, 0, 0}});
+            late = spare;
+        }
+        if (in.op == Op::Pow) {
+            const bool hi_first = q < p;
+            steps_.push_back({Kind::PowPair, Op::Pow, hi_first ? in.dst : late, in.a,
+                              hi_first ? in.b : code[j].b, hi_first ? late : in.dst});
+        } else {
+            const bool sin_first = in.op == Op::Sin;
+            steps_.push_back({Kind::SinCos, Op::Sin, sin_first ? in.dst : late, in.a, 0,
+                              sin_first ? late : in.dst});
+        }
+    }
+    return spares;
+}
+
+void BatchEvaluator::run_tile(std::size_t len) {
+    for (const Step& s : steps_) {
+        switch (s.kind) {
+            case Kind::Single:
+                kernel(s.op, slot_ptr_[s.dst], src_[s.a], src_[s.b], len, vector_math_);
+                break;
+            case Kind::SinCos:
+                vmath::sincos(len, src_[s.a], slot_ptr_[s.dst], slot_ptr_[s.second]);
+                break;
+            case Kind::PowPair:
+                vmath::pow_pair(len, src_[s.a], src_[s.b][0], slot_ptr_[s.dst], slot_ptr_[s.second]);
+                break;
+            case Kind::Copy: std::copy_n(src_[s.a], len, slot_ptr_[s.dst]); break;
+        }
+    }
+}
+
+void BatchEvaluator::operator()(std::span<const double* const> inputs,
+                                std::span<double* const> outputs, std::size_t n) {
+    FTE_PROFILE_SCOPE(Evaluate);
+    FTE_PROFILE_COUNT(EvaluatedPoints, n);
+    if (inputs.size() < program_.num_inputs() || outputs.size() < program_.num_outputs())
+        throw std::invalid_argument("BatchEvaluator: too few input or output columns");
+    const auto out_slots = program_.outputs();
+    for (std::size_t p0 = 0; p0 < n; p0 += tile_) {
+        const std::size_t len = std::min(tile_, n - p0);
+        // Inputs are read in place, never copied into the scratch.
+        for (std::uint32_t i = 0; i < program_.num_inputs(); ++i)
+            src_[i] = inputs[i] + p0;
+        run_tile(len);
+        for (std::size_t r = 0; r < out_slots.size(); ++r)
+            std::copy_n(src_[out_slots[r]], len, outputs[r] + p0);
+    }
+}
+
+void evaluate_batch(const Program& program, std::span<const double* const> inputs,
+                    std::span<double* const> outputs, std::size_t n) {
+    BatchEvaluator eval(program);
+    eval(inputs, outputs, n);
+}
+
+}  // namespace fte
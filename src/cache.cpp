@@ -0,0 +1,282 @@
+#include "fte/cache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+#include "fte/derivative.hpp"
+#include "fte/hash.hpp"
+#include "fte/profile.hpp"
+
+namespace fte {
+
+namespace {
+
+constexpr std::uint32_t kUnnumbered = ~std::uint32_t{0};
+
+/// Hash of a node from its children's hashes, commutative operands sorted.
+std::uint64_t combine(Op op, std::uint64_t a, std::uint64_t b) {
+    if (is_commutative(op) && a > b)
+        std::swap(a, b);
+    std::uint64_t h = mix64(static_cast<std::uint64_t>(op) + 0x9e3779b97f4a7c15ULL);
+    h = hash_combine(h, a);
+    return arity(op) == 2 ? hash_combine(h, b) : h;
+}
+
+std::uint64_t leaf_hash(const Node* n, std::uint64_t var_label) {
+    const std::uint64_t h = mix64(static_cast<std::uint64_t>(n->op) + 0x9e3779b97f4a7c15ULL);
+    return n->op == Op::Const ? hash_combine(h, std::bit_cast<std::uint64_t>(n->value))
+                              : hash_combine(h, var_label);
+}
+
+}  // namespace
+
+CanonicalForm canonical_form(const Node* f) {
+    const std::vector<const Node*> order = topo_order(f);
+    std::uint32_t max_id = 0;
+    for (const Node* n : order)
+        max_id = std::max(max_id, n->id);
+    std::vector<std::uint32_t> index(std::size_t{max_id} + 1);
+    for (std::uint32_t i = 0; i < order.size(); ++i)
+        index[order[i]->id] = i;
+    auto at = [&](const Node* n) { return index[n->id]; };
+
+    // Shape: the hash with every variable labelled alike.
+    std::vector<std::uint64_t> h(order.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        const Node* n = order[i];
+        switch (arity(n->op)) {
+            case 0: h[i] = leaf_hash(n, 0); break;
+            case 1: h[i] = combine(n->op, h[at(n->arg[0])], 0); break;
+            default: h[i] = combine(n->op, h[at(n->arg[0])], h[at(n->arg[1])]); break;
+        }
+    }
+
+    // Number variables by first occurrence in a preorder walk that visits
+    // commutative operands in shape order.
+    CanonicalForm form;
+    std::vector<std::uint32_t> label;  // by variable index
+    std::vector<std::uint8_t> seen(order.size(), 0);
+    std::vector<const Node*> stack{f};
+    while (!stack.empty()) {
+        const Node* n = stack.back();
+        stack.pop_back();
+        if (seen[at(n)])
+            continue;
+        seen[at(n)] = 1;
+        if (n->op == Op::Var) {
+            if (n->var >= label.size())
+                label.resize(std::size_t{n->var} + 1, kUnnumbered);
+            label[n->var] = static_cast<std::uint32_t>(form.variables.size());
+            form.variables.push_back(n->var);
+        } else if (arity(n->op) == 1) {
+            stack.push_back(n->arg[0]);
+        } else if (arity(n->op) == 2) {
+            const Node* first = n->arg[0];
+            const Node* second = n->arg[1];
+            if (is_commutative(n->op) && h[at(second)] < h[at(first)])
+                std::swap(first, second);
+            stack.push_back(second);
+            stack.push_back(first);
+        }
+    }
+
+    // The canonical hash proper, variables labelled by their numbering.
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        const Node* n = order[i];
+        switch (arity(n->op)) {
+            case 0: h[i] = leaf_hash(n, n->op == Op::Var ? label[n->var] + 1 : 0); break;
+            case 1: h[i] = combine(n->op, h[at(n->arg[0])], 0); break;
+            default: h[i] = combine(n->op, h[at(n->arg[0])], h[at(n->arg[1])]); break;
+        }
+    }
+    form.hash = h[at(f)];
+
+    // Serialize the DAG in postorder, commutative operands in hash order and
+    // shared nodes referenced by their position.
+    std::vector<std::uint32_t> position(order.size(), kUnnumbered);
+    std::uint32_t next = 0;
+    auto operands = [&](const Node* n) {
+        const Node* first = n->arg[0];
+        const Node* second = n->arg[1];
+        if (is_commutative(n->op) && h[at(second)] < h[at(first)])
+            std::swap(first, second);
+        return std::pair{first, second};
+    };
+    std::vector<std::pair<const Node*, bool>> work{{f, false}};
+    while (!work.empty()) {
+        auto [n, expanded] = work.back();
+        work.pop_back();
+        if (position[at(n)] != kUnnumbered)
+            continue;
+        if (!expanded && arity(n->op) != 0) {
+            work.emplace_back(n, true);
+            if (arity(n->op) == 1) {
+                work.emplace_back(n->arg[0], false);
+            } else {
+                const auto [first, second] = operands(n);
+                work.emplace_back(second, false);
+                work.emplace_back(first, false);
+            }
+            continue;
+        }
+        position[at(n)] = next++;
+        form.structure.push_back(static_cast<std::uint64_t>(n->op));
+        switch (arity(n->op)) {
+            case 0:
+                form.structure.push_back(n->op == Op::Const ? std::bit_cast<std::uint64_t>(n->value)
+                                                            : label[n->var]);
+                break;
+            case 1: form.structure.push_back(position[at(n->arg[0])]); break;
+            default: {
+                const auto [first, second] = operands(n);
+                form.structure.push_back(position[at(first)]);
+                form.structure.push_back(position[at(second)]);
+                break;
+            }
+        }
+    }
+    return form;
+}
+
+GradientEntry::GradientEntry(const Node* f, const CanonicalForm& form, const JitOptions& jit)
+    : key_(form.hash), structure_(form.structure), pool_(16 * 1024), jit_(jit) {
+    const auto n = static_cast<std::uint32_t>(form.variables.size());
+    std::vector<std::uint32_t> label;
+    for (std::uint32_t k = 0; k < n; ++k) {
+        if (form.variables[k] >= label.size())
+            label.resize(std::size_t{form.variables[k]} + 1, kUnnumbered);
+        label[form.variables[k]] = k;
+    }
+
+    // Copy `f` into the entry's own pool under the canonical numbering.
+    std::unordered_map<const Node*, const Node*> copy;
+    for (const Node* m : topo_order(f)) {
+        const Node* c;
+        switch (m->op) {
+            case Op::Const: c = pool_.constant(m->value); break;
+            case Op::Var: c = pool_.variable(label[m->var]); break;
+            default:
+                c = pool_.make(m->op, copy.at(m->arg[0]),
+                               m->arg[1] ? copy.at(m->arg[1]) : nullptr);
+                break;
+        }
+        copy.emplace(m, c);
+    }
+    function_ = copy.at(f);
+    gradient_ = adjoint_gradient(pool_, function_, n);
+
+    std::vector<const Node*> roots;
+    roots.reserve(n + 1);
+    roots.push_back(function_);
+    roots.insert(roots.end(), gradient_.begin(), gradient_.end());
+    program_ = linearize(roots, n);
+    bytes_ = sizeof(*this) + structure_.size() * sizeof(std::uint64_t) + pool_.bytes_used() +
+             gradient_.size() * sizeof(const Node*) +
+             program_.code().size() * sizeof(Instr) +
+             program_.constants().size() * sizeof(double) +
+             program_.outputs().size() * sizeof(std::uint32_t);
+}
+
+const CompiledKernel& GradientEntry::kernel() const {
+    std::call_once(kernel_once_, [this] {
+        std::vector<const Node*> roots{function_};
+        roots.insert(roots.end(), gradient_.begin(), gradient_.end());
+        kernel_ = CompiledKernel::compile(roots, jit_);
+    });
+    return kernel_;
+}
+
+double CachedGradient::evaluate(std::span<const double> x, std::span<double> grad) const {
+    const std::size_t n = variables.size();
+    std::vector<double> xc(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        if (variables[k] >= x.size() || variables[k] >= grad.size())
+            throw std::invalid_argument("CachedGradient::evaluate: span too small");
+        xc[k] = x[variables[k]];
+    }
+    std::vector<double> out(n + 1);
+    entry->program().eval(xc, out);
+    for (std::size_t k = 0; k < n; ++k)
+        grad[variables[k]] = out[k + 1];
+    return out[0];
+}
+
+std::vector<std::string> CachedGradient::names(std::span<const std::string> caller_names) const {
+    std::vector<std::string> out;
+    out.reserve(variables.size());
+    for (std::uint32_t v : variables) {
+        if (v < caller_names.size()) {
+            out.push_back(caller_names[v]);
+        } else {
+            out.emplace_back(1, 'x');
+            out.back() += std::to_string(v);
+        }
+    }
+    return out;
+}
+
+DerivativeCache::DerivativeCache(DerivativeCacheOptions options) : options_(std::move(options)) {}
+
+CachedGradient DerivativeCache::gradient(const Node* f) {
+    FTE_PROFILE_SCOPE(CacheLookup);
+    CanonicalForm form = canonical_form(f);
+    {
+        std::lock_guard lock(mutex_);
+        if (auto it = map_.find(form.hash);
+            it != map_.end() && std::ranges::equal(it->second.entry->structure(), form.structure)) {
+            ++stats_.hits;
+            FTE_PROFILE_COUNT(CacheHits, 1);
+            lru_.splice(lru_.begin(), lru_, it->second.position);
+            return {it->second.entry, std::move(form.variables), true};
+        }
+        ++stats_.misses;
+        FTE_PROFILE_COUNT(CacheMisses, 1);
+    }
+
+    auto entry = std::make_shared<const GradientEntry>(f, form, options_.jit);
+
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] = map_.try_emplace(form.hash);
+    if (inserted) {
+        lru_.push_front(form.hash);
+        it->second = {std::move(entry), lru_.begin()};
+        ++stats_.entries;
+        stats_.bytes += it->second.entry->bytes();
+        evict_locked();
+    } else if (!std::ranges::equal(it->second.entry->structure(), form.structure)) {
+        // Another formula holds this hash; keep it and hand out ours uncached.
+        return {std::move(entry), std::move(form.variables), false};
+    }
+    return {it->second.entry, std::move(form.variables), false};
+}
+
+void DerivativeCache::evict_locked() {
+    // The entry just inserted sits at the front and is never evicted.
+    while (lru_.size() > 1 &&
+           (stats_.entries > options_.max_entries || stats_.bytes > options_.max_bytes)) {
+        auto it = map_.find(lru_.back());
+        stats_.bytes -= it->second.entry->bytes();
+        --stats_.entries;
+        ++stats_.evictions;
+        FTE_PROFILE_COUNT(CacheEvictions, 1);
+        map_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+DerivativeCacheStats DerivativeCache::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+void DerivativeCache::clear() {
+    std::lock_guard lock(mutex_);
+    map_.clear();
+    lru_.clear();
+    stats_.entries = 0;
+    stats_.bytes = 0;
+}
+
+}  // namespace fte
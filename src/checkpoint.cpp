@@ -0,0 +1,221 @@
+#include "fte/checkpoint.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace fte {
+
+namespace {
+
+constexpr std::size_t kSaturated = std::numeric_limits<std::size_t>::max();
+
+/// beta(s, t) = C(s + t, t), the most steps that `s` snapshots can reverse
+/// with `t` forward sweeps; saturates instead of overflowing.
+std::size_t beta(std::size_t s, std::size_t t) {
+    std::size_t r = 1;
+    for (std::size_t k = 1; k <= t; ++k) {
+        if (r > kSaturated / (s + k))
+            return kSaturated;
+        r = r * (s + k) / k;
+    }
+    return r;
+}
+
+/// Where to place the next snapshot within a segment of `l >= 2` steps
+/// reversed with `s >= 2` snapshots: the left part must be reversible with
+/// `s` snapshots and `t - 1` sweeps, the right part with `s - 1` and `t`.
+std::size_t split(std::size_t l, std::size_t s) {
+    const std::size_t t = binomial_repetitions(l, s);
+    const std::size_t right = beta(s - 1, t);
+    return l > right ? l - right : 1;
+}
+
+class Checkpointer {
+public:
+    Checkpointer(Tape& tape, const StepFunction& step, const ObjectiveFunction& objective,
+                 std::size_t num_steps, std::span<const double> params, std::size_t n,
+                 std::size_t snapshots)
+        : tape_(tape),
+          step_(step),
+          objective_(objective),
+          num_steps_(num_steps),
+          n_(n),
+          params_(params),
+          snapshots_(snapshots * n),
+          work_(n),
+          adj_state_(n),
+          adj_params_(params.size(), 0.0),
+          input_adj_(n + params.size()),
+          cur_(n),
+          next_(n),
+          passive_params_(params.begin(), params.end()),
+          active_(n + params.size()) {
+        stats_.snapshots = snapshots;
+    }
+
+    double run(std::span<const double> x0, std::size_t snapshots) {
+        std::copy(x0.begin(), x0.end(), snapshots_.begin());
+        if (num_steps_ == 0)
+            record(snapshot(0), 0, false);
+        else
+            reverse(0, num_steps_, snapshots, 0);
+        return value_;
+    }
+
+    std::span<const double> adj_state() const noexcept { return adj_state_; }
+    std::span<const double> adj_params() const noexcept { return adj_params_; }
+    const CheckpointStats& stats() const noexcept { return stats_; }
+
+private:
+    double* snapshot(std::size_t slot) { return snapshots_.data() + slot * n_; }
+
+    /// Recompute `state` from step `from` to step `to` without recording.
+    void advance(double* state, std::size_t from, std::size_t to) {
+        for (std::size_t k = 0; k < n_; ++k)
+            cur_[k] = Real(state[k]);
+        for (std::size_t i = from; i < to; ++i) {
+            step_(i, cur_, passive_params_, next_);
+            std::swap(cur_, next_);
+        }
+        for (std::size_t k = 0; k < n_; ++k)
+            state[k] = cur_[k].value();
+        stats_.advanced_steps += to - from;
+    }
+
+    /// Tape step `i` from `state` (or only the objective when `with_step` is
+    /// false), sweep it backward seeded with the adjoint of its result, and
+    /// leave the adjoint of `state` in `adj_state_`.
+    void record(const double* state, std::size_t i, bool with_step) {
+        tape_.clear();
+        Tape::Scope scope(tape_);
+        for (std::size_t k = 0; k < n_; ++k)
+            active_[k] = tape_.input(state[k]);
+        for (std::size_t k = 0; k < params_.size(); ++k)
+            active_[n_ + k] = tape_.input(params_[k]);
+        const auto xs = std::span<const Real>(active_).first(n_);
+        const auto ps = std::span<const Real>(active_).subspan(n_);
+
+        Real y;
+        if (!with_step) {
+            y = objective_(xs, ps);
+            value_ = y.value();
+        } else {
+            step_(i, xs, ps, next_);
+            if (i + 1 == num_steps_) {
+                // The last step and the objective share one recording.
+                y = objective_(next_, ps);
+                value_ = y.value();
+            } else {
+                // Seed the step's outputs through <adj, next>.
+                for (std::size_t k = 0; k < n_; ++k)
+                    if (adj_state_[k] != 0.0)
+                        y += adj_state_[k] * next_[k];
+            }
+            ++stats_.recorded_steps;
+        }
+        stats_.peak_tape_entries = std::max(stats_.peak_tape_entries, tape_.size());
+
+        tape_.backward(y);
+        tape_.input_adjoints(input_adj_);
+        std::copy_n(input_adj_.begin(), n_, adj_state_.begin());
+        for (std::size_t k = 0; k < params_.size(); ++k)
+            adj_params_[k] += input_adj_[n_ + k];
+    }
+
+    /// Reverse steps `[begin, end)` given the adjoint of state `end`, with
+    /// state `begin` held in snapshot `slot` and `s` snapshots from `slot`
+    /// on at our disposal. Pending segments live on `pending_` rather than
+    /// the call stack, whose depth would otherwise grow with the steps.
+    void reverse(std::size_t begin, std::size_t end, std::size_t s, std::size_t slot) {
+        pending_.push_back({begin, end, s, slot});
+        while (!pending_.empty()) {
+            const Segment g = pending_.back();
+            pending_.pop_back();
+            const std::size_t l = g.end - g.begin;
+            if (l == 1) {
+                record(snapshot(g.slot), g.begin, true);
+            } else if (g.s == 1) {
+                for (std::size_t i = g.end; i-- > g.begin;) {
+                    std::copy_n(snapshot(g.slot), n_, work_.begin());
+                    advance(work_.data(), g.begin, i);
+                    record(work_.data(), i, true);
+                }
+            } else if (g.s >= l) {
+                // Enough room for every state: store them all, then sweep back.
+                for (std::size_t k = 1; k < l; ++k) {
+                    std::copy_n(snapshot(g.slot + k - 1), n_, snapshot(g.slot + k));
+                    advance(snapshot(g.slot + k), g.begin + k - 1, g.begin + k);
+                }
+                for (std::size_t k = l; k-- > 0;)
+                    record(snapshot(g.slot + k), g.begin + k, true);
+            } else {
+                // The right part goes on top, so it is reversed first.
+                const std::size_t m = g.begin + split(l, g.s);
+                std::copy_n(snapshot(g.slot), n_, snapshot(g.slot + 1));
+                advance(snapshot(g.slot + 1), g.begin, m);
+                pending_.push_back({g.begin, m, g.s, g.slot});
+                pending_.push_back({m, g.end, g.s - 1, g.slot + 1});
+            }
+        }
+    }
+
+    struct Segment {
+        std::size_t begin, end, s, slot;
+    };
+
+    Tape& tape_;
+    const StepFunction& step_;
+    const ObjectiveFunction& objective_;
+    std::size_t num_steps_;
+    std::size_t n_;
+    std::span<const double> params_;
+    std::vector<double> snapshots_;  // [slot][k]
+    std::vector<double> work_;
+    std::vector<double> adj_state_;
+    std::vector<double> adj_params_;
+    std::vector<double> input_adj_;
+    std::vector<Real> cur_, next_;
+    std::vector<Real> passive_params_;
+    std::vector<Real> active_;
+    std::vector<Segment> pending_;
+    double value_ = 0.0;
+    CheckpointStats stats_;
+};
+
+}  // namespace
+
+std::size_t binomial_repetitions(std::size_t num_steps, std::size_t snapshots) {
+    if (snapshots == 0)
+        throw std::invalid_argument("binomial_repetitions: need at least one snapshot");
+    std::size_t t = 0;
+    while (beta(snapshots, t) < num_steps)
+        ++t;
+    return t;
+}
+
+double checkpointed_gradient(Tape& tape, const StepFunction& step,
+                             const ObjectiveFunction& objective, std::size_t num_steps,
+                             std::span<const double> x0, std::span<const double> params,
+                             std::span<double> grad_x0, std::span<double> grad_params,
+                             const CheckpointOptions& options, CheckpointStats* stats) {
+    const std::size_t n = x0.size();
+    if (grad_x0.size() < n || grad_params.size() < params.size())
+        throw std::invalid_argument("checkpointed_gradient: gradient span too small");
+
+    std::size_t snapshots = options.max_snapshots;
+    if (snapshots == 0)
+        snapshots = n ? options.memory_budget / (n * sizeof(double)) : num_steps + 1;
+    snapshots = std::clamp<std::size_t>(snapshots, 1, num_steps + 1);
+
+    Checkpointer c(tape, step, objective, num_steps, params, n, snapshots);
+    const double value = c.run(x0, snapshots);
+    std::copy(c.adj_state().begin(), c.adj_state().end(), grad_x0.begin());
+    std::copy(c.adj_params().begin(), c.adj_params().end(), grad_params.begin());
+    if (stats)
+        *stats = c.stats();
+    return value;
+}
+
+}  // namespace fte
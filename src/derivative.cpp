@@ -0,0 +1,207 @@
+#include "fte/derivative.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "fte/profile.hpp"
+#include "fte/rules.hpp"
+
+namespace fte {
+
+namespace {
+
+/// A node together with its pool, so that the shared rules can build the
+/// DAG through ordinary operators.
+struct NodeRef {
+    ExprPool* pool;
+    const Node* node;
+
+    template <double V>
+    NodeRef constant() const {
+        return {pool, pool->constant(V)};
+    }
+
+    friend NodeRef operator-(NodeRef a) { return {a.pool, a.pool->neg(a.node)}; }
+    friend NodeRef operator+(NodeRef a, NodeRef b) { return {a.pool, a.pool->add(a.node, b.node)}; }
+    friend NodeRef operator-(NodeRef a, NodeRef b) { return {a.pool, a.pool->sub(a.node, b.node)}; }
+    friend NodeRef operator*(NodeRef a, NodeRef b) { return {a.pool, a.pool->mul(a.node, b.node)}; }
+    friend NodeRef operator/(NodeRef a, NodeRef b) { return {a.pool, a.pool->div(a.node, b.node)}; }
+    friend NodeRef sin(NodeRef a) { return {a.pool, a.pool->sin(a.node)}; }
+    friend NodeRef cos(NodeRef a) { return {a.pool, a.pool->cos(a.node)}; }
+    friend NodeRef log(NodeRef a) { return {a.pool, a.pool->log(a.node)}; }
+    friend NodeRef pow(NodeRef a, NodeRef b) { return {a.pool, a.pool->pow(a.node, b.node)}; }
+};
+
+}  // namespace
+
+const Node* Differentiator::rule(const Node* n, const Node* da, const Node* db) {
+    const NodeRef N{&pool_, n};
+    const NodeRef A{&pool_, n->arg[0]};
+    const NodeRef B{&pool_, n->arg[1]};
+    const NodeRef dA{&pool_, da};
+    const NodeRef dB{&pool_, db};
+    switch (n->op) {
+        case Op::Neg: return rules::neg(N, A, dA).node;
+        case Op::Add: return rules::add(N, A, B, dA, dB).node;
+        case Op::Sub: return rules::sub(N, A, B, dA, dB).node;
+        case Op::Mul: return rules::mul(N, A, B, dA, dB).node;
+        case Op::Div: return rules::div(N, A, B, dA, dB).node;
+        case Op::Sqrt: return rules::sqrt(N, A, dA).node;
+        case Op::Exp: return rules::exp(N, A, dA).node;
+        case Op::Log: return rules::log(N, A, dA).node;
+        case Op::Sin: return rules::sin(N, A, dA).node;
+        case Op::Cos: return rules::cos(N, A, dA).node;
+        case Op::Tan: return rules::tan(N, A, dA).node;
+        case Op::Tanh: return rules::tanh(N, A, dA).node;
+        case Op::Pow:
+            if (B.node->is_const())
+                return rules::pow_constant_exponent(N, A, B, dA).node;
+            if (A.node->is_const())
+                return rules::pow_constant_base(N, A, dB).node;
+            return rules::pow(N, A, B, dA, dB).node;
+        case Op::Const:
+        case Op::Var: break;
+    }
+    return pool_.constant(0.0);
+}
+
+const Node* Differentiator::operator()(const Node* f, std::uint32_t var) {
+    FTE_PROFILE_SCOPE(Differentiate);
+    if (var >= memo_.size())
+        memo_.resize(var + 1);
+    std::vector<const Node*>& memo = memo_[var];
+    auto known = [&](const Node* n) { return n->id < memo.size() && memo[n->id]; };
+    if (known(f)) {
+        ++stats_.reused;
+        return memo[f->id];
+    }
+
+    // Walk only the part of `f` not yet differentiated for `var`: memoized
+    // subterms end the walk, so after an edit of a formula whose derivative
+    // was taken before, the work is proportional to the new nodes.
+    if (++epoch_ == 0) {
+        std::fill(visit_.begin(), visit_.end(), 0);
+        epoch_ = 1;
+    }
+    if (visit_.size() < pool_.size())
+        visit_.resize(std::max(pool_.size(), 2 * visit_.size()), 0);
+    auto enter = [&](const Node* n) {
+        if (visit_[n->id] == epoch_)
+            return false;
+        visit_[n->id] = epoch_;
+        if (known(n)) {
+            ++stats_.reused;
+            return false;
+        }
+        return true;
+    };
+    order_.clear();
+    enter(f);
+    stack_.emplace_back(f, 0);
+    while (!stack_.empty()) {
+        auto& [n, next] = stack_.back();
+        if (next < arity(n->op)) {
+            const Node* child = n->arg[next++];
+            if (enter(child))
+                stack_.emplace_back(child, 0);
+        } else {
+            order_.push_back(n);
+            stack_.pop_back();
+        }
+    }
+    stats_.computed += order_.size();
+
+    if (memo.size() < pool_.size())
+        memo.resize(pool_.size(), nullptr);
+    const Node* zero = pool_.constant(0.0);
+    const Node* one = pool_.constant(1.0);
+    for (const Node* n : order_) {
+        const Node* d;
+        switch (n->op) {
+            case Op::Const: d = zero; break;
+            case Op::Var: d = n->var == var ? one : zero; break;
+            default: {
+                const Node* da = memo[n->arg[0]->id];
+                const Node* db = n->arg[1] ? memo[n->arg[1]->id] : zero;
+                // Subterms that do not depend on `var` need no rule at all.
+                d = (da == zero && db == zero) ? zero : rule(n, da, db);
+                break;
+            }
+        }
+        // `rule` may have grown the pool; `memo` is indexed by the old ids only.
+        memo[n->id] = d;
+    }
+    return memo[f->id];
+}
+
+const Node* differentiate(ExprPool& pool, const Node* f, std::uint32_t var) {
+    return Differentiator(pool)(f, var);
+}
+
+std::vector<const Node*> gradient(ExprPool& pool, const Node* f, std::uint32_t num_vars) {
+    Differentiator d(pool);
+    std::vector<const Node*> g;
+    g.reserve(num_vars);
+    for (std::uint32_t v = 0; v < num_vars; ++v)
+        g.push_back(d(f, v));
+    return g;
+}
+
+std::vector<const Node*> adjoint_gradient(ExprPool& pool, const Node* f, std::uint32_t num_vars) {
+    FTE_PROFILE_SCOPE(Differentiate);
+    ExprPool& p = pool;
+    const Node* zero = p.constant(0.0);
+    const std::vector<const Node*> order = topo_order(f);
+    std::unordered_map<const Node*, const Node*> adj;
+    adj.reserve(order.size());
+    adj[f] = p.constant(1.0);
+    auto accumulate = [&](const Node* n, const Node* contribution) {
+        auto [it, inserted] = adj.try_emplace(n, contribution);
+        if (!inserted)
+            it->second = p.add(it->second, contribution);
+    };
+
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        const Node* n = *it;
+        auto found = adj.find(n);
+        if (found == adj.end() || found->second == zero || arity(n->op) == 0)
+            continue;
+        const Node* A = found->second;
+        const Node* a = n->arg[0];
+        const Node* b = n->arg[1];
+        switch (n->op) {
+            case Op::Neg: accumulate(a, p.neg(A)); break;
+            case Op::Add: accumulate(a, A); accumulate(b, A); break;
+            case Op::Sub: accumulate(a, A); accumulate(b, p.neg(A)); break;
+            case Op::Mul: accumulate(a, p.mul(A, b)); accumulate(b, p.mul(A, a)); break;
+            case Op::Div:
+                accumulate(a, p.div(A, b));
+                accumulate(b, p.neg(p.div(p.mul(A, n), b)));
+                break;
+            case Op::Sqrt: accumulate(a, p.div(A, p.mul(p.constant(2.0), n))); break;
+            case Op::Exp: accumulate(a, p.mul(A, n)); break;
+            case Op::Log: accumulate(a, p.div(A, a)); break;
+            case Op::Sin: accumulate(a, p.mul(A, p.cos(a))); break;
+            case Op::Cos: accumulate(a, p.neg(p.mul(A, p.sin(a)))); break;
+            case Op::Tan: accumulate(a, p.mul(A, p.add(p.constant(1.0), p.mul(n, n)))); break;
+            case Op::Tanh: accumulate(a, p.mul(A, p.sub(p.constant(1.0), p.mul(n, n)))); break;
+            case Op::Pow:
+                if (!a->is_const())
+                    accumulate(a, p.mul(A, p.mul(b, p.pow(a, p.sub(b, p.constant(1.0))))));
+                if (!b->is_const())
+                    accumulate(b, p.mul(A, p.mul(n, p.log(a))));
+                break;
+            case Op::Const:
+            case Op::Var: break;
+        }
+    }
+
+    std::vector<const Node*> g(num_vars, zero);
+    for (const Node* n : order)
+        if (n->op == Op::Var && n->var < num_vars)
+            if (auto it = adj.find(n); it != adj.end())
+                g[n->var] = it->second;
+    return g;
+}
+
+}  // namespace fte
@@ -0,0 +1,243 @@
+#include "fte/expr.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "fte/eval.hpp"
+#include "fte/hash.hpp"
+
+namespace fte {
+
+namespace {
+
+std::uint64_t node_hash(Op op, double value, std::uint32_t var, const Node* a,
+                        const Node* b) noexcept {
+    std::uint64_t h = mix64(static_cast<std::uint64_t>(op) + 0x9e3779b97f4a7c15ULL);
+    switch (op) {
+        case Op::Const: h = mix64(h ^ std::bit_cast<std::uint64_t>(value)); break;
+        case Op::Var: h = mix64(h ^ (static_cast<std::uint64_t>(var) + 1)); break;
+        default:
+            h = mix64(h ^ a->hash);
+            if (b)
+                h = mix64(h + b->hash * 0x9e3779b97f4a7c15ULL);
+            break;
+    }
+    return h;
+}
+
+bool same(const Node* n, Op op, double value, std::uint32_t var, const Node* a,
+          const Node* b) noexcept {
+    if (n->op != op)
+        return false;
+    switch (op) {
+        case Op::Const:
+            return std::bit_cast<std::uint64_t>(n->value) == std::bit_cast<std::uint64_t>(value);
+        case Op::Var: return n->var == var;
+        default: return n->arg[0] == a && n->arg[1] == b;
+    }
+}
+
+}  // namespace
+
+const char* op_name(Op op) noexcept {
+    switch (op) {
+        case Op::Const: return "const";
+        case Op::Var: return "var";
+        case Op::Neg: return "neg";
+        case Op::Sqrt: return "sqrt";
+        case Op::Exp: return "exp";
+        case Op::Log: return "log";
+        case Op::Sin: return "sin";
+        case Op::Cos: return "cos";
+        case Op::Tan: return "tan";
+        case Op::Tanh: return "tanh";
+        case Op::Add: return "add";
+        case Op::Sub: return "sub";
+        case Op::Mul: return "mul";
+        case Op::Div: return "div";
+        case Op::Pow: return "pow";
+    }
+    return "?";
+}
+
+ExprPool::ExprPool(std::size_t arena_block_size) : arena_(arena_block_size) {
+    table_.assign(1024, nullptr);
+}
+
+const Node* ExprPool::intern(Op op, double value, std::uint32_t var, const Node* a,
+                             const Node* b) {
+    const std::uint64_t h = node_hash(op, value, var, a, b);
+    std::size_t mask = table_.size() - 1;
+    for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+        const Node* n = table_[i];
+        if (!n)
+            break;
+        if (n->hash == h && same(n, op, value, var, a, b))
+            return n;
+    }
+
+    if (2 * (nodes_.size() + 1) > table_.size()) {
+        grow_table();
+        mask = table_.size() - 1;
+    }
+    Node* n = arena_.make<Node>();
+    n->op = op;
+    n->id = static_cast<std::uint32_t>(nodes_.size());
+    n->hash = h;
+    n->value = value;
+    n->var = var;
+    n->arg[0] = a;
+    n->arg[1] = b;
+    nodes_.push_back(n);
+
+    std::size_t i = h & mask;
+    while (table_[i])
+        i = (i + 1) & mask;
+    table_[i] = n;
+    return n;
+}
+
+void ExprPool::grow_table() {
+    std::vector<const Node*> bigger(table_.size() * 2, nullptr);
+    const std::size_t mask = bigger.size() - 1;
+    for (const Node* n : nodes_) {
+        std::size_t i = n->hash & mask;
+        while (bigger[i])
+            i = (i + 1) & mask;
+        bigger[i] = n;
+    }
+    table_ = std::move(bigger);
+}
+
+const Node* ExprPool::constant(double v) { return intern(Op::Const, v, 0, nullptr, nullptr); }
+
+const Node* ExprPool::variable(std::uint32_t index) {
+    if (index >= num_vars_)
+        num_vars_ = index + 1;
+    return intern(Op::Var, 0.0, index, nullptr, nullptr);
+}
+
+const Node* ExprPool::unary(Op op, const Node* a) {
+    if (arity(op) != 1 || !a)
+        throw std::invalid_argument("ExprPool::unary: bad operation or operand");
+    if (a->is_const())
+        return constant(apply_op(op, a->value, 0.0));
+    if (op == Op::Neg && a->op == Op::Neg)
+        return a->arg[0];
+    if (op == Op::Log && a->op == Op::Exp)
+        return a->arg[0];
+    return intern(op, 0.0, 0, a, nullptr);
+}
+
+const Node* ExprPool::binary(Op op, const Node* a, const Node* b) {
+    if (arity(op) != 2 || !a || !b)
+        throw std::invalid_argument("ExprPool::binary: bad operation or operands");
+    if (a->is_const() && b->is_const())
+        return constant(apply_op(op, a->value, b->value));
+
+    switch (op) {
+        case Op::Add:
+            if (a->is_const(0.0)) return b;
+            if (b->is_const(0.0)) return a;
+            if (b->op == Op::Neg) return sub(a, b->arg[0]);
+            if (a->op == Op::Neg) return sub(b, a->arg[0]);
+            break;
+        case Op::Sub:
+            if (b->is_const(0.0)) return a;
+            if (a->is_const(0.0)) return neg(b);
+            if (a == b) return constant(0.0);
+            if (b->op == Op::Neg) return add(a, b->arg[0]);
+            break;
+        case Op::Mul:
+            if (a->is_const(0.0) || b->is_const(0.0)) return constant(0.0);
+            if (a->is_const(1.0)) return b;
+            if (b->is_const(1.0)) return a;
+            if (a->is_const(-1.0)) return neg(b);
+            if (b->is_const(-1.0)) return neg(a);
+            if (a->op == Op::Neg && b->op == Op::Neg) return mul(a->arg[0], b->arg[0]);
+            if (a->op == Op::Neg) return neg(mul(a->arg[0], b));
+            if (b->op == Op::Neg) return neg(mul(a, b->arg[0]));
+            break;
+        case Op::Div:
+            if (b->is_const(1.0)) return a;
+            if (a->is_const(0.0)) return constant(0.0);
+            if (a == b) return constant(1.0);
+            if (a->op == Op::Neg) return neg(div(a->arg[0], b));
+            break;
+        case Op::Pow:
+            if (b->is_const(0.0)) return constant(1.0);
+            if (b->is_const(1.0)) return a;
+            if (a->is_const(1.0)) return a;
+            break;
+        default: break;
+    }
+
+    // Canonical operand order: constants first, then by structural hash, so
+    // that `a+b` and `b+a` intern to the same node in every pool.
+    if (is_commutative(op)) {
+        const bool swap = b->is_const() ? !a->is_const() || a->hash > b->hash
+                                        : !a->is_const() && a->hash > b->hash;
+        if (swap)
+            std::swap(a, b);
+    }
+    return intern(op, 0.0, 0, a, b);
+}
+
+const Node* ExprPool::make(Op op, const Node* a, const Node* b) {
+    switch (arity(op)) {
+        case 1: return unary(op, a);
+        case 2: return binary(op, a, b);
+        default: throw std::invalid_argument("ExprPool::make: leaf operation");
+    }
+}
+
+std::size_t ExprPool::bytes_used() const noexcept {
+    return arena_.bytes_used() + nodes_.capacity() * sizeof(const Node*) +
+           table_.capacity() * sizeof(const Node*);
+}
+
+void ExprPool::clear() {
+    arena_.reset();
+    nodes_.clear();
+    table_.assign(1024, nullptr);
+    num_vars_ = 0;
+}
+
+std::vector<const Node*> topo_order(std::span<const Node* const> roots) {
+    std::vector<const Node*> order;
+    std::vector<std::uint8_t> seen;
+    std::vector<std::pair<const Node*, int>> stack;
+    auto mark = [&](const Node* n) {
+        if (n->id >= seen.size())
+            seen.resize(std::max<std::size_t>(n->id + 1, seen.size() * 2), 0);
+        if (seen[n->id])
+            return false;
+        seen[n->id] = 1;
+        return true;
+    };
+
+    for (const Node* root : roots) {
+        if (!root || !mark(root))
+            continue;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            auto& [n, next] = stack.back();
+            if (next < arity(n->op)) {
+                const Node* child = n->arg[next++];
+                if (mark(child))
+                    stack.emplace_back(child, 0);
+            } else {
+                order.push_back(n);
+                stack.pop_back();
+            }
+        }
+    }
+    return order;
+}
+
+std::size_t dag_size(std::span<const Node* const> roots) { return topo_order(roots).size(); }
+
+}  // namespace fte
@@ -0,0 +1,150 @@
+#include "fte/hvp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "fte/eval.hpp"
+#include "fte/profile.hpp"
+
+namespace fte {
+
+namespace {
+
+struct Second {
+    double aa, ab, bb;
+};
+
+/// Second partials of one operation with respect to its operands, with the
+/// conventions of `Real`: `pow` has no `b` dependence for `a <= 0` and no
+/// `a` partial for `b == 0`.
+Second second(Op op, double a, double b, double value) {
+    switch (op) {
+        case Op::Mul: return {0.0, 1.0, 0.0};
+        case Op::Div: {
+            const double r = 1.0 / b;
+            return {0.0, -r * r, 2.0 * value * r * r};
+        }
+        case Op::Sqrt: return {-0.25 / (value * value * value), 0.0, 0.0};
+        case Op::Exp: return {value, 0.0, 0.0};
+        case Op::Log: return {-1.0 / (a * a), 0.0, 0.0};
+        case Op::Sin:
+        case Op::Cos: return {-value, 0.0, 0.0};
+        case Op::Tan: return {2.0 * value * (1.0 + value * value), 0.0, 0.0};
+        case Op::Tanh: return {-2.0 * value * (1.0 - value * value), 0.0, 0.0};
+        case Op::Pow: {
+            const double aa = b == 0.0 || b == 1.0 ? 0.0 : b * (b - 1.0) * std::pow(a, b - 2.0);
+            if (!(a > 0.0))
+                return {aa, 0.0, 0.0};
+            const double l = std::log(a);
+            return {aa, std::pow(a, b - 1.0) * (1.0 + b * l), value * l * l};
+        }
+        case Op::Neg:
+        case Op::Add:
+        case Op::Sub:
+        case Op::Const:
+        case Op::Var: break;
+    }
+    return {0.0, 0.0, 0.0};
+}
+
+}  // namespace
+
+HvpEvaluator::HvpEvaluator(Tape& tape, const Real& output)
+    : num_inputs_(tape.inputs().size()),
+      output_(output.is_active() ? output.index() : 0),
+      value_(output.value()),
+      gradient_(num_inputs_),
+      inputs_(tape.inputs().begin(), tape.inputs().end()) {
+    const auto entries = tape.entries();
+    if (output_ >= entries.size())
+        throw std::invalid_argument("HvpEvaluator: output not recorded on this tape");
+    const auto adjoints = tape.backward(output);
+    tape.input_adjoints(gradient_);
+
+    const std::size_t size = std::size_t(output_) + 1;
+    local_.resize(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        const TapeEntry& e = entries[i];
+        const Second h = second(e.op, entries[e.arg[0]].value, entries[e.arg[1]].value, e.value);
+        local_[i] = {e.arg[0], e.arg[1], e.partial[0], e.partial[1], h.aa, h.ab, h.bb, adjoints[i]};
+    }
+    const auto seed_row = static_cast<std::uint32_t>(size);
+    for (std::size_t k = 0; k < num_inputs_; ++k) {
+        if (inputs_[k] >= size)
+            continue;  // recorded after the output, so it cannot affect it
+        Local& in = local_[inputs_[k]];
+        in.a = seed_row + static_cast<std::uint32_t>(k);
+        in.pa = 1.0;
+    }
+    tangent_.resize(size + num_inputs_);
+    adjoint_tangent_.resize(size + num_inputs_);
+}
+
+void HvpEvaluator::operator()(std::span<const double> v, std::size_t k, std::span<double> hv) {
+    const std::size_t n = num_inputs_;
+    if (v.size() < k * n || hv.size() < k * n)
+        throw std::invalid_argument("HvpEvaluator: span too small");
+    for (std::size_t j = 0; j < k; j += kWidth)
+        batch(v.data() + j * n, std::min(kWidth, k - j), hv.data() + j * n);
+}
+
+void HvpEvaluator::batch(const double* v, std::size_t lanes, double* hv) {
+    FTE_PROFILE_SCOPE(Evaluate);
+    FTE_PROFILE_COUNT(EvaluatedPoints, lanes);
+    const std::size_t n = num_inputs_;
+    const std::size_t size = local_.size();
+    if (output_ == 0) {
+        std::fill_n(hv, lanes * n, 0.0);
+        return;
+    }
+
+    // Directions go in the seed rows; unused lanes stay zero.
+    Lanes* t = tangent_.data();
+    for (std::size_t i = 0; i < n; ++i) {
+        Lanes s = Lanes::zero();
+        for (std::size_t j = 0; j < lanes; ++j)
+            s.set(j, v[j * n + i]);
+        t[size + i] = s;
+    }
+
+    // Forward: tangents of every entry along all directions at once.
+    const Local* l = local_.data();
+    t[0] = Lanes::zero();
+    for (std::size_t i = 1; i < size; ++i)
+        t[i] = l[i].pa * t[l[i].a] + l[i].pb * t[l[i].b];
+
+    // Reverse: tangents of the adjoints. The adjoints themselves do not
+    // depend on the direction and come from the one backward sweep.
+    Lanes* at = adjoint_tangent_.data();
+    std::fill(adjoint_tangent_.begin(), adjoint_tangent_.end(), Lanes::zero());
+    for (std::size_t i = size - 1; i > 0; --i) {
+        const Local& e = l[i];
+        const Lanes d = at[i];
+        const Lanes ta = t[e.a], tb = t[e.b];
+        at[e.a] += e.pa * d + e.adjoint * (e.haa * ta + e.hab * tb);
+        at[e.b] += e.pb * d + e.adjoint * (e.hab * ta + e.hbb * tb);
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        const Lanes h = inputs_[i] < size ? at[inputs_[i]] : Lanes::zero();
+        for (std::size_t j = 0; j < lanes; ++j)
+            hv[j * n + i] = h[j];
+    }
+}
+
+double hessian_vector_products(Tape& tape, const Node* f, std::span<const double> x,
+                               std::span<const double> v, std::size_t k, std::span<double> hv) {
+    tape.clear();
+    Tape::Scope scope(tape);
+    std::vector<Real> xs;
+    xs.reserve(x.size());
+    for (double xi : x)
+        xs.push_back(tape.input(xi));
+    const Real y = evaluate<Real>(std::span<const Node* const>(&f, 1), std::span<const Real>(xs))[0];
+    HvpEvaluator eval(tape, y);
+    eval(v, k, hv);
+    return y.value();
+}
+
+}  // namespace fte
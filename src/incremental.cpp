@@ -0,0 +1,43 @@
+#include "fte/incremental.hpp"
+
+#include <algorithm>
+
+namespace fte {
+
+IncrementalGradient::IncrementalGradient(std::size_t arena_block_size)
+    : pool_(arena_block_size), differentiator_(pool_) {}
+
+EditStats IncrementalGradient::update(std::string_view text) {
+    return update(parse(text, pool_, symbols_));
+}
+
+EditStats IncrementalGradient::update(const Node* f) {
+    const Differentiator::Stats start = differentiator_.stats();
+    EditStats edit;
+    edit.variables = static_cast<std::uint32_t>(std::max<std::size_t>(symbols_.size(), pool_.num_variables()));
+    edit.new_variables = edit.variables - static_cast<std::uint32_t>(gradient_.size());
+
+    function_ = f;
+    gradient_.resize(edit.variables);
+    for (std::uint32_t v = 0; v < edit.variables; ++v) {
+        gradient_[v] = differentiator_(f, v);
+        // Variable 0 has been differentiated for every earlier version, so
+        // its walk visits exactly the nodes they lacked.
+        if (v == 0)
+            edit.changed_nodes = differentiator_.stats().computed - start.computed;
+    }
+
+    edit.recomputed = differentiator_.stats().computed - start.computed;
+    edit.reused = differentiator_.stats().reused - start.reused;
+    return edit;
+}
+
+void IncrementalGradient::reset() {
+    differentiator_.clear();
+    function_ = nullptr;
+    gradient_.clear();
+    symbols_.clear();
+    pool_.clear();
+}
+
+}  // namespace fte
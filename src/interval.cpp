@@ -0,0 +1,415 @@
+#include "fte/interval.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace fte {
+
+namespace {
+
+using rounding::kInf;
+using rounding::kMax;
+using rounding::kUlp;
+using rounding::mul0;
+
+template <class F>
+void unary_kernel(F f, double* dlo, double* dhi, const double* alo, const double* ahi,
+                  std::size_t len) {
+    for (std::size_t j = 0; j < len; ++j) {
+        const Interval r = f(Interval(alo[j], ahi[j]));
+        dlo[j] = r.lo;
+        dhi[j] = r.hi;
+    }
+}
+
+template <class F>
+void binary_kernel(F f, double* dlo, double* dhi, const double* alo, const double* ahi,
+                   const double* blo, const double* bhi, std::size_t len) {
+    for (std::size_t j = 0; j < len; ++j) {
+        const Interval r = f(Interval(alo[j], ahi[j]), Interval(blo[j], bhi[j]));
+        dlo[j] = r.lo;
+        dhi[j] = r.hi;
+    }
+}
+
+/// Interval image of a unary operation.
+Interval apply_interval(Op op, const Interval& a) noexcept {
+    switch (op) {
+        case Op::Neg: return -a;
+        case Op::Sqrt: return sqrt(a);
+        case Op::Exp: return exp(a);
+        case Op::Log: return log(a);
+        case Op::Sin: return sin(a);
+        case Op::Cos: return cos(a);
+        case Op::Tan: return tan(a);
+        case Op::Tanh: return tanh(a);
+        default: return Interval::entire();
+    }
+}
+
+void interval_kernel(Op op, double* dlo, double* dhi, const double* alo, const double* ahi,
+                     const double* blo, const double* bhi, std::size_t len) {
+    switch (op) {
+        case Op::Neg: unary_kernel([](const Interval& a) { return -a; }, dlo, dhi, alo, ahi, len); break;
+        case Op::Sqrt: unary_kernel([](const Interval& a) { return sqrt(a); }, dlo, dhi, alo, ahi, len); break;
+        case Op::Exp: unary_kernel([](const Interval& a) { return exp(a); }, dlo, dhi, alo, ahi, len); break;
+        case Op::Log: unary_kernel([](const Interval& a) { return log(a); }, dlo, dhi, alo, ahi, len); break;
+        case Op::Sin: unary_kernel([](const Interval& a) { return sin(a); }, dlo, dhi, alo, ahi, len); break;
+        case Op::Cos: unary_kernel([](const Interval& a) { return cos(a); }, dlo, dhi, alo, ahi, len); break;
+        case Op::Tan: unary_kernel([](const Interval& a) { return tan(a); }, dlo, dhi, alo, ahi, len); break;
+        case Op::Tanh: unary_kernel([](const Interval& a) { return tanh(a); }, dlo, dhi, alo, ahi, len); break;
+        case Op::Add:
+            binary_kernel([](const Interval& a, const Interval& b) { return a + b; }, dlo, dhi, alo, ahi, blo, bhi, len);
+            break;
+        case Op::Sub:
+            binary_kernel([](const Interval& a, const Interval& b) { return a - b; }, dlo, dhi, alo, ahi, blo, bhi, len);
+            break;
+        case Op::Mul:
+            binary_kernel([](const Interval& a, const Interval& b) { return a * b; }, dlo, dhi, alo, ahi, blo, bhi, len);
+            break;
+        case Op::Div:
+            binary_kernel([](const Interval& a, const Interval& b) { return a / b; }, dlo, dhi, alo, ahi, blo, bhi, len);
+            break;
+        case Op::Pow:
+            binary_kernel([](const Interval& a, const Interval& b) { return pow(a, b); }, dlo, dhi, alo, ahi, blo, bhi, len);
+            break;
+        case Op::Const:
+        case Op::Var: break;
+    }
+}
+
+void check_columns(const Program& p, std::size_t lo, std::size_t hi, std::size_t out_lo,
+                   std::size_t out_hi) {
+    if (lo < p.num_inputs() || hi < p.num_inputs() || out_lo < p.num_outputs() ||
+        out_hi < p.num_outputs())
+        throw std::invalid_argument("interval evaluation: too few input or output columns");
+}
+
+/// Upper bound of a sum of `k` non-negative floating-point terms that was
+/// computed in round-to-nearest.
+inline double upper(double x, double k) noexcept {
+    return x * (1.0 + (k + 2.0) * kUlp) + std::numeric_limits<double>::denorm_min();
+}
+
+}  // namespace
+
+IntervalEvaluator::IntervalEvaluator(const Program& program, std::size_t tile)
+    : program_(program), tile_(std::max<std::size_t>(tile, 1)) {
+    const std::size_t slots = program_.num_slots();
+    scratch_ = std::make_unique<double[]>(2 * slots * tile_);
+    lo_.resize(slots);
+    hi_.resize(slots);
+    for (std::size_t s = 0; s < slots; ++s) {
+        lo_[s] = scratch_.get() + 2 * s * tile_;
+        hi_[s] = lo_[s] + tile_;
+    }
+    const auto constants = program_.constants();
+    for (std::size_t c = 0; c < constants.size(); ++c) {
+        std::fill_n(lo_[program_.const_base() + c], tile_, constants[c]);
+        std::fill_n(hi_[program_.const_base() + c], tile_, constants[c]);
+    }
+    src_lo_.assign(lo_.begin(), lo_.end());
+    src_hi_.assign(hi_.begin(), hi_.end());
+}
+
+void IntervalEvaluator::operator()(std::span<const double* const> lo,
+                                   std::span<const double* const> hi,
+                                   std::span<double* const> out_lo,
+                                   std::span<double* const> out_hi, std::size_t n) {
+    check_columns(program_, lo.size(), hi.size(), out_lo.size(), out_hi.size());
+    const auto outs = program_.outputs();
+    for (std::size_t p0 = 0; p0 < n; p0 += tile_) {
+        const std::size_t len = std::min(tile_, n - p0);
+        for (std::uint32_t i = 0; i < program_.num_inputs(); ++i) {
+            src_lo_[i] = lo[i] + p0;
+            src_hi_[i] = hi[i] + p0;
+        }
+        for (const Instr& in : program_.code())
+            interval_kernel(in.op, lo_[in.dst], hi_[in.dst], src_lo_[in.a], src_hi_[in.a],
+                            src_lo_[in.b], src_hi_[in.b], len);
+        for (std::size_t r = 0; r < outs.size(); ++r) {
+            std::copy_n(src_lo_[outs[r]], len, out_lo[r] + p0);
+            std::copy_n(src_hi_[outs[r]], len, out_hi[r] + p0);
+        }
+    }
+}
+
+/// View of one affine form per lane: `row(0)` centers, `row(1 .. n)`
+/// coefficients of the input noise symbols, `row(n + 1)` radii of the
+/// accumulated error.
+struct AffineEvaluator::Form {
+    double* base;
+    std::size_t tile;
+    std::size_t terms;
+
+    double* row(std::size_t t) const noexcept { return base + t * tile; }
+    double* center() const noexcept { return row(0); }
+    double* radius() const noexcept { return row(terms - 1); }
+};
+
+AffineEvaluator::AffineEvaluator(const Program& program, std::size_t tile)
+    : program_(program),
+      tile_(std::max<std::size_t>(tile, 1)),
+      terms_(program.num_inputs() + 2),
+      scratch_(program.num_slots() * terms_ * tile_, 0.0),
+      tmp_((2 * terms_ + 6) * tile_, 0.0) {
+    const auto constants = program_.constants();
+    for (std::size_t c = 0; c < constants.size(); ++c) {
+        double* base = scratch_.data() + (program_.const_base() + c) * terms_ * tile_;
+        std::fill_n(base, tile_, constants[c]);
+    }
+}
+
+void AffineEvaluator::operator()(std::span<const double* const> lo,
+                                 std::span<const double* const> hi,
+                                 std::span<double* const> out_lo,
+                                 std::span<double* const> out_hi, std::size_t n) {
+    check_columns(program_, lo.size(), hi.size(), out_lo.size(), out_hi.size());
+    const std::size_t ni = program_.num_inputs();
+    auto form = [&](std::uint32_t s) { return Form{scratch_.data() + s * terms_ * tile_, tile_, terms_}; };
+
+    for (std::size_t p0 = 0; p0 < n; p0 += tile_) {
+        const std::size_t len = std::min(tile_, n - p0);
+        // Input i becomes mid_i + rad_i e_i.
+        for (std::uint32_t i = 0; i < ni; ++i) {
+            const Form f = form(i);
+            std::fill_n(f.base, terms_ * tile_, 0.0);
+            for (std::size_t j = 0; j < len; ++j) {
+                const double l = lo[i][p0 + j], h = hi[i][p0 + j];
+                const double m = 0.5 * l + 0.5 * h;
+                const double r = rounding::up(std::max(h - m, m - l));
+                const bool bounded = std::abs(m) <= kMax && r <= kMax;
+                f.center()[j] = bounded ? m : 0.0;
+                f.row(1 + i)[j] = bounded ? r : 0.0;
+                f.radius()[j] = bounded ? 0.0 : kInf;
+            }
+        }
+        for (const Instr& in : program_.code())
+            apply(in, len);
+
+        const auto outs = program_.outputs();
+        for (std::size_t r = 0; r < outs.size(); ++r) {
+            const Form f = form(outs[r]);
+            for (std::size_t j = 0; j < len; ++j) {
+                double rad = f.radius()[j];
+                for (std::size_t t = 1; t <= ni; ++t)
+                    rad += std::abs(f.row(t)[j]);
+                rad = upper(rad, static_cast<double>(ni + 1));
+                const bool bounded = rad <= kMax;
+                out_lo[r][p0 + j] = bounded ? rounding::down(f.center()[j] - rad) : -kInf;
+                out_hi[r][p0 + j] = bounded ? rounding::up(f.center()[j] + rad) : kInf;
+            }
+        }
+    }
+}
+
+void AffineEvaluator::apply(const Instr& in, std::size_t len) {
+    const std::size_t ni = terms_ - 2;
+    const std::size_t size = terms_ * tile_;
+    const Form x{scratch_.data() + in.a * size, tile_, terms_};
+    const Form y{scratch_.data() + in.b * size, tile_, terms_};
+    // The result is built in a spare form since `dst` may alias an operand.
+    const Form z{tmp_.data(), tile_, terms_};
+    const Form w{tmp_.data() + size, tile_, terms_};
+    double* rx = tmp_.data() + 2 * size;
+    double* ry = rx + tile_;
+    double* alpha = ry + tile_;
+    double* zeta = alpha + tile_;
+    double* delta = zeta + tile_;
+    double* err = delta + tile_;
+
+    // Total radius sum |f_i| + d of a form, rounded up; infinite if any
+    // term is infinite or NaN.
+    auto radius = [&](const Form& f, double* r) {
+        std::copy_n(f.radius(), len, r);
+        for (std::size_t t = 1; t <= ni; ++t)
+            for (std::size_t j = 0; j < len; ++j)
+                r[j] += std::abs(f.row(t)[j]);
+        for (std::size_t j = 0; j < len; ++j)
+            r[j] = r[j] == 0.0 ? 0.0 : r[j] <= kMax ? upper(r[j], static_cast<double>(ni + 1)) : kInf;
+    };
+    // Lane `j` of `f` becomes the whole real line.
+    auto entire = [&](const Form& f, std::size_t j) {
+        for (std::size_t t = 0; t + 1 < terms_; ++t)
+            f.row(t)[j] = 0.0;
+        f.radius()[j] = kInf;
+    };
+    // Exact for constants, so that `pow` sees integral exponents.
+    auto range = [&](const Form& f, const double* r, std::size_t j) {
+        if (r[j] == 0.0)
+            return Interval(f.center()[j]);
+        return Interval(rounding::down(f.center()[j] - r[j]), rounding::up(f.center()[j] + r[j]));
+    };
+    // out = f * g; the quadratic remainder is bounded by rad(f) rad(g). An
+    // unbounded operand makes the product unbounded.
+    auto mul = [&](const Form& f, const Form& g, const Form& out) {
+        radius(f, rx);
+        radius(g, ry);
+        for (std::size_t j = 0; j < len; ++j) {
+            out.center()[j] = f.center()[j] * g.center()[j];
+            err[j] = std::abs(out.center()[j]);
+        }
+        for (std::size_t t = 1; t <= ni; ++t)
+            for (std::size_t j = 0; j < len; ++j) {
+                const double p = f.center()[j] * g.row(t)[j];
+                const double q = g.center()[j] * f.row(t)[j];
+                out.row(t)[j] = p + q;
+                err[j] += std::abs(p) + std::abs(q);
+            }
+        int unbounded = 0;
+        for (std::size_t j = 0; j < len; ++j) {
+            out.radius()[j] = upper(mul0(std::abs(f.center()[j]), g.radius()[j]) +
+                                        mul0(std::abs(g.center()[j]), f.radius()[j]) +
+                                        mul0(rx[j], ry[j]) + 2 * kUlp * err[j],
+                                    6.0);
+            unbounded |= rx[j] == kInf || ry[j] == kInf;
+        }
+        if (unbounded)
+            for (std::size_t j = 0; j < len; ++j)
+                if (rx[j] == kInf || ry[j] == kInf)
+                    entire(out, j);
+    };
+    // out = alpha f + zeta +- delta, per lane.
+    auto linear = [&](const Form& f, const Form& out) {
+        for (std::size_t j = 0; j < len; ++j) {
+            const double p = rounding::mul0(alpha[j], f.center()[j]);
+            out.center()[j] = p + zeta[j];
+            err[j] = std::abs(p) + std::abs(zeta[j]);
+        }
+        for (std::size_t t = 1; t <= ni; ++t)
+            for (std::size_t j = 0; j < len; ++j) {
+                out.row(t)[j] = rounding::mul0(alpha[j], f.row(t)[j]);
+                err[j] += std::abs(out.row(t)[j]);
+            }
+        for (std::size_t j = 0; j < len; ++j)
+            out.radius()[j] =
+                upper(rounding::mul0(std::abs(alpha[j]), f.radius()[j]) + delta[j] + 2 * kUlp * err[j],
+                      4.0);
+    };
+    // Min-range linearization on [a, b] for a slope `alpha` that keeps
+    // f(t) - alpha t monotone there, so its range is spanned by the ends.
+    auto min_range = [&](std::size_t j, const Interval& fa, const Interval& fb, double a,
+                         double b) {
+        const Interval ga = fa - Interval(alpha[j]) * Interval(a);
+        const Interval gb = fb - Interval(alpha[j]) * Interval(b);
+        const Interval g(std::min(ga.lo, gb.lo), std::max(ga.hi, gb.hi));
+        zeta[j] = g.mid();
+        delta[j] = rounding::up(std::max(g.hi - zeta[j], zeta[j] - g.lo));
+    };
+    // A constant form spanning `r`, which loses all correlations. Unbounded
+    // and empty ranges both give the whole line, which encloses either.
+    auto from_interval = [&](std::size_t j, const Interval& r) {
+        alpha[j] = 0.0;
+        if (std::isfinite(r.lo) && std::isfinite(r.hi)) {
+            zeta[j] = r.mid();
+            delta[j] = rounding::up(std::max(r.hi - zeta[j], zeta[j] - r.lo));
+        } else {
+            zeta[j] = 0.0;
+            delta[j] = kInf;
+        }
+    };
+
+    switch (in.op) {
+        case Op::Neg:
+            for (std::size_t t = 0; t + 1 < terms_; ++t)
+                for (std::size_t j = 0; j < len; ++j)
+                    z.row(t)[j] = -x.row(t)[j];
+            std::copy_n(x.radius(), len, z.radius());
+            break;
+        case Op::Add:
+        case Op::Sub: {
+            const double s = in.op == Op::Add ? 1.0 : -1.0;
+            for (std::size_t j = 0; j < len; ++j) {
+                z.center()[j] = x.center()[j] + s * y.center()[j];
+                err[j] = std::abs(z.center()[j]);
+            }
+            for (std::size_t t = 1; t <= ni; ++t)
+                for (std::size_t j = 0; j < len; ++j) {
+                    z.row(t)[j] = x.row(t)[j] + s * y.row(t)[j];
+                    err[j] += std::abs(z.row(t)[j]);
+                }
+            for (std::size_t j = 0; j < len; ++j)
+                z.radius()[j] = upper(x.radius()[j] + y.radius()[j] + kUlp * err[j], 3.0);
+            break;
+        }
+        case Op::Mul:
+            mul(x, y, z);
+            break;
+        case Op::Div:
+            // x * (1 / y) with the reciprocal of a sign-definite y; for y < 0
+            // it is the negated reciprocal of |y| on [a, b] = -y.
+            radius(y, ry);
+            for (std::size_t j = 0; j < len; ++j) {
+                const Interval r = range(y, ry, j);
+                if (r.lo <= 0.0 && r.hi >= 0.0) {
+                    from_interval(j, Interval::entire());
+                    continue;
+                }
+                const bool neg = r.hi < 0.0;
+                const double a = neg ? -r.hi : r.lo, b = neg ? -r.lo : r.hi;
+                alpha[j] = -rounding::down(1.0 / rounding::up(b * b));
+                min_range(j, Interval(1.0) / Interval(a), Interval(1.0) / Interval(b), a, b);
+                if (neg)
+                    zeta[j] = -zeta[j];
+            }
+            linear(y, w);
+            mul(x, w, z);
+            break;
+        case Op::Exp:
+        case Op::Log:
+        case Op::Sqrt:
+            radius(x, rx);
+            for (std::size_t j = 0; j < len; ++j) {
+                const Interval r = range(x, rx, j);
+                const double a = r.lo, b = r.hi;
+                if (!std::isfinite(a) || !std::isfinite(b)) {
+                    from_interval(j, apply_interval(in.op, r));
+                } else if (in.op == Op::Exp) {
+                    // Convex and increasing: the slope at the left end.
+                    alpha[j] = rounding::down(std::exp(a), rounding::kLibmUlps);
+                    min_range(j, exp(Interval(a)), exp(Interval(b)), a, b);
+                } else if (a <= 0.0) {
+                    from_interval(j, apply_interval(in.op, r));
+                } else if (in.op == Op::Log) {
+                    // Concave and increasing: the slope at the right end.
+                    alpha[j] = rounding::down(1.0 / b);
+                    min_range(j, log(Interval(a)), log(Interval(b)), a, b);
+                } else {
+                    alpha[j] = rounding::down(0.5 / rounding::up(std::sqrt(b)));
+                    min_range(j, sqrt(Interval(a)), sqrt(Interval(b)), a, b);
+                }
+            }
+            linear(x, z);
+            break;
+        case Op::Pow:
+            radius(x, rx);
+            radius(y, ry);
+            for (std::size_t j = 0; j < len; ++j)
+                from_interval(j, pow(range(x, rx, j), range(y, ry, j)));
+            linear(x, z);
+            break;
+        default:
+            radius(x, rx);
+            for (std::size_t j = 0; j < len; ++j)
+                from_interval(j, apply_interval(in.op, range(x, rx, j)));
+            linear(x, z);
+            break;
+    }
+
+    // Overflowed centers or coefficients show up in the radius; such lanes
+    // become the whole line, so later products see an infinite radius
+    // rather than NaNs from inf - inf or 0 * inf.
+    int unbounded = 0;
+    for (std::size_t j = 0; j < len; ++j)
+        unbounded |= !(z.radius()[j] <= kMax) || !(std::abs(z.center()[j]) <= kMax);
+    if (unbounded)
+        for (std::size_t j = 0; j < len; ++j)
+            if (!(z.radius()[j] <= kMax) || !(std::abs(z.center()[j]) <= kMax))
+                entire(z, j);
+
+    double* dst = scratch_.data() + in.dst * size;
+    for (std::size_t t = 0; t < terms_; ++t)
+        std::copy_n(z.row(t), len, dst + t * tile_);
+}
+
+}  // namespace fte
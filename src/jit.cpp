@@ -0,0 +1,302 @@
+#include "fte/jit.hpp"
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fte/hash.hpp"
+#include "fte/profile.hpp"
+
+#ifndef FTE_JIT_DEFAULT_CXX
+#define FTE_JIT_DEFAULT_CXX "c++"
+#endif
+
+namespace fte {
+
+namespace {
+
+// Bump when the generated entry points change shape.
+constexpr std::uint64_t kJitAbiVersion = 1;
+
+void emit_literal(std::string& out, double v) {
+    if (std::isnan(v)) {
+        out += "__builtin_nan(\"\")";
+        return;
+    }
+    if (std::isinf(v)) {
+        out += v < 0 ? "(-__builtin_huge_val())" : "__builtin_huge_val()";
+        return;
+    }
+    // Hex floats round-trip exactly.
+    char buf[40];
+    const bool negative = std::signbit(v);
+    auto res = std::to_chars(buf, buf + sizeof buf, std::fabs(v), std::chars_format::hex);
+    out += negative ? "(-0x" : "0x";
+    out.append(buf, res.ptr);
+    if (negative)
+        out += ')';
+}
+
+const char* cpp_function(Op op) {
+    switch (op) {
+        case Op::Sqrt: return "std::sqrt";
+        case Op::Exp: return "std::exp";
+        case Op::Log: return "std::log";
+        case Op::Sin: return "std::sin";
+        case Op::Cos: return "std::cos";
+        case Op::Tan: return "std::tan";
+        case Op::Tanh: return "std::tanh";
+        case Op::Pow: return "std::pow";
+        default: return nullptr;
+    }
+}
+
+std::filesystem::path default_cache_dir() {
+    if (const char* d = std::getenv("FTE_CACHE_DIR"); d && *d)
+        return d;
+    if (const char* d = std::getenv("XDG_CACHE_HOME"); d && *d)
+        return std::filesystem::path(d) / "fte";
+    if (const char* d = std::getenv("HOME"); d && *d)
+        return std::filesystem::path(d) / ".cache" / "fte";
+    return std::filesystem::temp_directory_path() / "fte-cache";
+}
+
+std::string resolved_compiler(const JitOptions& o) {
+    if (!o.compiler.empty())
+        return o.compiler;
+    if (const char* c = std::getenv("FTE_JIT_CXX"); c && *c)
+        return c;
+    return FTE_JIT_DEFAULT_CXX;
+}
+
+std::string resolved_flags(const JitOptions& o) {
+    return o.flags.empty() ? std::string("-O3 -march=native -fno-math-errno") : o.flags;
+}
+
+std::string kernel_stem(std::uint64_t key) {
+    char buf[18];
+    std::snprintf(buf, sizeof buf, "k%016llx", static_cast<unsigned long long>(key));
+    return buf;
+}
+
+std::string quoted(const std::filesystem::path& p) {
+    std::string s = "'";
+    for (char c : p.string()) {
+        if (c == '\'')
+            s += "'\\''";
+        else
+            s += c;
+    }
+    return s + "'";
+}
+
+std::string unique_suffix() {
+    static std::atomic<unsigned> counter{0};
+    char buf[48];
+    std::snprintf(buf, sizeof buf, ".%ld.%u", static_cast<long>(::getpid()), counter++);
+    return buf;
+}
+
+}  // namespace
+
+std::string emit_cpp(std::span<const Node* const> roots) {
+    const std::vector<const Node*> order = topo_order(roots);
+    std::unordered_map<const Node*, std::size_t> slot;
+    slot.reserve(order.size());
+    std::uint32_t num_vars = 0;
+    for (const Node* n : order)
+        if (n->op == Op::Var && n->var + 1 > num_vars)
+            num_vars = n->var + 1;
+
+    std::string src;
+    src += "// Generated by fte::emit_cpp. Do not edit.\n";
+    src += "#include <cmath>\n#include <cstddef>\n\n";
+    src += "static inline void fte_body(const double* __restrict x, double* __restrict out) {\n";
+
+    auto operand = [&](const Node* n) {
+        std::string s;
+        switch (n->op) {
+            case Op::Const: emit_literal(s, n->value); break;
+            case Op::Var: s = "x[" + std::to_string(n->var) + "]"; break;
+            default:
+                s = 't';
+                s += std::to_string(slot.at(n));
+                break;
+        }
+        return s;
+    };
+
+    std::size_t next = 0;
+    for (const Node* n : order) {
+        if (n->op == Op::Const || n->op == Op::Var)
+            continue;
+        const std::size_t t = next++;
+        std::string line = "    const double t" + std::to_string(t) + " = ";
+        const std::string a = operand(n->arg[0]);
+        switch (n->op) {
+            case Op::Neg: line += "-" + a; break;
+            case Op::Add: line += a + " + " + operand(n->arg[1]); break;
+            case Op::Sub: line += a + " - " + operand(n->arg[1]); break;
+            case Op::Mul: line += a + " * " + operand(n->arg[1]); break;
+            case Op::Div: line += a + " / " + operand(n->arg[1]); break;
+            case Op::Pow: line += std::string(cpp_function(n->op)) + "(" + a + ", " + operand(n->arg[1]) + ")"; break;
+            default: line += std::string(cpp_function(n->op)) + "(" + a + ")"; break;
+        }
+        src += line + ";\n";
+        slot.emplace(n, t);
+    }
+    if (num_vars == 0)
+        src += "    (void)x;\n";
+    for (std::size_t r = 0; r < roots.size(); ++r)
+        src += "    out[" + std::to_string(r) + "] = " + operand(roots[r]) + ";\n";
+    src += "}\n\n";
+
+    const std::string nv = std::to_string(num_vars == 0 ? 1 : num_vars);
+    const std::string nr = std::to_string(roots.empty() ? 1 : roots.size());
+    src += "extern \"C\" void fte_eval(const double* x, double* out) { fte_body(x, out); }\n\n";
+    src += "extern \"C\" void fte_eval_batch(std::size_t n, const double* const* x, "
+           "double* const* out) {\n";
+    src += "    for (std::size_t p = 0; p < n; ++p) {\n";
+    src += "        double xp[" + nv + "];\n        double op[" + nr + "];\n";
+    src += "        for (std::size_t i = 0; i < " + std::to_string(num_vars) + "; ++i) xp[i] = x[i][p];\n";
+    src += "        fte_body(xp, op);\n";
+    src += "        for (std::size_t r = 0; r < " + std::to_string(roots.size()) + "; ++r) out[r][p] = op[r];\n";
+    src += "    }\n}\n";
+    return src;
+}
+
+std::uint64_t kernel_key(std::span<const Node* const> roots, const JitOptions& options) {
+    std::uint64_t h = mix64(kJitAbiVersion);
+    h = hash_combine(h, roots.size());
+    for (const Node* r : roots)
+        h = hash_combine(h, r->hash);
+    h = hash_combine(h, hash_bytes(resolved_compiler(options)));
+    h = hash_combine(h, hash_bytes(resolved_flags(options)));
+    return h;
+}
+
+CompiledKernel CompiledKernel::compile(std::span<const Node* const> roots,
+                                       const JitOptions& options) {
+    FTE_PROFILE_SCOPE(Codegen);
+    namespace fs = std::filesystem;
+    const fs::path dir = options.cache_dir.empty() ? default_cache_dir() : options.cache_dir;
+    const std::uint64_t key = kernel_key(roots, options);
+    const fs::path so = dir / (kernel_stem(key) + ".so");
+    const fs::path published = dir / (kernel_stem(key) + ".cpp");
+    // The command line heads the source, so the comparison below covers all
+    // the key does.
+    const std::string command = resolved_compiler(options) + " " + resolved_flags(options);
+    const std::string source = "// " + command + "\n" + emit_cpp(roots);
+
+    CompiledKernel k;
+    k.key_ = key;
+    k.path_ = so;
+
+    // A cached object is trusted only if the source it was built from,
+    // published next to it, matches: the key is a 64-bit hash.
+    std::error_code ec;
+    bool collision = false;
+    if (fs::exists(so, ec)) {
+        std::ifstream in(published, std::ios::binary);
+        if (in) {
+            std::ostringstream cached;
+            cached << in.rdbuf();
+            k.from_cache_ = cached.str() == source;
+            collision = !k.from_cache_;
+        }
+    }
+    fs::path built;
+    if (!k.from_cache_) {
+        fs::create_directories(dir, ec);
+        if (ec)
+            throw std::runtime_error("fte::jit: cannot create cache directory " + dir.string() +
+                                     ": " + ec.message());
+        const std::string suffix = unique_suffix();
+        const fs::path src = dir / (kernel_stem(key) + suffix + ".cpp");
+        const fs::path tmp = dir / (kernel_stem(key) + suffix + ".so");
+        const fs::path log = dir / (kernel_stem(key) + suffix + ".log");
+        {
+            std::ofstream out(src, std::ios::binary);
+            out << source;
+            if (!out)
+                throw std::runtime_error("fte::jit: cannot write " + src.string());
+        }
+        const std::string cmd = command + " -std=c++17 -shared -fPIC -o " + quoted(tmp) + " " +
+                                quoted(src) + " > " + quoted(log) + " 2>&1";
+        const int status = std::system(cmd.c_str());
+        if (status != 0) {
+            std::ostringstream msg;
+            msg << "fte::jit: compiler failed (status " << status << "): " << cmd;
+            std::ifstream in(log);
+            if (in)
+                msg << '\n' << in.rdbuf();
+            fs::remove(src, ec);
+            fs::remove(tmp, ec);
+            fs::remove(log, ec);
+            throw std::runtime_error(msg.str());
+        }
+        fs::remove(log, ec);
+        if (collision) {
+            // Another kernel owns the key: load this one from its private
+            // name and leave the cache entry alone.
+            fs::remove(src, ec);
+            k.path_ = built = tmp;
+        } else {
+            // Source first, so a reader never pairs the new object with a
+            // stale source.
+            fs::rename(src, published, ec);
+            if (!ec)
+                fs::rename(tmp, so, ec);
+            if (ec) {
+                fs::remove(src, ec);
+                fs::remove(tmp, ec);
+                throw std::runtime_error("fte::jit: cannot publish " + so.string());
+            }
+        }
+    }
+
+    k.handle_ = ::dlopen(k.path_.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!built.empty())
+        fs::remove(built, ec);
+    if (!k.handle_)
+        throw std::runtime_error(std::string("fte::jit: dlopen failed: ") + ::dlerror());
+    k.point_ = reinterpret_cast<PointFn>(::dlsym(k.handle_, "fte_eval"));
+    k.batch_ = reinterpret_cast<BatchFn>(::dlsym(k.handle_, "fte_eval_batch"));
+    if (!k.point_ || !k.batch_)
+        throw std::runtime_error("fte::jit: kernel entry points missing in " + k.path_.string());
+    return k;
+}
+
+CompiledKernel::CompiledKernel(CompiledKernel&& other) noexcept { *this = std::move(other); }
+
+CompiledKernel& CompiledKernel::operator=(CompiledKernel&& other) noexcept {
+    if (this != &other) {
+        if (handle_)
+            ::dlclose(handle_);
+        handle_ = std::exchange(other.handle_, nullptr);
+        point_ = std::exchange(other.point_, nullptr);
+        batch_ = std::exchange(other.batch_, nullptr);
+        key_ = other.key_;
+        path_ = std::move(other.path_);
+        from_cache_ = other.from_cache_;
+    }
+    return *this;
+}
+
+CompiledKernel::~CompiledKernel() {
+    if (handle_)
+        ::dlclose(handle_);
+}
+
+}  // namespace fte
@@ -0,0 +1,197 @@
+#include "fte/jvp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "fte/profile.hpp"
+
+namespace fte {
+
+namespace {
+
+struct Local {
+    double value;
+    double pa;  // d value / d a
+    double pb;  // d value / d b, 0 for unary operations
+};
+
+/// Value and local partials of one instruction, with the conventions of
+/// `Real`: `pow` has no `b` partial for `a <= 0` and no `a` partial for
+/// `b == 0`.
+Local local(Op op, double a, double b) {
+    switch (op) {
+        case Op::Neg: return {-a, -1.0, 0.0};
+        case Op::Add: return {a + b, 1.0, 1.0};
+        case Op::Sub: return {a - b, 1.0, -1.0};
+        case Op::Mul: return {a * b, b, a};
+        case Op::Div: {
+            const double q = a / b;
+            return {q, 1.0 / b, -q / b};
+        }
+        case Op::Sqrt: {
+            const double r = std::sqrt(a);
+            return {r, 0.5 / r, 0.0};
+        }
+        case Op::Exp: {
+            const double e = std::exp(a);
+            return {e, e, 0.0};
+        }
+        case Op::Log: return {std::log(a), 1.0 / a, 0.0};
+        case Op::Sin: return {std::sin(a), std::cos(a), 0.0};
+        case Op::Cos: return {std::cos(a), -std::sin(a), 0.0};
+        case Op::Tan: {
+            const double t = std::tan(a);
+            return {t, 1.0 + t * t, 0.0};
+        }
+        case Op::Tanh: {
+            const double t = std::tanh(a);
+            return {t, 1.0 - t * t, 0.0};
+        }
+        case Op::Pow: {
+            const double p = std::pow(a, b);
+            return {p, b == 0.0 ? 0.0 : b * std::pow(a, b - 1.0), a > 0.0 ? p * std::log(a) : 0.0};
+        }
+        case Op::Const:
+        case Op::Var: break;
+    }
+    throw std::invalid_argument("jvp/vjp: leaf operation in program code");
+}
+
+bool is_unary(Op op) noexcept { return arity(op) == 1; }
+
+/// Fill the input and constant slots of `value`.
+void load(const Program& program, std::span<const double> x, std::vector<double>& value) {
+    value.resize(program.num_slots());
+    std::copy_n(x.data(), program.num_inputs(), value.begin());
+    const auto constants = program.constants();
+    std::copy(constants.begin(), constants.end(), value.begin() + program.const_base());
+}
+
+void store_outputs(const Program& program, const std::vector<double>& value, std::span<double> y) {
+    if (y.empty())
+        return;
+    const auto outs = program.outputs();
+    for (std::size_t r = 0; r < outs.size(); ++r)
+        y[r] = value[outs[r]];
+}
+
+void check(const Program& program, std::span<const double> x, std::size_t seeds,
+           std::size_t seed_len, std::span<double> y, std::size_t result, std::size_t result_len,
+           const char* what) {
+    if (x.size() < program.num_inputs() || seeds < seed_len || result < result_len ||
+        (!y.empty() && y.size() < program.num_outputs()))
+        throw std::invalid_argument(std::string(what) + ": span too small");
+}
+
+}  // namespace
+
+void JvpEvaluator::operator()(std::span<const double> x, std::span<const double> v, std::size_t k,
+                              std::span<double> y, std::span<double> jv) {
+    FTE_PROFILE_SCOPE(Evaluate);
+    FTE_PROFILE_COUNT(EvaluatedPoints, 1);
+    const std::size_t n = program_.num_inputs(), m = program_.num_outputs();
+    check(program_, x, v.size(), k * n, y, jv.size(), k * m, "JvpEvaluator");
+
+    load(program_, x, value_);
+    // Tangents are stored by slot, so that each instruction updates all
+    // directions with one contiguous loop. Constants have none.
+    tangent_.assign(std::size_t(program_.num_slots()) * k, 0.0);
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t j = 0; j < k; ++j)
+            tangent_[i * k + j] = v[j * n + i];
+
+    double* t = tangent_.data();
+    for (const Instr& in : program_.code()) {
+        const Local l = local(in.op, value_[in.a], value_[in.b]);
+        value_[in.dst] = l.value;
+        double* d = t + std::size_t(in.dst) * k;
+        const double* a = t + std::size_t(in.a) * k;
+        const double* b = t + std::size_t(in.b) * k;
+        if (is_unary(in.op)) {
+            for (std::size_t j = 0; j < k; ++j)
+                d[j] = l.pa * a[j];
+        } else {
+            for (std::size_t j = 0; j < k; ++j)
+                d[j] = l.pa * a[j] + l.pb * b[j];
+        }
+    }
+
+    store_outputs(program_, value_, y);
+    const auto outs = program_.outputs();
+    for (std::size_t r = 0; r < m; ++r)
+        for (std::size_t j = 0; j < k; ++j)
+            jv[j * m + r] = t[std::size_t(outs[r]) * k + j];
+}
+
+void VjpEvaluator::operator()(std::span<const double> x, std::span<const double> w, std::size_t k,
+                              std::span<double> y, std::span<double> wj) {
+    FTE_PROFILE_SCOPE(Evaluate);
+    FTE_PROFILE_COUNT(EvaluatedPoints, 1);
+    const std::size_t n = program_.num_inputs(), m = program_.num_outputs();
+    check(program_, x, w.size(), k * m, y, wj.size(), k * n, "VjpEvaluator");
+
+    const auto code = program_.code();
+    load(program_, x, value_);
+    partial_.resize(2 * code.size());
+    for (std::size_t i = 0; i < code.size(); ++i) {
+        const Instr& in = code[i];
+        const Local l = local(in.op, value_[in.a], value_[in.b]);
+        value_[in.dst] = l.value;
+        partial_[2 * i] = l.pa;
+        partial_[2 * i + 1] = l.pb;
+    }
+    store_outputs(program_, value_, y);
+
+    adjoint_.assign(std::size_t(program_.num_slots()) * k, 0.0);
+    double* adj = adjoint_.data();
+    const auto outs = program_.outputs();
+    for (std::size_t r = 0; r < m; ++r)
+        for (std::size_t j = 0; j < k; ++j)
+            adj[std::size_t(outs[r]) * k + j] += w[j * m + r];
+
+    // A slot may hold several values over the program when slots are
+    // reused; the adjoint it carries belongs to the value last defined, so
+    // it is consumed and cleared at that definition. Operands are updated
+    // after the clear, which also covers a result written over its operand.
+    for (std::size_t i = code.size(); i-- > 0;) {
+        const Instr& in = code[i];
+        const double pa = partial_[2 * i], pb = partial_[2 * i + 1];
+        double* d = adj + std::size_t(in.dst) * k;
+        double* a = adj + std::size_t(in.a) * k;
+        double* b = adj + std::size_t(in.b) * k;
+        if (is_unary(in.op)) {
+            for (std::size_t j = 0; j < k; ++j) {
+                const double g = d[j];
+                d[j] = 0.0;
+                a[j] += pa * g;
+            }
+        } else {
+            for (std::size_t j = 0; j < k; ++j) {
+                const double g = d[j];
+                d[j] = 0.0;
+                a[j] += pa * g;
+                b[j] += pb * g;
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t j = 0; j < k; ++j)
+            wj[j * n + i] = adj[i * k + j];
+}
+
+void jvp(const Program& program, std::span<const double> x, std::span<const double> v,
+         std::size_t k, std::span<double> y, std::span<double> jv) {
+    JvpEvaluator eval(program);
+    eval(x, v, k, y, jv);
+}
+
+void vjp(const Program& program, std::span<const double> x, std::span<const double> w,
+         std::size_t k, std::span<double> y, std::span<double> wj) {
+    VjpEvaluator eval(program);
+    eval(x, w, k, y, wj);
+}
+
+}  // namespace fte
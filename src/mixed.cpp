@@ -0,0 +1,303 @@
+#include "fte/mixed.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "fte/profile.hpp"
+#include "fte/vmath.hpp"
+
+namespace fte {
+
+namespace {
+
+struct RoundFloat {
+    float operator()(float v) const noexcept { return v; }
+};
+
+// The narrower formats are emulated in float lanes: each result is rounded
+// to the nearest value of the format, ties to even, with plain integer
+// operations that vectorize where conversions to `_Float16` do not.
+
+/// binary16: 11 significant bits, subnormals below 2^-14 and overflow to
+/// infinity above 65504.
+struct RoundHalf {
+    float operator()(float v) const noexcept {
+        const std::uint32_t u = std::bit_cast<std::uint32_t>(v);
+        const std::uint32_t sign = u & 0x80000000u, mag = u & 0x7fffffffu;
+        std::uint32_t r = (mag + 0xfffu + ((mag >> 13) & 1u)) & 0xffffe000u;
+        r = r > 0x477fe000u ? 0x7f800000u : r;
+        // Subnormals are multiples of 2^-24, the spacing of floats near 0.5.
+        const float tiny = (std::bit_cast<float>(mag) + 0x1p-1f) - 0x1p-1f;
+        r = mag < 0x38800000u ? std::bit_cast<std::uint32_t>(tiny) : r;
+        return std::bit_cast<float>(mag > 0x7f800000u ? u : (sign | r));
+    }
+};
+
+/// bfloat16: the upper half of a float. NaNs pass through so that rounding
+/// their payload cannot turn them into infinities.
+struct RoundBFloat16 {
+    float operator()(float v) const noexcept {
+        const std::uint32_t u = std::bit_cast<std::uint32_t>(v);
+        const std::uint32_t r = (u + 0x7fffu + ((u >> 16) & 1u)) & 0xffff0000u;
+        return std::bit_cast<float>((u & 0x7fffffffu) > 0x7f800000u ? u : r);
+    }
+};
+
+/// Round `d` in place to the format of `R`; free for `RoundFloat`.
+template <class R>
+void round_all(float* d, std::size_t len) {
+    const R r;
+    for (std::size_t j = 0; j < len; ++j)
+        d[j] = r(d[j]);
+}
+
+/// One instruction over the tile: computed in float, rounded by `R`.
+/// Additions and subtractions raise a lane's risk above zero when they lose
+/// more than a factor of `kappa` to cancellation. A NaN they produce leaves
+/// the risk alone; it reaches the outputs, which flag it there.
+template <class R>
+void kernel(Op op, float* d, const float* a, const float* b, std::size_t len, float kappa,
+            float* risk) {
+    const R r;
+    switch (op) {
+        case Op::Neg: for (std::size_t j = 0; j < len; ++j) d[j] = -a[j]; break;
+        case Op::Add:
+            for (std::size_t j = 0; j < len; ++j) {
+                const float x = a[j], y = b[j], s = x + y;
+                d[j] = r(s);
+                risk[j] = std::max(risk[j], std::abs(x) + std::abs(y) - std::abs(s) * kappa);
+            }
+            break;
+        case Op::Sub:
+            for (std::size_t j = 0; j < len; ++j) {
+                const float x = a[j], y = b[j], s = x - y;
+                d[j] = r(s);
+                risk[j] = std::max(risk[j], std::abs(x) + std::abs(y) - std::abs(s) * kappa);
+            }
+            break;
+        case Op::Mul: for (std::size_t j = 0; j < len; ++j) d[j] = r(a[j] * b[j]); break;
+        case Op::Div: for (std::size_t j = 0; j < len; ++j) d[j] = r(a[j] / b[j]); break;
+        case Op::Sqrt: for (std::size_t j = 0; j < len; ++j) d[j] = r(std::sqrt(a[j])); break;
+        case Op::Exp: vmath::exp(len, a, d); round_all<R>(d, len); break;
+        case Op::Log: vmath::log(len, a, d); round_all<R>(d, len); break;
+        case Op::Sin: vmath::sin(len, a, d); round_all<R>(d, len); break;
+        case Op::Cos: vmath::cos(len, a, d); round_all<R>(d, len); break;
+        case Op::Tan: for (std::size_t j = 0; j < len; ++j) d[j] = r(std::tan(a[j])); break;
+        case Op::Tanh: vmath::tanh(len, a, d); round_all<R>(d, len); break;
+        case Op::Pow:
+            for (std::size_t j = 0; j < len; ++j) d[j] = r(std::pow(a[j], b[j]));
+            break;
+        case Op::Const:
+        case Op::Var: break;
+    }
+}
+
+/// Convert the tile's inputs, run the program and widen its outputs,
+/// raising the risk of lanes whose outputs are not finite.
+template <class R>
+void run_reduced(const Program& program, std::span<float* const> slot_ptr,
+                 std::span<const double* const> inputs, std::span<double* const> outputs,
+                 std::size_t p0, std::size_t len, float kappa, float* risk) {
+    const R r;
+    for (std::uint32_t i = 0; i < program.num_inputs(); ++i) {
+        const double* in = inputs[i] + p0;
+        float* row = slot_ptr[i];
+        for (std::size_t j = 0; j < len; ++j)
+            row[j] = r(static_cast<float>(in[j]));
+    }
+    for (const Instr& in : program.code())
+        kernel<R>(in.op, slot_ptr[in.dst], slot_ptr[in.a], slot_ptr[in.b], len, kappa, risk);
+    const auto out_slots = program.outputs();
+    for (std::size_t k = 0; k < out_slots.size(); ++k) {
+        const float* row = slot_ptr[out_slots[k]];
+        double* out = outputs[k] + p0;
+        int bad = 0;
+        for (std::size_t j = 0; j < len; ++j) {
+            out[j] = row[j];
+            bad |= !(std::abs(row[j]) <= std::numeric_limits<float>::max());
+        }
+        if (bad)
+            for (std::size_t j = 0; j < len; ++j)
+                if (!(std::abs(row[j]) <= std::numeric_limits<float>::max()))
+                    risk[j] = 1.0f;
+    }
+}
+
+float round_to(Precision precision, double v) noexcept {
+    const float f = static_cast<float>(v);
+    switch (precision) {
+        case Precision::Float: return f;
+        case Precision::Half: return RoundHalf{}(f);
+        case Precision::BFloat16: return RoundBFloat16{}(f);
+    }
+    return f;
+}
+
+/// Tiles are whole 64-byte lines of floats.
+constexpr std::size_t kTileFloats = 16;
+
+/// Most tiles evaluated in double after a failed one before retrying.
+constexpr std::size_t kMaxBackoff = 64;
+
+}  // namespace
+
+double unit_roundoff(Precision precision) noexcept {
+    switch (precision) {
+        case Precision::Float: return 0x1p-24;
+        case Precision::Half: return 0x1p-11;
+        case Precision::BFloat16: return 0x1p-8;
+    }
+    return 1.0;
+}
+
+MixedPrecisionEvaluator::MixedPrecisionEvaluator(const Program& program,
+                                                 MixedPrecisionOptions options, std::size_t tile)
+    : program_(program),
+      options_(options),
+      tile_(std::max(kTileFloats, (tile + kTileFloats - 1) / kTileFloats * kTileFloats)),
+      kappa_(static_cast<float>(std::max(
+          1.0, options.max_cancellation > 0.0 ? options.max_cancellation
+                                              : options.tolerance / unit_roundoff(options.precision)))),
+      risk_(tile_),
+      flagged_(tile_),
+      sampled_(tile_),
+      fallback_(program, tile_),
+      in_ptr_(program.num_inputs()),
+      out_ptr_(program.num_outputs()),
+      lanes_(program.num_inputs() + program.num_outputs(), std::vector<double>(tile_)),
+      redo_in_(program.num_inputs()),
+      redo_out_(program.num_outputs()) {
+    for (std::size_t i = 0; i < redo_in_.size(); ++i)
+        redo_in_[i] = lanes_[i].data();
+    for (std::size_t r = 0; r < redo_out_.size(); ++r)
+        redo_out_[r] = lanes_[redo_in_.size() + r].data();
+    const std::size_t rows = program_.num_slots();
+    scratch_ = std::make_unique<float[]>(rows * tile_ + kTileFloats);
+    auto addr = reinterpret_cast<std::uintptr_t>(scratch_.get());
+    float* aligned = scratch_.get() + ((64 - addr % 64) % 64) / sizeof(float);
+    slot_ptr_.resize(rows);
+    for (std::size_t s = 0; s < rows; ++s)
+        slot_ptr_[s] = aligned + s * tile_;
+    // Constants never change, so their rows are filled once.
+    const auto constants = program_.constants();
+    for (std::size_t c = 0; c < constants.size(); ++c)
+        std::fill_n(slot_ptr_[program_.const_base() + c], tile_,
+                    round_to(options_.precision, constants[c]));
+}
+
+void MixedPrecisionEvaluator::redo(std::span<const double* const> inputs, std::size_t p0,
+                                   std::span<const std::uint32_t> lanes) {
+    const std::size_t count = lanes.size();
+    for (std::size_t i = 0; i < redo_in_.size(); ++i) {
+        const double* in = inputs[i] + p0;
+        for (std::size_t k = 0; k < count; ++k)
+            lanes_[i][k] = in[lanes[k]];
+    }
+    fallback_(redo_in_, redo_out_, count);
+}
+
+bool MixedPrecisionEvaluator::run_tile(std::span<const double* const> inputs,
+                                       std::span<double* const> outputs, std::size_t p0,
+                                       std::size_t len) {
+    std::fill_n(risk_.begin(), len, 0.0f);
+    switch (options_.precision) {
+        case Precision::Float:
+            run_reduced<RoundFloat>(program_, slot_ptr_, inputs, outputs, p0, len, kappa_,
+                                    risk_.data());
+            break;
+        case Precision::Half:
+            run_reduced<RoundHalf>(program_, slot_ptr_, inputs, outputs, p0, len, kappa_,
+                                   risk_.data());
+            break;
+        case Precision::BFloat16:
+            run_reduced<RoundBFloat16>(program_, slot_ptr_, inputs, outputs, p0, len, kappa_,
+                                       risk_.data());
+            break;
+    }
+    // Most tiles have no flagged lane; one vectorized pass tells.
+    int any = 0;
+    for (std::size_t j = 0; j < len; ++j)
+        any |= !(risk_[j] <= 0.0f);
+    std::size_t num_flagged = 0;
+    if (any)
+        for (std::size_t j = 0; j < len; ++j)
+            if (!(risk_[j] <= 0.0f))
+                flagged_[num_flagged++] = static_cast<std::uint32_t>(j);
+    if (double(num_flagged) > options_.max_flagged_fraction * double(len))
+        return false;
+
+    // Shadow samples, at an offset that moves from tile to tile. Flagged
+    // lanes are skipped: they are redone below anyway.
+    std::size_t sampled = 0;
+    if (const std::size_t stride = options_.sample_stride; stride != 0) {
+        const std::size_t start = (tiles_seen_++ * 0x9e3779b1u) % std::min(stride, len);
+        for (std::size_t j = start; j < len; j += stride)
+            if (risk_[j] <= 0.0f)
+                sampled_[sampled++] = static_cast<std::uint32_t>(j);
+        redo(inputs, p0, std::span(sampled_).first(sampled));
+        stats_.sampled_points += sampled;
+        bool accept = true;
+        for (std::size_t r = 0; r < redo_out_.size(); ++r) {
+            double err = 0.0, scale = 0.0;
+            double* out = outputs[r] + p0;
+            for (std::size_t k = 0; k < sampled; ++k) {
+                const double y = redo_out_[r][k];
+                if (std::isfinite(y)) {
+                    err = std::max(err, std::abs(out[sampled_[k]] - y));
+                    scale = std::max(scale, std::abs(y));
+                }
+                out[sampled_[k]] = y;
+            }
+            if (scale > 0.0)
+                stats_.max_sampled_error = std::max(stats_.max_sampled_error, err / scale);
+            accept &= err <= options_.tolerance * scale + options_.absolute_tolerance;
+        }
+        if (!accept)
+            return false;
+    }
+
+    if (num_flagged != 0) {
+        redo(inputs, p0, std::span(flagged_).first(num_flagged));
+        for (std::size_t r = 0; r < redo_out_.size(); ++r)
+            for (std::size_t k = 0; k < num_flagged; ++k)
+                outputs[r][p0 + flagged_[k]] = redo_out_[r][k];
+    }
+    stats_.recomputed_points += num_flagged;
+    stats_.reduced_points += len - num_flagged - sampled;
+    FTE_PROFILE_COUNT(EvaluatedPoints, len - num_flagged - sampled);
+    return true;
+}
+
+void MixedPrecisionEvaluator::operator()(std::span<const double* const> inputs,
+                                         std::span<double* const> outputs, std::size_t n) {
+    FTE_PROFILE_SCOPE(Evaluate);
+    if (inputs.size() < program_.num_inputs() || outputs.size() < program_.num_outputs())
+        throw std::invalid_argument("MixedPrecisionEvaluator: too few input or output columns");
+    for (std::size_t p0 = 0; p0 < n; p0 += tile_) {
+        const std::size_t len = std::min(tile_, n - p0);
+        if (skip_ > 0) {
+            --skip_;
+        } else if (run_tile(inputs, outputs, p0, len)) {
+            backoff_ = 0;
+            continue;
+        } else {
+            // Neighbouring tiles tend to fail alike: go straight to double
+            // for a while, longer after each failed retry.
+            backoff_ = std::min(kMaxBackoff, backoff_ == 0 ? std::size_t(1) : 2 * backoff_);
+            skip_ = backoff_;
+        }
+        for (std::size_t i = 0; i < in_ptr_.size(); ++i)
+            in_ptr_[i] = inputs[i] + p0;
+        for (std::size_t r = 0; r < out_ptr_.size(); ++r)
+            out_ptr_[r] = outputs[r] + p0;
+        fallback_(in_ptr_, out_ptr_, len);
+        ++stats_.fallback_tiles;
+        stats_.fallback_points += len;
+    }
+    stats_.points += n;
+}
+
+}  // namespace fte
@@ -0,0 +1,82 @@
+#include "fte/parallel.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "fte/batch.hpp"
+
+namespace fte {
+
+namespace {
+
+constexpr std::size_t kChunkBytes = 256 * 1024;
+
+}  // namespace
+
+std::size_t default_chunk(const Program& program) {
+    const std::size_t tile = BatchEvaluator::kDefaultTile;
+    const std::size_t columns = std::max<std::size_t>(1, program.num_inputs() + program.num_outputs());
+    const std::size_t points = kChunkBytes / (columns * sizeof(double));
+    return std::max(tile, points / tile * tile);
+}
+
+void evaluate_batch_parallel(ThreadPool& pool, const Program& program,
+                             std::span<const double* const> inputs,
+                             std::span<double* const> outputs, std::size_t n, std::size_t chunk) {
+    const Program* programs[] = {&program};
+    const std::span<double* const> outs[] = {outputs};
+    evaluate_batch_parallel(pool, programs, inputs, outs, n, chunk);
+}
+
+void evaluate_batch_parallel(ThreadPool& pool, std::span<const Program* const> programs,
+                             std::span<const double* const> inputs,
+                             std::span<const std::span<double* const>> outputs, std::size_t n,
+                             std::size_t chunk) {
+    if (outputs.size() != programs.size())
+        throw std::invalid_argument("evaluate_batch_parallel: one output set per program");
+    if (programs.empty() || n == 0)
+        return;
+    if (chunk == 0) {
+        chunk = default_chunk(*programs[0]);
+        for (const Program* p : programs)
+            chunk = std::min(chunk, default_chunk(*p));
+    }
+    // Keep enough chunks around for stealing to balance the load.
+    const std::size_t min_tasks = 4 * static_cast<std::size_t>(pool.size());
+    const std::size_t balanced = (n + min_tasks - 1) / min_tasks;
+    chunk = std::max(BatchEvaluator::kDefaultTile, std::min(chunk, balanced));
+    const std::size_t chunks = (n + chunk - 1) / chunk;
+
+    // Evaluators and column pointers per worker, created on first use.
+    struct alignas(64) WorkerState {
+        std::vector<std::unique_ptr<BatchEvaluator>> evals;
+        std::vector<const double*> in;
+        std::vector<double*> out;
+    };
+    const std::size_t np = programs.size();
+    std::vector<WorkerState> state(pool.size() + 1);
+
+    pool.parallel_for(chunks * np, 1, [&](std::size_t begin, std::size_t end) {
+        WorkerState& ws = state[pool.worker_index()];
+        if (ws.evals.empty())
+            ws.evals.resize(np);
+        for (std::size_t t = begin; t < end; ++t) {
+            const std::size_t k = t / chunks;
+            const std::size_t p0 = (t % chunks) * chunk;
+            const std::size_t len = std::min(chunk, n - p0);
+            if (!ws.evals[k])
+                ws.evals[k] = std::make_unique<BatchEvaluator>(*programs[k]);
+            ws.in.resize(inputs.size());
+            ws.out.resize(outputs[k].size());
+            for (std::size_t i = 0; i < inputs.size(); ++i)
+                ws.in[i] = inputs[i] + p0;
+            for (std::size_t r = 0; r < outputs[k].size(); ++r)
+                ws.out[r] = outputs[k][r] + p0;
+            (*ws.evals[k])(ws.in, ws.out, len);
+        }
+    });
+}
+
+}  // namespace fte
@@ -0,0 +1,261 @@
+#include "fte/parser.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#include "fte/hash.hpp"
+#include "fte/profile.hpp"
+
+namespace fte {
+
+SymbolTable::SymbolTable() : arena_(4096), table_(64, 0) {}
+
+std::size_t SymbolTable::probe(std::string_view name, std::uint64_t hash) const noexcept {
+    const std::size_t mask = table_.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask)
+        if (table_[i] == 0 || names_[table_[i] - 1] == name)
+            return i;
+}
+
+std::uint32_t SymbolTable::intern(std::string_view name) {
+    std::size_t i = probe(name, hash_bytes(name));
+    if (table_[i] != 0)
+        return table_[i] - 1;
+
+    char* copy = arena_.allocate_array<char>(name.size() + 1);
+    std::memcpy(copy, name.data(), name.size());
+    copy[name.size()] = '\0';
+    const auto symbol = static_cast<std::uint32_t>(names_.size());
+    names_.emplace_back(copy, name.size());
+    table_[i] = symbol + 1;
+    if (2 * names_.size() > table_.size())
+        grow_table();
+    return symbol;
+}
+
+std::optional<std::uint32_t> SymbolTable::find(std::string_view name) const noexcept {
+    const std::size_t i = probe(name, hash_bytes(name));
+    if (table_[i] == 0)
+        return std::nullopt;
+    return table_[i] - 1;
+}
+
+void SymbolTable::grow_table() {
+    table_.assign(table_.size() * 2, 0);
+    for (std::uint32_t s = 0; s < names_.size(); ++s)
+        table_[probe(names_[s], hash_bytes(names_[s]))] = s + 1;
+}
+
+std::vector<std::string> SymbolTable::names() const {
+    return std::vector<std::string>(names_.begin(), names_.end());
+}
+
+void SymbolTable::clear() {
+    arena_.reset();
+    names_.clear();
+    table_.assign(64, 0);
+}
+
+namespace {
+
+constexpr int kMaxDepth = 1000;
+
+bool is_ident_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool is_ident_char(char c) { return is_ident_start(c) || (c >= '0' && c <= '9'); }
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+struct Function {
+    std::string_view name;
+    Op op;
+};
+
+// The callable subset of `op_name`, grouped by length for a cheap first test.
+constexpr Function kFunctions[] = {
+    {"exp", Op::Exp},  {"log", Op::Log},  {"sin", Op::Sin},  {"cos", Op::Cos},
+    {"tan", Op::Tan},  {"neg", Op::Neg},  {"add", Op::Add},  {"sub", Op::Sub},
+    {"mul", Op::Mul},  {"div", Op::Div},  {"pow", Op::Pow},  {"sqrt", Op::Sqrt},
+    {"tanh", Op::Tanh},
+};
+
+std::optional<Op> function_op(std::string_view name) {
+    if (name.size() < 3 || name.size() > 4)
+        return std::nullopt;
+    for (const Function& f : kFunctions)
+        if (f.name.size() == name.size() && f.name == name)
+            return f.op;
+    return std::nullopt;
+}
+
+class Parser {
+public:
+    Parser(std::string_view text, ExprPool& pool, SymbolTable& symbols)
+        : text_(text), pool_(pool), symbols_(symbols) {}
+
+    const Node* run() {
+        const Node* e = expression();
+        peek();
+        if (pos_ != text_.size())
+            fail("unexpected character");
+        return e;
+    }
+
+private:
+    // expression := term (('+' | '-') term)*
+    const Node* expression() {
+        const Node* lhs = term();
+        for (;;) {
+            if (accept('+'))
+                lhs = pool_.add(lhs, term());
+            else if (accept('-'))
+                lhs = pool_.sub(lhs, term());
+            else
+                return lhs;
+        }
+    }
+
+    // term := unary (('*' | '/') unary)*
+    const Node* term() {
+        const Node* lhs = unary();
+        for (;;) {
+            if (accept('*'))
+                lhs = pool_.mul(lhs, unary());
+            else if (accept('/'))
+                lhs = pool_.div(lhs, unary());
+            else
+                return lhs;
+        }
+    }
+
+    // unary := ('-' | '+') unary | power
+    const Node* unary() {
+        if (++depth_ > kMaxDepth)
+            fail("expression nested too deeply");
+        const Node* e;
+        if (accept('-'))
+            e = pool_.neg(unary());
+        else if (accept('+'))
+            e = unary();
+        else
+            e = power();
+        --depth_;
+        return e;
+    }
+
+    // power := primary (('^' | '**') unary)?
+    const Node* power() {
+        const Node* base = primary();
+        const char c = peek();
+        if (c == '^') {
+            ++pos_;
+            return pool_.pow(base, unary());
+        }
+        if (c == '*' && pos_ + 1 < text_.size() && text_[pos_ + 1] == '*') {
+            pos_ += 2;
+            return pool_.pow(base, unary());
+        }
+        return base;
+    }
+
+    // primary := number | identifier | identifier '(' args ')' | '(' expression ')'
+    const Node* primary() {
+        const char c = peek();
+        if (is_digit(c) || c == '.')
+            return number();
+        if (is_ident_start(c))
+            return identifier();
+        if (accept('(')) {
+            const Node* e = expression();
+            expect(')');
+            return e;
+        }
+        fail(c == '\0' ? "unexpected end of input" : "expected an operand");
+    }
+
+    const Node* number() {
+        double v = 0.0;
+        const char* first = text_.data() + pos_;
+        const auto [ptr, ec] = std::from_chars(first, text_.data() + text_.size(), v);
+        if (ec != std::errc{})
+            fail("malformed number");
+        pos_ += static_cast<std::size_t>(ptr - first);
+        return pool_.constant(v);
+    }
+
+    const Node* identifier() {
+        const std::size_t start = pos_;
+        while (pos_ < text_.size() && is_ident_char(text_[pos_]))
+            ++pos_;
+        const std::string_view name = text_.substr(start, pos_ - start);
+        if (!accept('(')) {
+            // What the printer writes for non-finite constants.
+            if (name == "inf")
+                return pool_.constant(std::numeric_limits<double>::infinity());
+            if (name == "nan")
+                return pool_.constant(std::numeric_limits<double>::quiet_NaN());
+            return pool_.variable(symbols_.intern(name));
+        }
+
+        const std::optional<Op> op = function_op(name);
+        if (!op)
+            fail("unknown function", start);
+        const Node* a = expression();
+        const Node* b = nullptr;
+        if (arity(*op) == 2) {
+            expect(',');
+            b = expression();
+        }
+        expect(')');
+        return pool_.make(*op, a, b);
+    }
+
+    char peek() {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+                text_[pos_] == '\r'))
+            ++pos_;
+        return pos_ < text_.size() ? text_[pos_] : '\0';
+    }
+
+    bool accept(char c) {
+        if (peek() != c)
+            return false;
+        ++pos_;
+        return true;
+    }
+
+    void expect(char c) {
+        if (!accept(c))
+            fail(c == ')' ? "expected ')'" : "expected ','");
+    }
+
+    [[noreturn]] void fail(const char* what) { fail(what, pos_); }
+
+    [[noreturn]] void fail(const char* what, std::size_t at) {
+        std::string msg = "parse error at offset ";
+        msg += std::to_string(at);
+        msg += ": ";
+        msg += what;
+        throw ParseError(msg, at);
+    }
+
+    std::string_view text_;
+    ExprPool& pool_;
+    SymbolTable& symbols_;
+    std::size_t pos_ = 0;
+    int depth_ = 0;
+};
+
+}  // namespace
+
+const Node* parse(std::string_view text, ExprPool& pool, SymbolTable& symbols) {
+    FTE_PROFILE_SCOPE(Parse);
+    FTE_PROFILE_COUNT(ParsedBytes, text.size());
+    return Parser(text, pool, symbols).run();
+}
+
+}  // namespace fte
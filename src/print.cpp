@@ -0,0 +1,91 @@
+#include "fte/print.hpp"
+
+#include <charconv>
+#include <cmath>
+
+namespace fte {
+
+namespace {
+
+int precedence(Op op) {
+    switch (op) {
+        case Op::Add:
+        case Op::Sub: return 1;
+        case Op::Mul:
+        case Op::Div: return 2;
+        case Op::Neg: return 3;
+        case Op::Pow: return 4;
+        default: return 5;
+    }
+}
+
+void print(const Node* n, std::span<const std::string> names, std::string& out) {
+    auto child = [&](const Node* c, int min_prec) {
+        const bool paren = precedence(c->op) < min_prec ||
+                           (c->is_const() && c->value < 0.0 && min_prec > 1);
+        if (paren)
+            out += '(';
+        print(c, names, out);
+        if (paren)
+            out += ')';
+    };
+
+    switch (n->op) {
+        case Op::Const: {
+            // `to_chars` would write "-nan" for some NaNs, which the parser
+            // reads as a negation.
+            if (std::isnan(n->value)) {
+                out += "nan";
+                return;
+            }
+            char buf[32];
+            auto res = std::to_chars(buf, buf + sizeof buf, n->value);
+            out.append(buf, res.ptr);
+            return;
+        }
+        case Op::Var:
+            if (n->var < names.size()) {
+                out += names[n->var];
+            } else {
+                out += 'x';
+                out += std::to_string(n->var);
+            }
+            return;
+        case Op::Neg:
+            out += '-';
+            child(n->arg[0], precedence(Op::Neg));
+            return;
+        case Op::Add:
+        case Op::Sub:
+        case Op::Mul:
+        case Op::Div: {
+            const int p = precedence(n->op);
+            static constexpr const char* sym[] = {" + ", " - ", "*", "/"};
+            child(n->arg[0], p);
+            out += sym[static_cast<int>(n->op) - static_cast<int>(Op::Add)];
+            child(n->arg[1], p + 1);  // left associative
+            return;
+        }
+        case Op::Pow:
+            child(n->arg[0], precedence(Op::Pow) + 1);  // right associative
+            out += '^';
+            child(n->arg[1], precedence(Op::Pow));
+            return;
+        default:
+            out += op_name(n->op);
+            out += '(';
+            print(n->arg[0], names, out);
+            out += ')';
+            return;
+    }
+}
+
+}  // namespace
+
+std::string to_string(const Node* root, std::span<const std::string> names) {
+    std::string out;
+    print(root, names, out);
+    return out;
+}
+
+}  // namespace fte
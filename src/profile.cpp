@@ -0,0 +1,258 @@
+#include "fte/profile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fte::profile {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point kEpoch = Clock::now();
+
+struct Event {
+    std::uint64_t start;  // ticks
+    std::uint64_t duration;
+    Phase phase;
+};
+
+/// Counters of one thread. Only the owning thread writes them, with plain
+/// relaxed loads and stores; readers hold the registry lock.
+struct ThreadData {
+    std::uint32_t tid = 0;
+    std::array<std::atomic<std::uint64_t>, kNumPhases> calls{};
+    std::array<std::atomic<std::uint64_t>, kNumPhases> total{};  // ticks
+    std::array<std::atomic<std::uint64_t>, kNumPhases> max{};
+    std::array<std::atomic<std::uint64_t>, kNumCounters> counters{};
+    // Values at the last `reset`, owned by the readers.
+    std::array<std::uint64_t, kNumPhases> base_calls{};
+    std::array<std::uint64_t, kNumPhases> base_total{};
+    std::array<std::uint64_t, kNumCounters> base_counters{};
+
+    std::mutex events_mutex;  // uncontended except while exporting
+    std::vector<Event> events;  // a ring once full
+    std::size_t next_event = 0;
+};
+
+struct Registry {
+    // Common origin of `ticks()` and `now_ns()` for converting between them.
+    std::uint64_t origin_ticks = ticks();
+    std::uint64_t origin_ns = now_ns();
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadData>> threads;
+    std::atomic<bool> tracing{false};
+    std::atomic<std::size_t> capacity{std::size_t(1) << 16};
+};
+
+/// Never destroyed, so that threads outliving `main` can still record.
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+thread_local ThreadData* t_data = nullptr;
+
+ThreadData& local() {
+    if (!t_data) {
+        Registry& r = registry();
+        std::lock_guard lock(r.mutex);
+        r.threads.push_back(std::make_unique<ThreadData>());
+        t_data = r.threads.back().get();
+        t_data->tid = static_cast<std::uint32_t>(r.threads.size());
+    }
+    return *t_data;
+}
+
+/// Nanoseconds per tick, measured against the system clock since the
+/// registry was created.
+double ns_per_tick() {
+#if !((defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__))
+    return 1.0;
+#endif
+    const Registry& r = registry();
+    // Let at least 10 ms elapse for a precise ratio.
+    std::uint64_t t = ticks(), ns = now_ns();
+    while (ns - r.origin_ns < 10'000'000) {
+        t = ticks();
+        ns = now_ns();
+    }
+    return double(ns - r.origin_ns) / double(t - r.origin_ticks);
+}
+
+inline void bump(std::atomic<std::uint64_t>& a, std::uint64_t n) noexcept {
+    a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline std::uint64_t get(const std::atomic<std::uint64_t>& a) noexcept {
+    return a.load(std::memory_order_relaxed);
+}
+
+constexpr const char* kPhaseNames[kNumPhases] = {
+    "parse", "differentiate", "simplify", "codegen", "cache_lookup", "evaluate",
+};
+constexpr const char* kCounterNames[kNumCounters] = {
+    "parsed_bytes", "cache_hits", "cache_misses", "cache_evictions", "evaluated_points",
+};
+
+void append(std::string& out, const char* fmt, auto... args) {
+    char buf[256];
+    const int n = std::snprintf(buf, sizeof buf, fmt, args...);
+    out.append(buf, static_cast<std::size_t>(std::clamp(n, 0, int(sizeof buf) - 1)));
+}
+
+}  // namespace
+
+const char* phase_name(Phase phase) noexcept { return kPhaseNames[static_cast<std::size_t>(phase)]; }
+
+const char* counter_name(Counter counter) noexcept {
+    return kCounterNames[static_cast<std::size_t>(counter)];
+}
+
+std::uint64_t now_ns() noexcept {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - kEpoch).count());
+}
+
+void record(Phase phase, std::uint64_t start_ticks, std::uint64_t end_ticks) noexcept {
+    ThreadData& d = local();
+    const std::size_t p = static_cast<std::size_t>(phase);
+    const std::uint64_t dur = end_ticks - start_ticks;
+    bump(d.calls[p], 1);
+    bump(d.total[p], dur);
+    if (dur > get(d.max[p]))
+        d.max[p].store(dur, std::memory_order_relaxed);
+
+    Registry& r = registry();
+    if (!r.tracing.load(std::memory_order_relaxed))
+        return;
+    const std::size_t cap = r.capacity.load(std::memory_order_relaxed);
+    std::lock_guard lock(d.events_mutex);
+    try {
+        if (d.events.size() < cap) {
+            d.events.push_back({start_ticks, dur, phase});
+        } else if (!d.events.empty()) {
+            d.events[d.next_event] = {start_ticks, dur, phase};
+            d.next_event = (d.next_event + 1) % d.events.size();
+        }
+    } catch (...) {
+        // Out of memory for the trace: drop the event, keep the counters.
+    }
+}
+
+void count(Counter counter, std::uint64_t n) noexcept {
+    bump(local().counters[static_cast<std::size_t>(counter)], n);
+}
+
+Snapshot snapshot() {
+    Snapshot s;
+    const double scale = ns_per_tick();
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    s.threads = r.threads.size();
+    for (const auto& d : r.threads) {
+        for (std::size_t p = 0; p < kNumPhases; ++p) {
+            s.phases[p].calls += get(d->calls[p]) - d->base_calls[p];
+            s.phases[p].total_ns += get(d->total[p]) - d->base_total[p];
+            s.phases[p].max_ns = std::max(s.phases[p].max_ns, get(d->max[p]));
+        }
+        for (std::size_t c = 0; c < kNumCounters; ++c)
+            s.counters[c] += get(d->counters[c]) - d->base_counters[c];
+    }
+    for (PhaseStats& p : s.phases) {
+        p.total_ns = static_cast<std::uint64_t>(p.total_ns * scale);
+        p.max_ns = static_cast<std::uint64_t>(p.max_ns * scale);
+    }
+    return s;
+}
+
+void reset() {
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    for (const auto& d : r.threads) {
+        for (std::size_t p = 0; p < kNumPhases; ++p) {
+            d->base_calls[p] = get(d->calls[p]);
+            d->base_total[p] = get(d->total[p]);
+            d->max[p].store(0, std::memory_order_relaxed);
+        }
+        for (std::size_t c = 0; c < kNumCounters; ++c)
+            d->base_counters[c] = get(d->counters[c]);
+        std::lock_guard events_lock(d->events_mutex);
+        d->events.clear();
+        d->next_event = 0;
+    }
+}
+
+void set_tracing(bool on, std::size_t events_per_thread) {
+    Registry& r = registry();
+    r.capacity.store(events_per_thread, std::memory_order_relaxed);
+    r.tracing.store(on, std::memory_order_relaxed);
+}
+
+bool tracing() noexcept { return registry().tracing.load(std::memory_order_relaxed); }
+
+std::string chrome_trace() {
+    std::string out = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    auto sep = [&] {
+        out += first ? "\n" : ",\n";
+        first = false;
+    };
+    const double scale = ns_per_tick();
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    for (const auto& d : r.threads) {
+        sep();
+        append(out,
+               "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, "
+               "\"args\": {\"name\": \"fte thread %u\"}}",
+               d->tid, d->tid);
+        std::lock_guard events_lock(d->events_mutex);
+        // Oldest first: the ring's tail, then its head.
+        const std::size_t n = d->events.size();
+        for (std::size_t k = 0; k < n; ++k) {
+            const Event& e = d->events[(d->next_event + k) % n];
+            sep();
+            append(out,
+                   "{\"name\": \"%s\", \"cat\": \"fte\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+                   "\"ts\": %.3f, \"dur\": %.3f}",
+                   phase_name(e.phase), d->tid, double(e.start - r.origin_ticks) * scale * 1e-3,
+                   double(e.duration) * scale * 1e-3);
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+std::string prometheus_text() {
+    const Snapshot s = snapshot();
+    std::string out;
+    auto phase_metric = [&](const char* name, const char* type, const char* help, auto value) {
+        append(out, "# HELP fte_%s %s\n# TYPE fte_%s %s\n", name, help, name, type);
+        for (std::size_t p = 0; p < kNumPhases; ++p) {
+            append(out, "fte_%s{phase=\"%s\"} ", name, kPhaseNames[p]);
+            append(out, "%.9g\n", value(s.phases[p]));
+        }
+    };
+    phase_metric("phase_calls_total", "counter", "Instrumented calls per phase.",
+                 [](const PhaseStats& p) { return double(p.calls); });
+    phase_metric("phase_seconds_total", "counter", "Inclusive wall time per phase.",
+                 [](const PhaseStats& p) { return p.total_ns * 1e-9; });
+    phase_metric("phase_seconds_max", "gauge", "Longest single call per phase.",
+                 [](const PhaseStats& p) { return p.max_ns * 1e-9; });
+    for (std::size_t c = 0; c < kNumCounters; ++c)
+        append(out, "# TYPE fte_%s_total counter\nfte_%s_total %llu\n", kCounterNames[c],
+               kCounterNames[c], static_cast<unsigned long long>(s.counters[c]));
+    append(out, "# HELP fte_profiled_threads Threads that have recorded data.\n"
+                "# TYPE fte_profiled_threads gauge\nfte_profiled_threads %zu\n",
+           s.threads);
+    return out;
+}
+
+}  // namespace fte::profile
@@ -0,0 +1,120 @@
+#include "fte/program.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "fte/derivative.hpp"
+#include "fte/eval.hpp"
+#include "fte/profile.hpp"
+
+namespace fte {
+
+Program linearize(std::span<const Node* const> roots, std::uint32_t num_inputs,
+                  const LinearizeOptions& options) {
+    FTE_PROFILE_SCOPE(Codegen);
+    constexpr std::uint32_t kForever = std::numeric_limits<std::uint32_t>::max();
+
+    Program p;
+    p.num_inputs_ = num_inputs;
+    p.ssa_ = !options.reuse_slots;
+
+    const std::vector<const Node*> order = topo_order(roots);
+    std::unordered_map<const Node*, std::uint32_t> pos;
+    pos.reserve(order.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i)
+        pos.emplace(order[i], i);
+
+    // Constants go first so that temporaries start at a known base.
+    std::vector<std::uint32_t> slot(order.size(), kForever);
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        const Node* n = order[i];
+        if (n->op == Op::Var) {
+            if (n->var >= num_inputs)
+                throw std::out_of_range("linearize: variable index exceeds num_inputs");
+            slot[i] = n->var;
+        } else if (n->op == Op::Const) {
+            slot[i] = num_inputs + static_cast<std::uint32_t>(p.constants_.size());
+            p.constants_.push_back(n->value);
+        }
+    }
+
+    // Position of the last instruction reading each value; outputs live forever.
+    std::vector<std::uint32_t> last_use(order.size(), 0);
+    for (std::uint32_t i = 0; i < order.size(); ++i)
+        for (int k = 0; k < arity(order[i]->op); ++k)
+            last_use[pos.at(order[i]->arg[k])] = i;
+    for (const Node* r : roots)
+        last_use[pos.at(r)] = kForever;
+
+    std::uint32_t next = num_inputs + static_cast<std::uint32_t>(p.constants_.size());
+    std::vector<std::uint32_t> free_slots;
+    p.code_.reserve(order.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        const Node* n = order[i];
+        if (arity(n->op) == 0)
+            continue;
+        const std::uint32_t a = slot[pos.at(n->arg[0])];
+        const std::uint32_t b = arity(n->op) == 2 ? slot[pos.at(n->arg[1])] : a;
+
+        // Operands are read before the result is written, so a dying
+        // operand's slot may be reused for the result itself.
+        if (options.reuse_slots) {
+            for (int k = 0; k < arity(n->op); ++k) {
+                const std::uint32_t c = pos.at(n->arg[k]);
+                if (last_use[c] == i && arity(order[c]->op) != 0 &&
+                    (k == 0 || n->arg[1] != n->arg[0]))
+                    free_slots.push_back(slot[c]);
+            }
+        }
+        std::uint32_t dst;
+        if (!free_slots.empty()) {
+            dst = free_slots.back();
+            free_slots.pop_back();
+        } else {
+            dst = next++;
+        }
+        slot[i] = dst;
+        p.code_.push_back(Instr{n->op, dst, a, b});
+    }
+    p.num_slots_ = next;
+
+    p.outputs_.reserve(roots.size());
+    for (const Node* r : roots)
+        p.outputs_.push_back(slot[pos.at(r)]);
+    return p;
+}
+
+void Program::eval(std::span<const double> x, std::span<double> out,
+                   std::span<double> slots) const {
+    FTE_PROFILE_SCOPE(Evaluate);
+    FTE_PROFILE_COUNT(EvaluatedPoints, 1);
+    if (x.size() < num_inputs_ || out.size() < outputs_.size() || slots.size() < num_slots_)
+        throw std::invalid_argument("Program::eval: span too small");
+    double* s = slots.data();
+    std::copy_n(x.data(), num_inputs_, s);
+    std::copy(constants_.begin(), constants_.end(), s + num_inputs_);
+    for (const Instr& in : code_)
+        s[in.dst] = apply_op(in.op, s[in.a], s[in.b]);
+    for (std::size_t r = 0; r < outputs_.size(); ++r)
+        out[r] = s[outputs_[r]];
+}
+
+void Program::eval(std::span<const double> x, std::span<double> out) const {
+    std::vector<double> slots(num_slots_);
+    eval(x, out, slots);
+}
+
+Program gradient_program(ExprPool& pool, const Node* f, std::uint32_t num_vars,
+                         const LinearizeOptions& options) {
+    std::vector<const Node*> roots;
+    roots.reserve(num_vars + 1);
+    roots.push_back(f);
+    Differentiator d(pool);
+    for (std::uint32_t v = 0; v < num_vars; ++v)
+        roots.push_back(d(f, v));
+    return linearize(roots, num_vars, options);
+}
+
+}  // namespace fte
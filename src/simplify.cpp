@@ -0,0 +1,555 @@
+#include "fte/simplify.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include "fte/eval.hpp"
+#include "fte/hash.hpp"
+#include "fte/profile.hpp"
+
+namespace fte {
+
+double op_cost(Op op) noexcept {
+    switch (op) {
+        case Op::Const:
+        case Op::Var: return 0.0;
+        case Op::Neg:
+        case Op::Add:
+        case Op::Sub:
+        case Op::Mul: return 1.0;
+        case Op::Div:
+        case Op::Sqrt: return 4.0;
+        case Op::Exp:
+        case Op::Log:
+        case Op::Sin:
+        case Op::Cos:
+        case Op::Tan:
+        case Op::Tanh:
+        case Op::Pow: return 16.0;
+    }
+    return 1.0;
+}
+
+double dag_cost(std::span<const Node* const> roots) {
+    double c = 0.0;
+    for (const Node* n : topo_order(roots))
+        c += op_cost(n->op);
+    return c;
+}
+
+namespace {
+
+using ClassId = std::uint32_t;
+constexpr ClassId kNone = std::numeric_limits<ClassId>::max();
+
+/// True if `1 / k` is exact, so that `x / k` and `x * (1 / k)` round alike:
+/// `k` is a power of two whose reciprocal is representable.
+bool exact_reciprocal(double k) noexcept {
+    int e;
+    const double r = 1.0 / k;
+    return std::isfinite(r) && r != 0.0 && std::abs(std::frexp(k, &e)) == 0.5;
+}
+
+struct ENode {
+    Op op;
+    std::uint32_t var = 0;
+    double value = 0.0;
+    ClassId child[2] = {kNone, kNone};
+
+    friend bool operator==(const ENode& a, const ENode& b) noexcept {
+        return a.op == b.op && a.var == b.var &&
+               std::bit_cast<std::uint64_t>(a.value) == std::bit_cast<std::uint64_t>(b.value) &&
+               a.child[0] == b.child[0] && a.child[1] == b.child[1];
+    }
+};
+
+struct ENodeHash {
+    std::size_t operator()(const ENode& n) const noexcept {
+        std::uint64_t h = mix64(static_cast<std::uint64_t>(n.op));
+        h = hash_combine(h, n.var);
+        h = hash_combine(h, std::bit_cast<std::uint64_t>(n.value));
+        h = hash_combine(h, n.child[0]);
+        return hash_combine(h, n.child[1]);
+    }
+};
+
+struct EClass {
+    std::vector<ENode> nodes;
+    bool is_const = false;
+    double value = 0.0;
+};
+
+class EGraph {
+public:
+    ClassId find(ClassId c) {
+        while (parent_[c] != c) {
+            parent_[c] = parent_[parent_[c]];
+            c = parent_[c];
+        }
+        return c;
+    }
+
+    ENode canonical(ENode n) {
+        for (int i = 0; i < arity(n.op); ++i)
+            n.child[i] = find(n.child[i]);
+        return n;
+    }
+
+    ClassId add(ENode n) {
+        n = canonical(n);
+        if (auto it = memo_.find(n); it != memo_.end())
+            return find(it->second);
+        const ClassId id = static_cast<ClassId>(parent_.size());
+        parent_.push_back(id);
+        EClass c;
+        if (n.op == Op::Const) {
+            c.is_const = true;
+            c.value = n.value;
+        }
+        c.nodes.push_back(n);
+        classes_.push_back(std::move(c));
+        memo_.emplace(n, id);
+        ++num_nodes_;
+        return id;
+    }
+
+    ClassId leaf_const(double v) {
+        ENode n{Op::Const};
+        n.value = v;
+        return add(n);
+    }
+    ClassId unary(Op op, ClassId a) {
+        ENode n{op};
+        n.child[0] = a;
+        return add(n);
+    }
+    ClassId binary(Op op, ClassId a, ClassId b) {
+        ENode n{op};
+        n.child[0] = a;
+        n.child[1] = b;
+        return add(n);
+    }
+
+    ClassId add_expr(const Node* root, std::unordered_map<const Node*, ClassId>& seen) {
+        for (const Node* n : topo_order(root)) {
+            if (seen.count(n))
+                continue;
+            ENode e{n->op};
+            if (n->op == Op::Const)
+                e.value = n->value;
+            else if (n->op == Op::Var)
+                e.var = n->var;
+            for (int i = 0; i < arity(n->op); ++i)
+                e.child[i] = seen.at(n->arg[i]);
+            seen.emplace(n, add(e));
+        }
+        return seen.at(root);
+    }
+
+    bool merge(ClassId a, ClassId b) {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return false;
+        if (classes_[a].nodes.size() < classes_[b].nodes.size())
+            std::swap(a, b);
+        parent_[b] = a;
+        EClass& ca = classes_[a];
+        EClass& cb = classes_[b];
+        ca.nodes.insert(ca.nodes.end(), cb.nodes.begin(), cb.nodes.end());
+        if (cb.is_const && !ca.is_const) {
+            ca.is_const = true;
+            ca.value = cb.value;
+        }
+        cb.nodes.clear();
+        cb.nodes.shrink_to_fit();
+        dirty_ = true;
+        return true;
+    }
+
+    /// Restore congruence: nodes whose canonical forms coincide must live in
+    /// the same class. Full re-canonicalization; the graphs here are small.
+    void rebuild() {
+        while (dirty_) {
+            dirty_ = false;
+            memo_.clear();
+            std::vector<std::pair<ClassId, ClassId>> pending;
+            num_nodes_ = 0;
+            for (ClassId c = 0; c < classes_.size(); ++c) {
+                if (find(c) != c)
+                    continue;
+                auto& nodes = classes_[c].nodes;
+                for (ENode& n : nodes)
+                    n = canonical(n);
+                std::sort(nodes.begin(), nodes.end(), [](const ENode& x, const ENode& y) {
+                    return std::tuple(x.op, x.var, std::bit_cast<std::uint64_t>(x.value),
+                                      x.child[0], x.child[1]) <
+                           std::tuple(y.op, y.var, std::bit_cast<std::uint64_t>(y.value),
+                                      y.child[0], y.child[1]);
+                });
+                nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+                num_nodes_ += nodes.size();
+                for (const ENode& n : nodes) {
+                    auto [it, inserted] = memo_.emplace(n, c);
+                    if (!inserted && find(it->second) != c)
+                        pending.emplace_back(it->second, c);
+                }
+            }
+            for (auto [a, b] : pending)
+                merge(a, b);
+        }
+    }
+
+    std::vector<ClassId> roots() {
+        std::vector<ClassId> out;
+        for (ClassId c = 0; c < classes_.size(); ++c)
+            if (find(c) == c)
+                out.push_back(c);
+        return out;
+    }
+
+    const std::vector<ENode>& nodes(ClassId c) { return classes_[find(c)].nodes; }
+    bool is_const(ClassId c, double* v = nullptr) {
+        const EClass& k = classes_[find(c)];
+        if (k.is_const && v)
+            *v = k.value;
+        return k.is_const;
+    }
+    bool is_const_value(ClassId c, double v) {
+        double x;
+        return is_const(c, &x) && x == v;
+    }
+    std::size_t num_nodes() const noexcept { return num_nodes_; }
+    std::size_t num_classes() const noexcept { return classes_.size(); }
+
+private:
+    std::vector<ClassId> parent_;
+    std::vector<EClass> classes_;
+    std::unordered_map<ENode, ClassId, ENodeHash> memo_;
+    std::size_t num_nodes_ = 0;
+    bool dirty_ = false;
+};
+
+/// Applies every rewrite once to every e-node present at the start of the
+/// pass. Returns false if the pass was cut short by the deadline.
+class Rewriter {
+public:
+    Rewriter(EGraph& g, std::chrono::steady_clock::time_point deadline, std::size_t node_limit)
+        : g_(g), deadline_(deadline), node_limit_(node_limit) {}
+
+    bool run() {
+        for (ClassId c : g_.roots()) {
+            const std::vector<ENode> nodes = g_.nodes(c);
+            for (const ENode& n : nodes) {
+                if (out_of_budget())
+                    return false;
+                rewrite(c, n);
+            }
+        }
+        return true;
+    }
+
+    bool changed() const noexcept { return changed_; }
+
+private:
+    bool out_of_budget() const {
+        return g_.num_nodes() > node_limit_ || std::chrono::steady_clock::now() > deadline_;
+    }
+
+    void equate(ClassId c, ClassId d) { changed_ |= g_.merge(c, d); }
+
+    // Classes whose e-nodes have operation `op`, as (a, b) child pairs.
+    template <class F>
+    void each(ClassId c, Op op, F&& f) {
+        const std::vector<ENode> nodes = g_.nodes(c);
+        for (const ENode& n : nodes) {
+            if (out_of_budget())
+                return;
+            if (n.op == op)
+                f(n.child[0], n.child[1]);
+        }
+    }
+
+    void rewrite(ClassId c, const ENode& n) {
+        const ClassId a = n.child[0];
+        const ClassId b = n.child[1];
+        double ka = 0.0, kb = 0.0;
+        const bool ca = arity(n.op) >= 1 && g_.is_const(a, &ka);
+        const bool cb = arity(n.op) == 2 && g_.is_const(b, &kb);
+
+        // Constant folding.
+        if (arity(n.op) == 1 && ca) {
+            equate(c, g_.leaf_const(apply_op(n.op, ka, 0.0)));
+            return;
+        }
+        if (arity(n.op) == 2 && ca && cb) {
+            equate(c, g_.leaf_const(apply_op(n.op, ka, kb)));
+            return;
+        }
+
+        switch (n.op) {
+            case Op::Neg:
+                each(a, Op::Neg, [&](ClassId x, ClassId) { equate(c, x); });
+                break;
+            case Op::Add:
+                if (ca && ka == 0.0) equate(c, b);
+                if (cb && kb == 0.0) equate(c, a);
+                equate(c, g_.binary(Op::Add, b, a));
+                if (g_.find(a) == g_.find(b))
+                    equate(c, g_.binary(Op::Mul, g_.leaf_const(2.0), a));
+                each(a, Op::Add, [&](ClassId x, ClassId y) {
+                    equate(c, g_.binary(Op::Add, x, g_.binary(Op::Add, y, b)));
+                });
+                each(b, Op::Neg, [&](ClassId x, ClassId) { equate(c, g_.binary(Op::Sub, a, x)); });
+                factor(c, a, b, Op::Add);
+                trig_identity(c, a, b);
+                break;
+            case Op::Sub:
+                if (cb && kb == 0.0) equate(c, a);
+                if (ca && ka == 0.0) equate(c, g_.unary(Op::Neg, b));
+                if (g_.find(a) == g_.find(b)) equate(c, g_.leaf_const(0.0));
+                each(b, Op::Neg, [&](ClassId x, ClassId) { equate(c, g_.binary(Op::Add, a, x)); });
+                // (x + y) - y = x
+                each(a, Op::Add, [&](ClassId x, ClassId y) {
+                    if (g_.find(y) == g_.find(b)) equate(c, x);
+                    if (g_.find(x) == g_.find(b)) equate(c, y);
+                });
+                factor(c, a, b, Op::Sub);
+                break;
+            case Op::Mul:
+                if ((ca && ka == 0.0) || (cb && kb == 0.0)) equate(c, g_.leaf_const(0.0));
+                if (ca && ka == 1.0) equate(c, b);
+                if (cb && kb == 1.0) equate(c, a);
+                if (ca && ka == -1.0) equate(c, g_.unary(Op::Neg, b));
+                equate(c, g_.binary(Op::Mul, b, a));
+                if (g_.find(a) == g_.find(b))
+                    equate(c, g_.binary(Op::Pow, a, g_.leaf_const(2.0)));
+                each(a, Op::Mul, [&](ClassId x, ClassId y) {
+                    equate(c, g_.binary(Op::Mul, x, g_.binary(Op::Mul, y, b)));
+                });
+                each(a, Op::Neg, [&](ClassId x, ClassId) {
+                    equate(c, g_.unary(Op::Neg, g_.binary(Op::Mul, x, b)));
+                });
+                // x^k * x = x^(k+1),  x^k * x^j = x^(k+j)
+                each(a, Op::Pow, [&](ClassId x, ClassId k) {
+                    double kv;
+                    if (!g_.is_const(k, &kv))
+                        return;
+                    if (g_.find(x) == g_.find(b))
+                        equate(c, g_.binary(Op::Pow, x, g_.leaf_const(kv + 1.0)));
+                    each(b, Op::Pow, [&](ClassId y, ClassId j) {
+                        double jv;
+                        if (g_.find(x) == g_.find(y) && g_.is_const(j, &jv))
+                            equate(c, g_.binary(Op::Pow, x, g_.leaf_const(kv + jv)));
+                    });
+                });
+                // (x / y) * y = x,  x * (y / z) = (x*y) / z
+                each(a, Op::Div, [&](ClassId x, ClassId y) {
+                    if (g_.find(y) == g_.find(b)) equate(c, x);
+                    equate(c, g_.binary(Op::Div, g_.binary(Op::Mul, x, b), y));
+                });
+                // exp(x) * exp(y) = exp(x + y)
+                each(a, Op::Exp, [&](ClassId x, ClassId) {
+                    each(b, Op::Exp, [&](ClassId y, ClassId) {
+                        equate(c, g_.unary(Op::Exp, g_.binary(Op::Add, x, y)));
+                    });
+                });
+                break;
+            case Op::Div:
+                if (cb && kb == 1.0) equate(c, a);
+                if (ca && ka == 0.0) equate(c, g_.leaf_const(0.0));
+                if (g_.find(a) == g_.find(b)) equate(c, g_.leaf_const(1.0));
+                if (cb && exact_reciprocal(kb)) equate(c, g_.binary(Op::Mul, g_.leaf_const(1.0 / kb), a));
+                // (x*y) / y = x
+                each(a, Op::Mul, [&](ClassId x, ClassId y) {
+                    if (g_.find(y) == g_.find(b)) equate(c, x);
+                    if (g_.find(x) == g_.find(b)) equate(c, y);
+                });
+                // x^k / x = x^(k-1)
+                each(a, Op::Pow, [&](ClassId x, ClassId k) {
+                    double kv;
+                    if (g_.find(x) == g_.find(b) && g_.is_const(k, &kv))
+                        equate(c, g_.binary(Op::Pow, x, g_.leaf_const(kv - 1.0)));
+                });
+                // x / (y / z) = (x*z) / y
+                each(b, Op::Div, [&](ClassId y, ClassId z) {
+                    equate(c, g_.binary(Op::Div, g_.binary(Op::Mul, a, z), y));
+                });
+                each(a, Op::Neg, [&](ClassId x, ClassId) {
+                    equate(c, g_.unary(Op::Neg, g_.binary(Op::Div, x, b)));
+                });
+                break;
+            case Op::Pow:
+                if (cb && kb == 1.0) equate(c, a);
+                if (cb && kb == 0.0) equate(c, g_.leaf_const(1.0));
+                if (cb && kb == 2.0) equate(c, g_.binary(Op::Mul, a, a));
+                if (cb && kb == 0.5) equate(c, g_.unary(Op::Sqrt, a));
+                each(a, Op::Pow, [&](ClassId x, ClassId k) {
+                    double kv;
+                    // (x^k)^j = x^(k*j) holds for all x only with integer exponents.
+                    if (cb && g_.is_const(k, &kv) && kv == std::trunc(kv) && kb == std::trunc(kb))
+                        equate(c, g_.binary(Op::Pow, x, g_.leaf_const(kv * kb)));
+                });
+                break;
+            case Op::Log:
+                each(a, Op::Exp, [&](ClassId x, ClassId) { equate(c, x); });
+                break;
+            default: break;
+        }
+    }
+
+    // x*y (+|-) x*z = x*(y (+|-) z), matching the shared factor in any position.
+    void factor(ClassId c, ClassId a, ClassId b, Op op) {
+        each(a, Op::Mul, [&](ClassId a0, ClassId a1) {
+            each(b, Op::Mul, [&](ClassId b0, ClassId b1) {
+                const ClassId l[2] = {a0, a1};
+                const ClassId r[2] = {b0, b1};
+                for (int i = 0; i < 2; ++i)
+                    for (int j = 0; j < 2; ++j)
+                        if (g_.find(l[i]) == g_.find(r[j]))
+                            equate(c, g_.binary(Op::Mul, l[i], g_.binary(op, l[1 - i], r[1 - j])));
+            });
+            // x*y (+|-) x = x*(y (+|-) 1)
+            const ClassId l[2] = {a0, a1};
+            for (int i = 0; i < 2; ++i)
+                if (g_.find(l[i]) == g_.find(b))
+                    equate(c, g_.binary(Op::Mul, l[i], g_.binary(op, l[1 - i], g_.leaf_const(1.0))));
+        });
+    }
+
+    // sin(x)^2 + cos(x)^2 = 1
+    void trig_identity(ClassId c, ClassId a, ClassId b) {
+        each(a, Op::Pow, [&](ClassId s, ClassId k) {
+            if (!g_.is_const_value(k, 2.0))
+                return;
+            each(b, Op::Pow, [&](ClassId t, ClassId j) {
+                if (!g_.is_const_value(j, 2.0))
+                    return;
+                each(s, Op::Sin, [&](ClassId x, ClassId) {
+                    each(t, Op::Cos, [&](ClassId y, ClassId) {
+                        if (g_.find(x) == g_.find(y)) equate(c, g_.leaf_const(1.0));
+                    });
+                });
+            });
+        });
+    }
+
+    EGraph& g_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::size_t node_limit_;
+    bool changed_ = false;
+};
+
+/// Cheapest e-node per class under tree cost, by fixpoint iteration.
+std::unordered_map<ClassId, ENode> extract_best(EGraph& g) {
+    const std::vector<ClassId> classes = g.roots();
+    std::unordered_map<ClassId, double> cost;
+    std::unordered_map<ClassId, ENode> best;
+    cost.reserve(classes.size());
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (ClassId c : classes) {
+            for (const ENode& n : g.nodes(c)) {
+                double total = op_cost(n.op);
+                bool known = true;
+                for (int i = 0; i < arity(n.op) && known; ++i) {
+                    auto it = cost.find(g.find(n.child[i]));
+                    known = it != cost.end();
+                    if (known)
+                        total += it->second;
+                }
+                if (!known)
+                    continue;
+                auto it = cost.find(c);
+                if (it == cost.end() || total < it->second) {
+                    cost[c] = total;
+                    best[c] = n;
+                    changed = true;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+const Node* build(ExprPool& pool, EGraph& g, const std::unordered_map<ClassId, ENode>& best,
+                  ClassId root, std::unordered_map<ClassId, const Node*>& built) {
+    std::vector<std::pair<ClassId, bool>> stack{{g.find(root), false}};
+    while (!stack.empty()) {
+        auto [c, expanded] = stack.back();
+        stack.pop_back();
+        if (built.count(c))
+            continue;
+        const ENode& n = best.at(c);
+        if (!expanded) {
+            stack.emplace_back(c, true);
+            for (int i = 0; i < arity(n.op); ++i)
+                stack.emplace_back(g.find(n.child[i]), false);
+            continue;
+        }
+        const Node* out;
+        switch (n.op) {
+            case Op::Const: out = pool.constant(n.value); break;
+            case Op::Var: out = pool.variable(n.var); break;
+            default:
+                out = pool.make(n.op, built.at(g.find(n.child[0])),
+                                arity(n.op) == 2 ? built.at(g.find(n.child[1])) : nullptr);
+                break;
+        }
+        built.emplace(c, out);
+    }
+    return built.at(g.find(root));
+}
+
+}  // namespace
+
+std::vector<const Node*> simplify(ExprPool& pool, std::span<const Node* const> roots,
+                                  const SimplifyOptions& options, SimplifyStats* stats) {
+    FTE_PROFILE_SCOPE(Simplify);
+    const auto deadline = std::chrono::steady_clock::now() + options.time_budget;
+    EGraph g;
+    std::unordered_map<const Node*, ClassId> loaded;
+    std::vector<ClassId> root_classes;
+    root_classes.reserve(roots.size());
+    for (const Node* r : roots)
+        root_classes.push_back(g.add_expr(r, loaded));
+
+    SimplifyStats s;
+    s.cost_before = dag_cost(roots);
+    for (; s.iterations < options.max_iterations; ++s.iterations) {
+        if (std::chrono::steady_clock::now() > deadline || g.num_nodes() > options.node_limit)
+            break;
+        Rewriter rw(g, deadline, options.node_limit);
+        const bool complete = rw.run();
+        g.rebuild();
+        if (complete && !rw.changed()) {
+            s.saturated = true;
+            break;
+        }
+    }
+
+    const auto best = extract_best(g);
+    std::unordered_map<ClassId, const Node*> built;
+    std::vector<const Node*> out;
+    out.reserve(roots.size());
+    for (ClassId c : root_classes)
+        out.push_back(build(pool, g, best, c, built));
+
+    s.cost_after = dag_cost(out);
+    if (s.cost_after > s.cost_before) {
+        out.assign(roots.begin(), roots.end());
+        s.cost_after = s.cost_before;
+    }
+    s.enodes = g.num_nodes();
+    s.eclasses = g.roots().size();
+    if (stats)
+        *stats = s;
+    return out;
+}
+
+}  // namespace fte
@@ -0,0 +1,279 @@
+#include "fte/sparse.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "fte/derivative.hpp"
+#include "fte/dual.hpp"
+
+namespace fte {
+
+namespace {
+
+constexpr std::uint32_t kUncolored = std::numeric_limits<std::uint32_t>::max();
+
+using Deps = std::vector<std::uint32_t>;
+
+Deps merge(const Deps& a, const Deps& b) {
+    Deps out;
+    out.reserve(a.size() + b.size());
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+    return out;
+}
+
+/// Sorted input dependencies of every node in `order`.
+std::unordered_map<const Node*, Deps> dependencies(const std::vector<const Node*>& order,
+                                                   std::uint32_t num_vars) {
+    std::unordered_map<const Node*, Deps> deps;
+    deps.reserve(order.size());
+    for (const Node* n : order) {
+        switch (arity(n->op)) {
+            case 0:
+                deps[n] = (n->op == Op::Var && n->var < num_vars) ? Deps{n->var} : Deps{};
+                break;
+            case 1: deps[n] = deps.at(n->arg[0]); break;
+            default: deps[n] = merge(deps.at(n->arg[0]), deps.at(n->arg[1])); break;
+        }
+    }
+    return deps;
+}
+
+SparsityPattern from_rows(std::vector<Deps>& rows, std::size_t cols) {
+    SparsityPattern p;
+    p.rows = rows.size();
+    p.cols = cols;
+    p.row_ptr.reserve(rows.size() + 1);
+    p.row_ptr.push_back(0);
+    for (Deps& r : rows) {
+        std::sort(r.begin(), r.end());
+        r.erase(std::unique(r.begin(), r.end()), r.end());
+        p.col_idx.insert(p.col_idx.end(), r.begin(), r.end());
+        p.row_ptr.push_back(p.col_idx.size());
+    }
+    return p;
+}
+
+std::uint32_t count_colors(const std::vector<std::uint32_t>& colors) {
+    std::uint32_t n = 0;
+    for (std::uint32_t c : colors)
+        n = std::max(n, c + 1);
+    return n;
+}
+
+/// `B = F'(x) S` for the seed matrix in which column `j` belongs to
+/// direction `colors[j]`; returned row-major with `num_colors` columns.
+std::vector<double> compressed_product(std::span<const Node* const> roots,
+                                       std::span<const double> x,
+                                       std::span<const std::uint32_t> colors,
+                                       std::uint32_t num_colors) {
+    constexpr std::size_t N = kDualWidth;
+    const std::size_t n = x.size();
+    const std::size_t m = roots.size();
+    std::vector<double> b(m * num_colors);
+    std::vector<double> seeds(N * n);
+    std::vector<double> block(N * m);
+    for (std::uint32_t c0 = 0; c0 < num_colors; c0 += N) {
+        std::fill(seeds.begin(), seeds.end(), 0.0);
+        for (std::size_t j = 0; j < n; ++j)
+            if (colors[j] >= c0 && colors[j] < c0 + N)
+                seeds[(colors[j] - c0) * n + j] = 1.0;
+        directional_derivatives<N>(roots, x, seeds, block);
+        for (std::size_t r = 0; r < m; ++r)
+            for (std::size_t k = 0; k < N && c0 + k < num_colors; ++k)
+                b[r * num_colors + c0 + k] = block[r * N + k];
+    }
+    return b;
+}
+
+CsrMatrix with_values(const SparsityPattern& p) {
+    CsrMatrix m;
+    m.rows = p.rows;
+    m.cols = p.cols;
+    m.row_ptr = p.row_ptr;
+    m.col_idx = p.col_idx;
+    m.values.resize(p.nnz());
+    return m;
+}
+
+}  // namespace
+
+SparsityPattern jacobian_sparsity(std::span<const Node* const> roots, std::uint32_t num_vars) {
+    const auto deps = dependencies(topo_order(roots), num_vars);
+    std::vector<Deps> rows;
+    rows.reserve(roots.size());
+    for (const Node* r : roots)
+        rows.push_back(deps.at(r));
+    return from_rows(rows, num_vars);
+}
+
+SparsityPattern hessian_sparsity(const Node* f, std::uint32_t num_vars) {
+    const std::vector<const Node*> order = topo_order(f);
+    const auto deps = dependencies(order, num_vars);
+    std::vector<Deps> rows(num_vars);
+    auto all_pairs = [&](const Deps& d) {
+        for (std::uint32_t i : d)
+            rows[i].insert(rows[i].end(), d.begin(), d.end());
+    };
+    auto cross = [&](const Deps& a, const Deps& b) {
+        for (std::uint32_t i : a)
+            rows[i].insert(rows[i].end(), b.begin(), b.end());
+        for (std::uint32_t j : b)
+            rows[j].insert(rows[j].end(), a.begin(), a.end());
+    };
+
+    for (const Node* n : order) {
+        switch (n->op) {
+            case Op::Const:
+            case Op::Var:
+            case Op::Neg:
+            case Op::Add:
+            case Op::Sub: break;
+            case Op::Mul: cross(deps.at(n->arg[0]), deps.at(n->arg[1])); break;
+            case Op::Div:
+                cross(deps.at(n->arg[0]), deps.at(n->arg[1]));
+                all_pairs(deps.at(n->arg[1]));
+                break;
+            case Op::Pow: all_pairs(deps.at(n)); break;
+            default: all_pairs(deps.at(n->arg[0])); break;
+        }
+        // Keep the rows from accumulating duplicates without bound.
+        if (n->op != Op::Const && n->op != Op::Var && arity(n->op) > 0) {
+            for (std::uint32_t i : deps.at(n)) {
+                Deps& r = rows[i];
+                if (r.size() > 4 * num_vars + 64) {
+                    std::sort(r.begin(), r.end());
+                    r.erase(std::unique(r.begin(), r.end()), r.end());
+                }
+            }
+        }
+    }
+    return from_rows(rows, num_vars);
+}
+
+std::vector<std::uint32_t> column_coloring(const SparsityPattern& jac) {
+    // Rows of each column, i.e. the transpose pattern.
+    std::vector<std::vector<std::uint32_t>> col_rows(jac.cols);
+    for (std::size_t r = 0; r < jac.rows; ++r)
+        for (std::size_t k = jac.row_ptr[r]; k < jac.row_ptr[r + 1]; ++k)
+            col_rows[jac.col_idx[k]].push_back(static_cast<std::uint32_t>(r));
+
+    std::vector<std::uint32_t> colors(jac.cols, kUncolored);
+    std::vector<std::size_t> forbidden;  // forbidden[c] == j + 1 while coloring j
+    for (std::uint32_t j = 0; j < jac.cols; ++j) {
+        for (std::uint32_t r : col_rows[j]) {
+            for (std::size_t k = jac.row_ptr[r]; k < jac.row_ptr[r + 1]; ++k) {
+                const std::uint32_t c = colors[jac.col_idx[k]];
+                if (c == kUncolored)
+                    continue;
+                if (c >= forbidden.size())
+                    forbidden.resize(c + 1, 0);
+                forbidden[c] = j + 1;
+            }
+        }
+        std::uint32_t c = 0;
+        while (c < forbidden.size() && forbidden[c] == j + 1)
+            ++c;
+        colors[j] = c;
+    }
+    return colors;
+}
+
+std::vector<std::uint32_t> star_coloring(const SparsityPattern& h) {
+    const std::size_t n = h.rows;
+    auto neighbors = [&](std::size_t v) {
+        return std::span<const std::uint32_t>(h.col_idx.data() + h.row_ptr[v],
+                                              h.row_ptr[v + 1] - h.row_ptr[v]);
+    };
+
+    std::vector<std::uint32_t> color(n, kUncolored);
+    std::vector<std::size_t> forbidden;
+    auto forbid = [&](std::uint32_t c, std::size_t stamp) {
+        if (c >= forbidden.size())
+            forbidden.resize(c + 1, 0);
+        forbidden[c] = stamp;
+    };
+
+    for (std::uint32_t v = 0; v < n; ++v) {
+        const std::size_t stamp = v + 1;
+        for (std::uint32_t w : neighbors(v)) {
+            if (w == v)
+                continue;
+            if (color[w] != kUncolored)
+                forbid(color[w], stamp);
+            for (std::uint32_t x : neighbors(w)) {
+                if (x == v || x == w || color[x] == kUncolored)
+                    continue;
+                if (color[w] == kUncolored) {
+                    forbid(color[x], stamp);
+                    continue;
+                }
+                // Forbid color[x] if x already has a neighbor y colored like
+                // w: v-w-x-y would otherwise be a two-colored path.
+                for (std::uint32_t y : neighbors(x)) {
+                    if (y != w && y != x && color[y] == color[w]) {
+                        forbid(color[x], stamp);
+                        break;
+                    }
+                }
+            }
+        }
+        std::uint32_t c = 0;
+        while (c < forbidden.size() && forbidden[c] == stamp)
+            ++c;
+        color[v] = c;
+    }
+    return color;
+}
+
+SparseJacobian::SparseJacobian(std::span<const Node* const> roots, std::uint32_t num_vars)
+    : roots_(roots.begin(), roots.end()),
+      pattern_(jacobian_sparsity(roots, num_vars)),
+      colors_(column_coloring(pattern_)),
+      num_colors_(count_colors(colors_)) {}
+
+CsrMatrix SparseJacobian::operator()(std::span<const double> x) const {
+    if (x.size() != pattern_.cols)
+        throw std::invalid_argument("SparseJacobian: wrong number of inputs");
+    const std::vector<double> b = compressed_product(roots_, x, colors_, num_colors_);
+    CsrMatrix m = with_values(pattern_);
+    for (std::size_t r = 0; r < m.rows; ++r)
+        for (std::size_t k = m.row_ptr[r]; k < m.row_ptr[r + 1]; ++k)
+            m.values[k] = b[r * num_colors_ + colors_[m.col_idx[k]]];
+    return m;
+}
+
+SparseHessian::SparseHessian(ExprPool& pool, const Node* f, std::uint32_t num_vars)
+    : gradient_(adjoint_gradient(pool, f, num_vars)),
+      pattern_(hessian_sparsity(f, num_vars)),
+      colors_(star_coloring(pattern_)),
+      num_colors_(count_colors(colors_)) {}
+
+CsrMatrix SparseHessian::operator()(std::span<const double> x) const {
+    if (x.size() != pattern_.cols)
+        throw std::invalid_argument("SparseHessian: wrong number of inputs");
+    const std::uint32_t p = num_colors_;
+    const std::vector<double> b = compressed_product(gradient_, x, colors_, p);
+    CsrMatrix m = with_values(pattern_);
+
+    // H[i][j] can be read from B[i][color j] when j is the only entry of row
+    // i with that color; otherwise the star property guarantees that i is
+    // the only entry of row j colored like i.
+    std::vector<std::uint32_t> count(p, 0);
+    for (std::size_t i = 0; i < m.rows; ++i) {
+        for (std::size_t k = m.row_ptr[i]; k < m.row_ptr[i + 1]; ++k)
+            ++count[colors_[m.col_idx[k]]];
+        for (std::size_t k = m.row_ptr[i]; k < m.row_ptr[i + 1]; ++k) {
+            const std::uint32_t j = m.col_idx[k];
+            m.values[k] = count[colors_[j]] == 1 ? b[i * p + colors_[j]]
+                                                 : b[std::size_t{j} * p + colors_[i]];
+        }
+        for (std::size_t k = m.row_ptr[i]; k < m.row_ptr[i + 1]; ++k)
+            count[colors_[m.col_idx[k]]] = 0;
+    }
+    return m;
+}
+
+}  // namespace fte
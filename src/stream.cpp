@@ -0,0 +1,381 @@
+#include "fte/stream.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "fte/batch.hpp"
+#include "fte/parallel.hpp"
+
+namespace fte {
+
+namespace {
+
+constexpr std::size_t kWindowBytes = std::size_t{32} << 20;
+
+[[noreturn]] void throw_errno(const char* what, const std::filesystem::path& path) {
+    std::string msg = what;
+    msg += ' ';
+    msg += path.string();
+    throw std::system_error(errno, std::generic_category(), msg);
+}
+
+std::size_t page_size() {
+    static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/// `[offset, offset + length)` widened to whole pages and clipped to `size`.
+std::pair<std::size_t, std::size_t> page_range(std::size_t offset, std::size_t length,
+                                               std::size_t size) {
+    const std::size_t page = page_size();
+    const std::size_t begin = offset / page * page;
+    const std::size_t end = std::min(size, (offset + length + page - 1) / page * page);
+    return {begin, end > begin ? end - begin : 0};
+}
+
+ColumnFileHeader make_header(std::size_t rows, std::size_t columns) {
+    ColumnFileHeader h{};
+    std::memcpy(h.magic, ColumnFileHeader::kMagic, sizeof h.magic);
+    h.rows = rows;
+    h.columns = columns;
+    return h;
+}
+
+/// Output file for `rows` results of `program`, with its column pointers.
+MappedFile create_output(const std::filesystem::path& path, const Program& program,
+                         std::size_t rows, std::vector<double*>& columns) {
+    const std::size_t nout = program.num_outputs();
+    MappedFile out =
+        MappedFile::create(path, sizeof(ColumnFileHeader) + rows * nout * sizeof(double));
+    const ColumnFileHeader h = make_header(rows, nout);
+    std::memcpy(out.data(), &h, sizeof h);
+    columns.resize(nout);
+    for (std::size_t r = 0; r < nout; ++r)
+        columns[r] = reinterpret_cast<double*>(out.data() + sizeof h) + r * rows;
+    return out;
+}
+
+/// Release rows `[first, first + count)` of every column from the mapping.
+void release_rows(const MappedFile& file, const void* base, std::span<double* const> columns,
+                  std::size_t first, std::size_t count) {
+    const auto* origin = static_cast<const std::byte*>(base);
+    for (const double* c : columns)
+        file.release(static_cast<std::size_t>(reinterpret_cast<const std::byte*>(c + first) - origin),
+                     count * sizeof(double));
+}
+
+// ---- delimited text --------------------------------------------------------
+
+bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+const char* line_end(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+const char* skip_blanks(const char* p, const char* end) {
+    while (p < end && is_blank(*p))
+        ++p;
+    return p;
+}
+
+/// Start of the line following the one containing `p`.
+const char* next_line(const char* p, const char* end) {
+    const char* e = line_end(p, end);
+    return e < end ? e + 1 : end;
+}
+
+std::size_t count_rows(const char* p, const char* end) {
+    std::size_t rows = 0;
+    while (p < end) {
+        const char* e = line_end(p, end);
+        rows += skip_blanks(p, e) != e;
+        p = e < end ? e + 1 : end;
+    }
+    return rows;
+}
+
+/// Parse the rows in `[p, end)` into `columns[i][row..]`.
+void parse_rows(const char* p, const char* end, const char* file_begin, char delimiter,
+                std::span<double* const> columns, std::size_t row) {
+    auto fail = [&](const char* at, const char* what) {
+        std::string msg = "stream_evaluate_csv: ";
+        msg += what;
+        msg += " at byte ";
+        msg += std::to_string(at - file_begin);
+        throw std::runtime_error(msg);
+    };
+    while (p < end) {
+        const char* e = line_end(p, end);
+        const char* q = skip_blanks(p, e);
+        if (q != e) {
+            for (std::size_t i = 0; i < columns.size(); ++i) {
+                if (i > 0) {
+                    if (q == e || *q != delimiter)
+                        fail(q, "too few fields");
+                    q = skip_blanks(q + 1, e);
+                }
+                if (q < e && *q == '+')
+                    ++q;
+                double v = 0.0;
+                const auto [ptr, ec] = std::from_chars(q, e, v);
+                if (ec != std::errc{})
+                    fail(q, "malformed number");
+                columns[i][row] = v;
+                q = skip_blanks(ptr, e);
+            }
+            if (q != e)
+                fail(q, *q == delimiter ? "too many fields" : "malformed number");
+            ++row;
+        }
+        p = e < end ? e + 1 : end;
+    }
+}
+
+}  // namespace
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        MappedFile old(std::move(*this));
+        fd_ = std::exchange(other.fd_, -1);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    if (data_)
+        ::munmap(data_, size_);
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+MappedFile MappedFile::open(const std::filesystem::path& path) {
+    MappedFile f;
+    f.fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (f.fd_ < 0)
+        throw_errno("cannot open", path);
+    struct stat st;
+    if (::fstat(f.fd_, &st) != 0)
+        throw_errno("cannot stat", path);
+    f.size_ = static_cast<std::size_t>(st.st_size);
+    if (f.size_ > 0) {
+        void* p = ::mmap(nullptr, f.size_, PROT_READ, MAP_SHARED, f.fd_, 0);
+        if (p == MAP_FAILED)
+            throw_errno("cannot map", path);
+        f.data_ = static_cast<std::byte*>(p);
+        ::madvise(p, f.size_, MADV_SEQUENTIAL);
+    }
+    return f;
+}
+
+MappedFile MappedFile::create(const std::filesystem::path& path, std::size_t size) {
+    MappedFile f;
+    f.fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (f.fd_ < 0)
+        throw_errno("cannot create", path);
+    if (::ftruncate(f.fd_, static_cast<off_t>(size)) != 0)
+        throw_errno("cannot resize", path);
+    f.size_ = size;
+    if (size > 0) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, f.fd_, 0);
+        if (p == MAP_FAILED)
+            throw_errno("cannot map", path);
+        f.data_ = static_cast<std::byte*>(p);
+    }
+    return f;
+}
+
+void MappedFile::prefetch(std::size_t offset, std::size_t length) const noexcept {
+    const auto [begin, len] = page_range(offset, length, size_);
+    if (len)
+        ::madvise(data_ + begin, len, MADV_WILLNEED);
+}
+
+void MappedFile::release(std::size_t offset, std::size_t length) const noexcept {
+    const auto [begin, len] = page_range(offset, length, size_);
+    if (len)
+        ::madvise(data_ + begin, len, MADV_DONTNEED);
+}
+
+ColumnFile::ColumnFile(const std::filesystem::path& path) : file_(MappedFile::open(path)) {
+    ColumnFileHeader h;
+    if (file_.size() < sizeof h)
+        throw std::runtime_error("ColumnFile: file too small: " + path.string());
+    std::memcpy(&h, file_.data(), sizeof h);
+    if (std::memcmp(h.magic, ColumnFileHeader::kMagic, sizeof h.magic) != 0)
+        throw std::runtime_error("ColumnFile: bad magic: " + path.string());
+    rows_ = h.rows;
+    columns_ = h.columns;
+    if (rows_ && columns_ > (file_.size() - sizeof h) / sizeof(double) / rows_)
+        throw std::runtime_error("ColumnFile: truncated: " + path.string());
+}
+
+const double* ColumnFile::column(std::size_t c) const noexcept {
+    return reinterpret_cast<const double*>(file_.data() + sizeof(ColumnFileHeader)) + c * rows_;
+}
+
+void write_column_file(const std::filesystem::path& path,
+                       std::span<const std::span<const double>> columns) {
+    const std::size_t rows = columns.empty() ? 0 : columns[0].size();
+    for (auto c : columns)
+        if (c.size() != rows)
+            throw std::invalid_argument("write_column_file: columns differ in length");
+    MappedFile f = MappedFile::create(
+        path, sizeof(ColumnFileHeader) + rows * columns.size() * sizeof(double));
+    const ColumnFileHeader h = make_header(rows, columns.size());
+    std::memcpy(f.data(), &h, sizeof h);
+    auto* out = reinterpret_cast<double*>(f.data() + sizeof h);
+    for (std::size_t c = 0; c < columns.size(); ++c)
+        std::copy(columns[c].begin(), columns[c].end(), out + c * rows);
+}
+
+std::size_t stream_evaluate(ThreadPool& pool, const Program& program,
+                            const std::filesystem::path& input,
+                            const std::filesystem::path& output, const StreamOptions& options) {
+    const ColumnFile in(input);
+    if (in.columns() < program.num_inputs())
+        throw std::invalid_argument("stream_evaluate: input has too few columns");
+    const std::size_t rows = in.rows();
+    std::vector<double*> out_cols;
+    MappedFile out = create_output(output, program, rows, out_cols);
+
+    const std::size_t width = std::max<std::size_t>(1, program.num_inputs() + program.num_outputs());
+    std::size_t window = options.window_rows;
+    if (window == 0)
+        window = std::max(BatchEvaluator::kDefaultTile, kWindowBytes / (width * sizeof(double)));
+
+    std::vector<const double*> in_cols(program.num_inputs());
+    std::vector<double*> out_ptrs(out_cols.size());
+    auto in_offset = [&](std::size_t i, std::size_t row) {
+        return sizeof(ColumnFileHeader) + (i * rows + row) * sizeof(double);
+    };
+    auto prefetch = [&](std::size_t first) {
+        const std::size_t count = std::min(window, rows - first);
+        for (std::size_t i = 0; i < in_cols.size(); ++i)
+            in.file().prefetch(in_offset(i, first), count * sizeof(double));
+    };
+
+    if (rows)
+        prefetch(0);
+    for (std::size_t first = 0; first < rows; first += window) {
+        const std::size_t count = std::min(window, rows - first);
+        if (first + count < rows)
+            prefetch(first + count);
+        for (std::size_t i = 0; i < in_cols.size(); ++i)
+            in_cols[i] = in.column(i) + first;
+        for (std::size_t r = 0; r < out_cols.size(); ++r)
+            out_ptrs[r] = out_cols[r] + first;
+        evaluate_batch_parallel(pool, program, in_cols, out_ptrs, count, options.chunk);
+        for (std::size_t i = 0; i < in_cols.size(); ++i)
+            in.file().release(in_offset(i, first), count * sizeof(double));
+        release_rows(out, out.data(), out_cols, first, count);
+    }
+    return rows;
+}
+
+std::size_t stream_evaluate_csv(ThreadPool& pool, const Program& program,
+                                const std::filesystem::path& input,
+                                const std::filesystem::path& output, const StreamOptions& options) {
+    const MappedFile in = MappedFile::open(input);
+    const char* const begin = reinterpret_cast<const char*>(in.data());
+    const char* const end = begin + in.size();
+    const char* const body = options.header ? next_line(begin, end) : begin;
+    const std::size_t pieces = 4 * static_cast<std::size_t>(std::max(1u, pool.size()));
+
+    // Line-aligned windows of about kWindowBytes, each cut into `pieces`
+    // line-aligned parts for the workers.
+    std::vector<const char*> cuts(pieces + 1);
+    std::vector<std::size_t> counts(pieces);
+    auto split = [&](const char* w, const char* we) {
+        const auto len = static_cast<std::size_t>(we - w);
+        cuts[0] = w;
+        for (std::size_t k = 1; k < pieces; ++k) {
+            const char* target = w + k * len / pieces;
+            cuts[k] = std::max(cuts[k - 1], target == w ? w : next_line(target - 1, we));
+        }
+        cuts[pieces] = we;
+        pool.parallel_for(pieces, 1, [&](std::size_t b, std::size_t e) {
+            for (std::size_t k = b; k < e; ++k)
+                counts[k] = count_rows(cuts[k], cuts[k + 1]);
+        });
+    };
+    auto window_end = [&](const char* w) {
+        return static_cast<std::size_t>(end - w) <= kWindowBytes ? end
+                                                                 : next_line(w + kWindowBytes, end);
+    };
+    auto offset = [&](const char* p) { return static_cast<std::size_t>(p - begin); };
+
+    // First pass: count the rows to size the output.
+    std::size_t rows = 0;
+    for (const char* w = body; w < end;) {
+        const char* we = window_end(w);
+        in.prefetch(offset(we), kWindowBytes);
+        split(w, we);
+        for (std::size_t c : counts)
+            rows += c;
+        in.release(offset(w), offset(we) - offset(w));
+        w = we;
+    }
+
+    std::vector<double*> out_cols;
+    MappedFile out = create_output(output, program, rows, out_cols);
+    std::vector<std::vector<double>> columns(program.num_inputs());
+    std::vector<double*> col_ptrs(columns.size());
+    std::vector<const double*> in_ptrs(columns.size());
+    std::vector<double*> out_ptrs(out_cols.size());
+    std::vector<std::size_t> starts(pieces);
+
+    in.prefetch(offset(body), kWindowBytes);
+    std::size_t first = 0;
+    for (const char* w = body; w < end;) {
+        const char* we = window_end(w);
+        in.prefetch(offset(we), kWindowBytes);
+        split(w, we);
+        std::size_t count = 0;
+        for (std::size_t k = 0; k < pieces; ++k) {
+            starts[k] = count;
+            count += counts[k];
+        }
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            if (columns[i].size() < count)
+                columns[i].resize(count);
+            col_ptrs[i] = columns[i].data();
+            in_ptrs[i] = columns[i].data();
+        }
+        pool.parallel_for(pieces, 1, [&](std::size_t b, std::size_t e) {
+            for (std::size_t k = b; k < e; ++k)
+                parse_rows(cuts[k], cuts[k + 1], begin, options.delimiter, col_ptrs, starts[k]);
+        });
+
+        for (std::size_t r = 0; r < out_cols.size(); ++r)
+            out_ptrs[r] = out_cols[r] + first;
+        evaluate_batch_parallel(pool, program, in_ptrs, out_ptrs, count, options.chunk);
+
+        in.release(offset(w), offset(we) - offset(w));
+        release_rows(out, out.data(), out_cols, first, count);
+        first += count;
+        w = we;
+    }
+    return rows;
+}
+
+}  // namespace fte
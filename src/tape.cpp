@@ -0,0 +1,69 @@
+#include "fte/tape.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "fte/eval.hpp"
+
+namespace fte {
+
+thread_local Tape* Tape::active_ = nullptr;
+
+Tape::Tape(std::size_t reserve)
+    : entries_(std::make_unique<TapeEntry[]>(std::max<std::size_t>(reserve, 16))),
+      capacity_(std::max<std::size_t>(reserve, 16)) {
+    clear();
+}
+
+void Tape::grow() {
+    auto bigger = std::make_unique<TapeEntry[]>(capacity_ * 2);
+    std::memcpy(bigger.get(), entries_.get(), size_ * sizeof(TapeEntry));
+    entries_ = std::move(bigger);
+    capacity_ *= 2;
+}
+
+void Tape::clear() noexcept {
+    size_ = 0;
+    inputs_.clear();
+    // Entry 0 is the sink for the missing operand of unary operations.
+    entries_[size_++] = TapeEntry{{0, 0}, {0.0, 0.0}, 0.0, Op::Const};
+}
+
+Real Tape::input(double value) {
+    const std::uint32_t i = record(Op::Var, 0, 0, value, 0.0, 0.0);
+    inputs_.push_back(i);
+    return Real(value, i);
+}
+
+std::span<const double> Tape::backward(const Real& output) {
+    adjoints_.assign(size_, 0.0);
+    if (!output.is_active())
+        return adjoints_;
+    double* adj = adjoints_.data();
+    const TapeEntry* e = entries_.get();
+    adj[output.index()] = 1.0;
+    for (std::size_t i = output.index(); i > 0; --i) {
+        const double a = adj[i];
+        adj[e[i].arg[0]] += e[i].partial[0] * a;
+        adj[e[i].arg[1]] += e[i].partial[1] * a;
+    }
+    return adjoints_;
+}
+
+void Tape::input_adjoints(std::span<double> out) const {
+    const std::size_t n = std::min(out.size(), inputs_.size());
+    for (std::size_t k = 0; k < n; ++k)
+        out[k] = inputs_[k] < adjoints_.size() ? adjoints_[inputs_[k]] : 0.0;
+}
+
+double reverse_gradient(Tape& tape, const Node* f, std::span<const double> x,
+                        std::span<double> grad) {
+    return reverse_gradient(
+        tape,
+        [f](std::span<const Real> xs) {
+            return evaluate<Real>(std::span<const Node* const>(&f, 1), xs)[0];
+        },
+        x, grad);
+}
+
+}  // namespace fte
@@ -0,0 +1,211 @@
+#include "fte/taylor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace fte {
+
+namespace {
+
+void mul(const double* a, const double* b, double* c, std::size_t n) {
+    for (std::size_t k = 0; k < n; ++k) {
+        double s = 0.0;
+        for (std::size_t j = 0; j <= k; ++j)
+            s += a[j] * b[k - j];
+        c[k] = s;
+    }
+}
+
+void div(const double* a, const double* b, double* c, std::size_t n) {
+    for (std::size_t k = 0; k < n; ++k) {
+        double s = a[k];
+        for (std::size_t j = 0; j < k; ++j)
+            s -= c[j] * b[k - j];
+        c[k] = s / b[0];
+    }
+}
+
+void exp(const double* a, double* c, std::size_t n) {
+    c[0] = std::exp(a[0]);
+    for (std::size_t k = 1; k < n; ++k) {
+        double s = 0.0;
+        for (std::size_t j = 1; j <= k; ++j)
+            s += static_cast<double>(j) * a[j] * c[k - j];
+        c[k] = s / static_cast<double>(k);
+    }
+}
+
+void log(const double* a, double* c, std::size_t n) {
+    c[0] = std::log(a[0]);
+    for (std::size_t k = 1; k < n; ++k) {
+        double s = 0.0;
+        for (std::size_t j = 1; j < k; ++j)
+            s += static_cast<double>(j) * c[j] * a[k - j];
+        c[k] = (a[k] - s / static_cast<double>(k)) / a[0];
+    }
+}
+
+void sqrt(const double* a, double* c, std::size_t n) {
+    c[0] = std::sqrt(a[0]);
+    for (std::size_t k = 1; k < n; ++k) {
+        double s = 0.0;
+        for (std::size_t j = 1; j < k; ++j)
+            s += c[j] * c[k - j];
+        c[k] = (a[k] - s) / (2.0 * c[0]);
+    }
+}
+
+void sincos(const double* a, double* s, double* c, std::size_t n) {
+    s[0] = std::sin(a[0]);
+    c[0] = std::cos(a[0]);
+    for (std::size_t k = 1; k < n; ++k) {
+        double ss = 0.0, cc = 0.0;
+        for (std::size_t j = 1; j <= k; ++j) {
+            const double ja = static_cast<double>(j) * a[j];
+            ss += ja * c[k - j];
+            cc += ja * s[k - j];
+        }
+        s[k] = ss / static_cast<double>(k);
+        c[k] = -cc / static_cast<double>(k);
+    }
+}
+
+// c = tan(a) (sign = +1) or tanh(a) (sign = -1), using c' = a' (1 + sign c^2).
+void tan_like(const double* a, double* c, double* w, std::size_t n, double sign) {
+    c[0] = sign > 0 ? std::tan(a[0]) : std::tanh(a[0]);
+    w[0] = 1.0 + sign * c[0] * c[0];
+    for (std::size_t k = 1; k < n; ++k) {
+        double s = 0.0;
+        for (std::size_t j = 1; j <= k; ++j)
+            s += static_cast<double>(j) * a[j] * w[k - j];
+        c[k] = s / static_cast<double>(k);
+        double sq = 0.0;
+        for (std::size_t j = 0; j <= k; ++j)
+            sq += c[j] * c[k - j];
+        w[k] = sign * sq;
+    }
+}
+
+// c = a^r for a constant exponent, from a c' = r a' c.
+void pow_const(const double* a, double r, double* c, std::size_t n) {
+    c[0] = std::pow(a[0], r);
+    for (std::size_t k = 1; k < n; ++k) {
+        double s = 0.0;
+        for (std::size_t j = 1; j <= k; ++j)
+            s += ((r + 1.0) * static_cast<double>(j) - static_cast<double>(k)) * a[j] * c[k - j];
+        c[k] = s / (static_cast<double>(k) * a[0]);
+    }
+}
+
+}  // namespace
+
+TaylorEvaluator::TaylorEvaluator(const Program& program, std::size_t degree)
+    : program_(program),
+      degree_(degree),
+      coef_(std::size_t{program.num_slots()} * (degree + 1)),
+      result_(degree + 1),
+      aux_{std::vector<double>(degree + 1), std::vector<double>(degree + 1)} {}
+
+void TaylorEvaluator::apply(const Instr& in) {
+    const std::size_t n = degree_ + 1;
+    const double* a = slot(in.a);
+    const double* b = slot(in.b);
+    double* c = result_.data();
+    // Results go to a separate buffer first: with recycled slots the
+    // destination may be one of the operands.
+    switch (in.op) {
+        case Op::Neg: for (std::size_t k = 0; k < n; ++k) c[k] = -a[k]; break;
+        case Op::Add: for (std::size_t k = 0; k < n; ++k) c[k] = a[k] + b[k]; break;
+        case Op::Sub: for (std::size_t k = 0; k < n; ++k) c[k] = a[k] - b[k]; break;
+        case Op::Mul: mul(a, b, c, n); break;
+        case Op::Div: div(a, b, c, n); break;
+        case Op::Sqrt: sqrt(a, c, n); break;
+        case Op::Exp: exp(a, c, n); break;
+        case Op::Log: log(a, c, n); break;
+        case Op::Sin: sincos(a, c, aux_[0].data(), n); break;
+        case Op::Cos: sincos(a, aux_[0].data(), c, n); break;
+        case Op::Tan: tan_like(a, c, aux_[0].data(), n, 1.0); break;
+        case Op::Tanh: tan_like(a, c, aux_[0].data(), n, -1.0); break;
+        case Op::Pow: {
+            const bool const_exponent = in.b >= program_.const_base() && in.b < program_.temp_base();
+            const double r = const_exponent ? program_.constants()[in.b - program_.const_base()] : 0.0;
+            if (const_exponent && a[0] != 0.0) {
+                pow_const(a, r, c, n);
+            } else if (const_exponent && r >= 0.0 && r == std::floor(r)) {
+                // Zero base with a natural exponent: square-and-multiply. The
+                // series starts at t^r, so beyond the degree it is all zero.
+                std::fill(c, c + n, 0.0);
+                if (r >= static_cast<double>(n))
+                    break;
+                c[0] = 1.0;
+                std::copy(a, a + n, aux_[0].begin());
+                for (auto e = static_cast<unsigned long long>(r); e; e >>= 1) {
+                    if (e & 1) {
+                        mul(c, aux_[0].data(), aux_[1].data(), n);
+                        std::copy(aux_[1].begin(), aux_[1].end(), c);
+                    }
+                    mul(aux_[0].data(), aux_[0].data(), aux_[1].data(), n);
+                    std::swap(aux_[0], aux_[1]);
+                }
+            } else {
+                // a^b = exp(b log a)
+                log(a, aux_[0].data(), n);
+                mul(aux_[0].data(), b, aux_[1].data(), n);
+                exp(aux_[1].data(), c, n);
+            }
+            break;
+        }
+        case Op::Const:
+        case Op::Var: break;
+    }
+    std::copy(c, c + n, slot(in.dst));
+}
+
+void TaylorEvaluator::operator()(std::span<const double> x0, std::span<const double> dir,
+                                 std::span<double> out) {
+    const std::size_t n = degree_ + 1;
+    if (x0.size() < program_.num_inputs() || dir.size() < program_.num_inputs() ||
+        out.size() < program_.num_outputs() * n)
+        throw std::invalid_argument("TaylorEvaluator: span too small");
+
+    for (std::uint32_t i = 0; i < program_.num_inputs(); ++i) {
+        double* s = slot(i);
+        std::fill(s, s + n, 0.0);
+        s[0] = x0[i];
+        if (n > 1)
+            s[1] = dir[i];
+    }
+    const auto constants = program_.constants();
+    for (std::size_t c = 0; c < constants.size(); ++c) {
+        double* s = slot(program_.const_base() + static_cast<std::uint32_t>(c));
+        std::fill(s, s + n, 0.0);
+        s[0] = constants[c];
+    }
+    for (const Instr& in : program_.code())
+        apply(in);
+
+    const auto outputs = program_.outputs();
+    for (std::size_t r = 0; r < outputs.size(); ++r)
+        std::copy_n(slot(outputs[r]), n, out.data() + r * n);
+}
+
+std::vector<double> higher_derivatives(const Node* f, std::uint32_t var,
+                                       std::span<const double> x, std::size_t degree) {
+    if (var >= x.size())
+        throw std::out_of_range("higher_derivatives: variable index out of range");
+    const Program program = linearize(std::span<const Node* const>(&f, 1),
+                                      static_cast<std::uint32_t>(x.size()));
+    std::vector<double> dir(x.size(), 0.0);
+    dir[var] = 1.0;
+    std::vector<double> d(degree + 1);
+    TaylorEvaluator(program, degree)(x, dir, d);
+    double factorial = 1.0;
+    for (std::size_t k = 1; k <= degree; ++k) {
+        factorial *= static_cast<double>(k);
+        d[k] *= factorial;
+    }
+    return d;
+}
+
+}  // namespace fte
@@ -0,0 +1,150 @@
+#include "fte/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace fte {
+
+namespace {
+
+thread_local const ThreadPool* tl_pool = nullptr;
+thread_local unsigned tl_index = 0;
+
+}  // namespace
+
+struct ThreadPool::Job {
+    std::atomic<std::size_t> remaining{0};
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(unsigned num_threads) {
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    queues_.reserve(num_threads);
+    for (unsigned i = 0; i < num_threads; ++i)
+        queues_.push_back(std::make_unique<Queue>());
+    workers_.reserve(num_threads);
+    for (unsigned i = 0; i < num_threads; ++i)
+        workers_.emplace_back([this, i] { worker_loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : workers_)
+        t.join();
+}
+
+unsigned ThreadPool::worker_index() const noexcept {
+    return tl_pool == this ? tl_index : size();
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::execute(const Task& t) {
+    std::exception_ptr error;
+    try {
+        t.run(t.ctx, t.begin, t.end);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // The waiter may destroy the job as soon as `remaining` hits zero, so the
+    // decrement happens under the job's lock, which the waiter takes last.
+    std::lock_guard<std::mutex> lock(t.job->mutex);
+    if (error && !t.job->error)
+        t.job->error = error;
+    if (t.job->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        t.job->done.notify_all();
+}
+
+bool ThreadPool::try_run_one(unsigned self) {
+    const unsigned n = size();
+    Task task;
+    bool found = false;
+    // Own queue from the back (most recent, still in cache) ...
+    if (self < n) {
+        Queue& q = *queues_[self];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty()) {
+            task = q.tasks.back();
+            q.tasks.pop_back();
+            found = true;
+        }
+    }
+    // ... then steal the oldest task of another worker.
+    for (unsigned k = 1; !found && k <= n; ++k) {
+        Queue& q = *queues_[(self + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty()) {
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found)
+        return false;
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    execute(task);
+    return true;
+}
+
+void ThreadPool::worker_loop(unsigned index) {
+    tl_pool = this;
+    tl_index = index;
+    for (;;) {
+        if (try_run_one(index))
+            continue;
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this] { return stop_ || queued_.load(std::memory_order_relaxed) > 0; });
+        if (stop_)
+            return;
+    }
+}
+
+void ThreadPool::run_chunks(std::size_t n, std::size_t grain,
+                            void (*run)(void*, std::size_t, std::size_t), void* ctx) {
+    Job job;
+    const std::size_t chunks = (n + grain - 1) / grain;
+    job.remaining.store(chunks, std::memory_order_relaxed);
+
+    const unsigned self = worker_index();
+    const unsigned workers = size();
+    // Nested work stays on the submitting worker until stolen; external work
+    // is dealt round-robin so every worker starts busy.
+    unsigned target = self < workers ? self : next_queue_.fetch_add(1) % workers;
+    for (std::size_t c = 0; c < chunks; ++c) {
+        const std::size_t b = c * grain;
+        const Task t{run, ctx, b, std::min(n, b + grain), &job};
+        Queue& q = *queues_[target];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.tasks.push_back(t);
+        }
+        queued_.fetch_add(1, std::memory_order_relaxed);
+        if (self >= workers)
+            target = (target + 1) % workers;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_all();
+
+    if (self < workers) {
+        while (job.remaining.load(std::memory_order_acquire) != 0)
+            if (!try_run_one(self))
+                std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(job.mutex);
+    job.done.wait(lock, [&] { return job.remaining.load(std::memory_order_acquire) == 0; });
+    if (job.error)
+        std::rethrow_exception(job.error);
+}
+
+}  // namespace fte
@@ -0,0 +1,114 @@
+#include "fte/tiered.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+
+#include "fte/batch.hpp"
+
+namespace fte {
+
+TieredFunction::TieredFunction(std::span<const Node* const> roots, std::uint32_t num_inputs,
+                               const TieredOptions& options)
+    : roots_(roots.begin(), roots.end()),
+      options_(options),
+      program_(linearize(roots, num_inputs)),
+      bytecode_(program_, options.bytecode) {}
+
+TieredFunction::~TieredFunction() {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (compiler_.joinable())
+        compiler_.join();
+}
+
+void TieredFunction::operator()(std::span<const double> x, std::span<double> out) const {
+    if (x.size() < num_inputs() || out.size() < num_outputs())
+        throw std::invalid_argument("TieredFunction: span too small");
+    if (const CompiledKernel* kernel = kernel_.load(std::memory_order_acquire)) {
+        (*kernel)(x.data(), out.data());
+        return;
+    }
+    thread_local std::vector<double> registers;
+    registers.resize(std::max<std::size_t>(registers.size(), bytecode_.num_registers()));
+    bytecode_.eval(x, out, registers);
+    count(1);
+}
+
+void TieredFunction::batch(std::span<const double* const> inputs,
+                           std::span<double* const> outputs, std::size_t n) const {
+    if (inputs.size() < num_inputs() || outputs.size() < num_outputs())
+        throw std::invalid_argument("TieredFunction::batch: span too small");
+    if (n == 0)
+        return;
+    if (const CompiledKernel* kernel = kernel_.load(std::memory_order_acquire)) {
+        kernel->batch(n, inputs.data(), outputs.data());
+        return;
+    }
+    BatchEvaluator eval(program_, std::min(n, BatchEvaluator::kDefaultTile));
+    eval(inputs, outputs, n);
+    count(n);
+}
+
+void TieredFunction::count(std::size_t n) const {
+    // Once compilation has started there is nothing left to decide, so the
+    // shared counters stop taking writes.
+    if (state_.load(std::memory_order_relaxed) != Idle)
+        return;
+    const std::uint64_t c = calls_.fetch_add(1, std::memory_order_relaxed) + 1;
+    const std::uint64_t p = points_.fetch_add(n, std::memory_order_relaxed) + n;
+    if ((options_.call_threshold != 0 && c >= options_.call_threshold) ||
+        (options_.point_threshold != 0 && p >= options_.point_threshold))
+        promote();
+}
+
+void TieredFunction::promote() const {
+    std::uint8_t idle = Idle;
+    if (!state_.compare_exchange_strong(idle, Building, std::memory_order_acq_rel))
+        return;
+    if (!options_.background) {
+        compile();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    compiler_ = std::thread([this] { compile(); });
+}
+
+void TieredFunction::compile() const {
+    const auto start = std::chrono::steady_clock::now();
+    State result = Ready;
+    try {
+        compiled_ = std::make_unique<CompiledKernel>(CompiledKernel::compile(roots_, options_.jit));
+    } catch (const std::exception& e) {
+        error_ = e.what();
+        result = Failed;
+    }
+    compile_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (result == Ready)
+        kernel_.store(compiled_.get(), std::memory_order_release);
+    state_.store(result, std::memory_order_release);
+    state_.notify_all();
+}
+
+void TieredFunction::wait() const {
+    state_.wait(Building, std::memory_order_acquire);
+}
+
+Tier TieredFunction::tier() const noexcept {
+    switch (state_.load(std::memory_order_acquire)) {
+        case Building: return Tier::Compiling;
+        case Ready: return Tier::Compiled;
+        default: return Tier::Interpreted;
+    }
+}
+
+double TieredFunction::compile_seconds() const noexcept {
+    const std::uint8_t s = state_.load(std::memory_order_acquire);
+    return s == Ready || s == Failed ? compile_seconds_ : 0.0;
+}
+
+std::string TieredFunction::error() const {
+    return state_.load(std::memory_order_acquire) == Failed ? error_ : std::string();
+}
+
+}  // namespace fte
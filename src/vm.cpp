@@ -0,0 +1,302 @@
+#include "fte/vm.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "fte/profile.hpp"
+
+#if defined(__GNUC__)
+#define FTE_VM_COMPUTED_GOTO 1
+#endif
+
+namespace fte {
+
+namespace {
+
+/// One decoded bytecode instruction before encoding.
+struct VmInstr {
+    VmOp op;
+    std::uint32_t d, e, a, b, c;  // e: second result, c: third operand
+};
+
+VmOp vm_op(Op op) {
+    switch (op) {
+        case Op::Neg: return VmOp::Neg;
+        case Op::Sqrt: return VmOp::Sqrt;
+        case Op::Exp: return VmOp::Exp;
+        case Op::Log: return VmOp::Log;
+        case Op::Sin: return VmOp::Sin;
+        case Op::Cos: return VmOp::Cos;
+        case Op::Tan: return VmOp::Tan;
+        case Op::Tanh: return VmOp::Tanh;
+        case Op::Add: return VmOp::Add;
+        case Op::Sub: return VmOp::Sub;
+        case Op::Mul: return VmOp::Mul;
+        case Op::Div: return VmOp::Div;
+        case Op::Pow: return VmOp::Pow;
+        case Op::Const:
+        case Op::Var: break;
+    }
+    throw std::invalid_argument("Bytecode: leaf operation in program code");
+}
+
+bool reads(const Instr& in, std::uint32_t slot) noexcept {
+    return in.a == slot || (arity(in.op) == 2 && in.b == slot);
+}
+
+/// For each instruction, how many later instructions read the value it
+/// defines, and whether that value is an output. Slots may be reused, so
+/// this is a backward liveness pass over values, not slots.
+void count_uses(const Program& program, std::vector<std::uint32_t>& uses,
+                std::vector<bool>& is_output) {
+    const auto code = program.code();
+    std::vector<std::uint32_t> reads_of(program.num_slots(), 0);
+    std::vector<bool> output(program.num_slots(), false);
+    for (std::uint32_t s : program.outputs())
+        output[s] = true;
+    uses.assign(code.size(), 0);
+    is_output.assign(code.size(), false);
+    for (std::size_t i = code.size(); i-- > 0;) {
+        const Instr& in = code[i];
+        uses[i] = reads_of[in.dst];
+        is_output[i] = output[in.dst];
+        reads_of[in.dst] = 0;
+        output[in.dst] = false;
+        ++reads_of[in.a];
+        if (arity(in.op) == 2)
+            ++reads_of[in.b];
+    }
+}
+
+/// How far ahead a sine looks for the cosine of the same value.
+constexpr std::size_t kSinCosWindow = 64;
+
+std::vector<VmInstr> translate(const Program& program, const BytecodeOptions& options,
+                               std::size_t& fused) {
+    const auto code = program.code();
+    std::vector<VmInstr> out;
+    out.reserve(code.size() + 1);
+    fused = 0;
+    if (!options.superinstructions) {
+        for (const Instr& in : code)
+            out.push_back({vm_op(in.op), in.dst, 0, in.a, in.b, 0});
+        return out;
+    }
+
+    std::vector<std::uint32_t> uses;
+    std::vector<bool> is_output;
+    count_uses(program, uses, is_output);
+    std::vector<bool> absorbed(code.size(), false);
+
+    for (std::size_t i = 0; i < code.size(); ++i) {
+        if (absorbed[i])
+            continue;
+        const Instr& in = code[i];
+
+        // A product read once, by the very next addition or subtraction,
+        // never needs its own register.
+        if (in.op == Op::Mul && i + 1 < code.size() && uses[i] == 1 && !is_output[i]) {
+            const Instr& next = code[i + 1];
+            const bool left = next.a == in.dst, right = next.b == in.dst;
+            if ((next.op == Op::Add || next.op == Op::Sub) && left != right) {
+                const std::uint32_t c = left ? next.b : next.a;
+                const VmOp op = next.op == Op::Add ? VmOp::MulAdd
+                                : left             ? VmOp::MulSub
+                                                   : VmOp::NegMulAdd;
+                out.push_back({op, next.dst, 0, in.a, in.b, c});
+                absorbed[i + 1] = true;
+                ++fused;
+                continue;
+            }
+        }
+
+        // A sine and a cosine of one value, computed together at the first
+        // of the two. The later result may be written early only if its
+        // register is left alone in between.
+        if (in.op == Op::Sin || in.op == Op::Cos) {
+            const Op other = in.op == Op::Sin ? Op::Cos : Op::Sin;
+            const std::uint32_t x = in.a;
+            std::size_t match = 0;
+            for (std::size_t j = i + 1; j < std::min(code.size(), i + kSinCosWindow) && in.dst != x; ++j) {
+                if (code[j].op == other && code[j].a == x && !absorbed[j]) {
+                    match = j;
+                    break;
+                }
+                if (code[j].dst == x)
+                    break;
+            }
+            if (match != 0) {
+                const std::uint32_t late = code[match].dst;
+                bool free = late != x && late != in.dst;
+                for (std::size_t j = i + 1; free && j < match; ++j)
+                    free = code[j].dst != late && !reads(code[j], late);
+                if (free) {
+                    const bool sin_first = in.op == Op::Sin;
+                    out.push_back({VmOp::SinCos, sin_first ? in.dst : late,
+                                   sin_first ? late : in.dst, x, 0, 0});
+                    absorbed[match] = true;
+                    ++fused;
+                    continue;
+                }
+            }
+        }
+
+        out.push_back({vm_op(in.op), in.dst, 0, in.a, in.b, 0});
+    }
+    return out;
+}
+
+int operand_words(VmOp op) noexcept {
+    switch (op) {
+        case VmOp::Halt: return 0;
+        case VmOp::Neg:
+        case VmOp::Sqrt:
+        case VmOp::Exp:
+        case VmOp::Log:
+        case VmOp::Sin:
+        case VmOp::Cos:
+        case VmOp::Tan:
+        case VmOp::Tanh: return 2;
+        case VmOp::Add:
+        case VmOp::Sub:
+        case VmOp::Mul:
+        case VmOp::Div:
+        case VmOp::Pow:
+        case VmOp::SinCos: return 3;
+        case VmOp::MulAdd:
+        case VmOp::MulSub:
+        case VmOp::NegMulAdd: return 4;
+    }
+    return 0;
+}
+
+template <class Word>
+void encode(const std::vector<VmInstr>& instrs, std::vector<Word>& code) {
+    for (const VmInstr& v : instrs) {
+        code.push_back(static_cast<Word>(v.op));
+        switch (operand_words(v.op)) {
+            case 2: code.insert(code.end(), {Word(v.d), Word(v.a)}); break;
+            case 3:
+                if (v.op == VmOp::SinCos)
+                    code.insert(code.end(), {Word(v.d), Word(v.e), Word(v.a)});
+                else
+                    code.insert(code.end(), {Word(v.d), Word(v.a), Word(v.b)});
+                break;
+            case 4: code.insert(code.end(), {Word(v.d), Word(v.a), Word(v.b), Word(v.c)}); break;
+            default: break;
+        }
+    }
+    code.push_back(static_cast<Word>(VmOp::Halt));
+}
+
+/// `a * b + c`, rounded once where the target has a fused multiply-add.
+inline double mul_add(double a, double b, double c) noexcept {
+#if defined(FP_FAST_FMA)
+    return std::fma(a, b, c);
+#else
+    return a * b + c;
+#endif
+}
+
+/// The interpreter. Handlers are written once and dispatched either by
+/// computed goto, with an indirect jump at the end of every handler, or by
+/// a switch in a loop.
+template <class Word>
+void run(const Word* pc, double* r) {
+#if defined(FTE_VM_COMPUTED_GOTO)
+    // Indexed by `VmOp`.
+    static const void* const labels[] = {
+        &&op_Halt, &&op_Neg,  &&op_Sqrt, &&op_Exp,    &&op_Log,    &&op_Sin,
+        &&op_Cos,  &&op_Tan,  &&op_Tanh, &&op_Add,    &&op_Sub,    &&op_Mul,
+        &&op_Div,  &&op_Pow,  &&op_MulAdd, &&op_MulSub, &&op_NegMulAdd, &&op_SinCos,
+    };
+#define FTE_VM_CASE(name) op_##name:
+#define FTE_VM_NEXT(words) \
+    pc += (words);         \
+    goto* labels[*pc]
+    goto* labels[*pc];
+#else
+#define FTE_VM_CASE(name) case VmOp::name:
+#define FTE_VM_NEXT(words) \
+    pc += (words);         \
+    continue
+    for (;;) {
+        switch (static_cast<VmOp>(*pc)) {
+#endif
+    FTE_VM_CASE(Neg) r[pc[1]] = -r[pc[2]]; FTE_VM_NEXT(3);
+    FTE_VM_CASE(Sqrt) r[pc[1]] = std::sqrt(r[pc[2]]); FTE_VM_NEXT(3);
+    FTE_VM_CASE(Exp) r[pc[1]] = std::exp(r[pc[2]]); FTE_VM_NEXT(3);
+    FTE_VM_CASE(Log) r[pc[1]] = std::log(r[pc[2]]); FTE_VM_NEXT(3);
+    FTE_VM_CASE(Sin) r[pc[1]] = std::sin(r[pc[2]]); FTE_VM_NEXT(3);
+    FTE_VM_CASE(Cos) r[pc[1]] = std::cos(r[pc[2]]); FTE_VM_NEXT(3);
+    FTE_VM_CASE(Tan) r[pc[1]] = std::tan(r[pc[2]]); FTE_VM_NEXT(3);
+    FTE_VM_CASE(Tanh) r[pc[1]] = std::tanh(r[pc[2]]); FTE_VM_NEXT(3);
+    FTE_VM_CASE(Add) r[pc[1]] = r[pc[2]] + r[pc[3]]; FTE_VM_NEXT(4);
+    FTE_VM_CASE(Sub) r[pc[1]] = r[pc[2]] - r[pc[3]]; FTE_VM_NEXT(4);
+    FTE_VM_CASE(Mul) r[pc[1]] = r[pc[2]] * r[pc[3]]; FTE_VM_NEXT(4);
+    FTE_VM_CASE(Div) r[pc[1]] = r[pc[2]] / r[pc[3]]; FTE_VM_NEXT(4);
+    FTE_VM_CASE(Pow) r[pc[1]] = std::pow(r[pc[2]], r[pc[3]]); FTE_VM_NEXT(4);
+    FTE_VM_CASE(MulAdd) r[pc[1]] = mul_add(r[pc[2]], r[pc[3]], r[pc[4]]); FTE_VM_NEXT(5);
+    FTE_VM_CASE(MulSub) r[pc[1]] = mul_add(r[pc[2]], r[pc[3]], -r[pc[4]]); FTE_VM_NEXT(5);
+    FTE_VM_CASE(NegMulAdd) r[pc[1]] = mul_add(-r[pc[2]], r[pc[3]], r[pc[4]]); FTE_VM_NEXT(5);
+    FTE_VM_CASE(SinCos) {
+        // Adjacent calls on one argument, which compilers merge into a
+        // single `sincos`.
+        const double a = r[pc[3]];
+        const double s = std::sin(a), c = std::cos(a);
+        r[pc[1]] = s;
+        r[pc[2]] = c;
+        FTE_VM_NEXT(4);
+    }
+    FTE_VM_CASE(Halt) return;
+#if !defined(FTE_VM_COMPUTED_GOTO)
+        }
+    }
+#endif
+#undef FTE_VM_CASE
+#undef FTE_VM_NEXT
+}
+
+}  // namespace
+
+Bytecode::Bytecode(const Program& program, const BytecodeOptions& options)
+    : num_inputs_(program.num_inputs()),
+      num_registers_(program.num_slots()),
+      constants_(program.constants().begin(), program.constants().end()),
+      outputs_(program.outputs().begin(), program.outputs().end()) {
+    FTE_PROFILE_SCOPE(Codegen);
+    const std::vector<VmInstr> instrs = translate(program, options, num_fused_);
+    num_instructions_ = instrs.size();
+    if (num_registers_ <= std::numeric_limits<std::uint16_t>::max())
+        encode(instrs, code16_);
+    else
+        encode(instrs, code32_);
+}
+
+void Bytecode::eval(std::span<const double> x, std::span<double> out,
+                    std::span<double> registers) const {
+    FTE_PROFILE_SCOPE(Evaluate);
+    FTE_PROFILE_COUNT(EvaluatedPoints, 1);
+    if (x.size() < num_inputs_ || out.size() < outputs_.size() || registers.size() < num_registers_)
+        throw std::invalid_argument("Bytecode::eval: span too small");
+    if (code16_.empty() && code32_.empty())
+        return;
+    double* r = registers.data();
+    std::copy_n(x.data(), num_inputs_, r);
+    std::copy(constants_.begin(), constants_.end(), r + num_inputs_);
+    if (!code16_.empty())
+        run(code16_.data(), r);
+    else
+        run(code32_.data(), r);
+    for (std::size_t k = 0; k < outputs_.size(); ++k)
+        out[k] = r[outputs_[k]];
+}
+
+void Bytecode::eval(std::span<const double> x, std::span<double> out) const {
+    std::vector<double> registers(num_registers_);
+    eval(x, out, registers);
+}
+
+}  // namespace fte
@@ -0,0 +1,456 @@
+#include "fte/vmath.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace fte::vmath {
+
+namespace {
+
+// Adding and subtracting 1.5 * 2^52 rounds to the nearest integer, and
+// leaves that integer in the low bits of the sum.
+constexpr double kShifter = 0x1.8p52;
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+constexpr double kLn2Hi = 6.93147180369123816490e-01;  // 32 bits, k * kLn2Hi exact
+constexpr double kLn2Lo = 1.90821492927058770002e-10;
+constexpr double kInvLn2 = 1.44269504088896338700e+00;
+
+/// 2^k for -1022 <= k <= 1023.
+inline double pow2(std::int64_t k) noexcept {
+    return std::bit_cast<double>(static_cast<std::uint64_t>(k + 1023) << 52);
+}
+
+inline double exp1(double x) noexcept {
+    constexpr double P1 = 1.66666666666666019037e-01;
+    constexpr double P2 = -2.77777777770155933842e-03;
+    constexpr double P3 = 6.61375632143793436117e-05;
+    constexpr double P4 = -1.65339022054652515390e-06;
+    constexpr double P5 = 4.13813679705723846039e-08;
+
+    // Beyond the clamp the result has over- or underflowed anyway.
+    const double xc = std::min(std::max(x, -746.0), 710.0);
+    const double shifted = xc * kInvLn2 + kShifter;
+    const double kd = shifted - kShifter;
+    const std::int64_t k = std::bit_cast<std::int64_t>(shifted) - std::bit_cast<std::int64_t>(kShifter);
+
+    // x = k ln2 + r with |r| <= ln2 / 2, and exp(r) from a rational form.
+    const double hi = xc - kd * kLn2Hi;
+    const double lo = kd * kLn2Lo;
+    const double r = hi - lo;
+    const double z = r * r;
+    const double c = r - z * (P1 + z * (P2 + z * (P3 + z * (P4 + z * P5))));
+    // exp(r) = 1 + hi + (q - lo). fdlibm rounds 1 + hi along with the rest;
+    // keeping its error `se` (|hi| < 1, so Fast2Sum applies) leaves little
+    // more than the final rounding, also for results below 1.
+    const double q = (r * c) / (2.0 - c);
+    const double s = 1.0 + hi;
+    const double se = hi - (s - 1.0);
+    const double y = s + (se + (q - lo));
+
+    // Scaling in two halves keeps both factors normal; only the last
+    // product rounds, so subnormal results are rounded once.
+    const std::int64_t k1 = k >> 1;
+    const double e = y * pow2(k1) * pow2(k - k1);
+    return x != x ? x : e;
+}
+
+inline double log1(double x) noexcept {
+    constexpr double Lg1 = 6.666666666666735130e-01;
+    constexpr double Lg2 = 3.999999999940941908e-01;
+    constexpr double Lg3 = 2.857142874366239149e-01;
+    constexpr double Lg4 = 2.222219843214978396e-01;
+    constexpr double Lg5 = 1.818357216161805012e-01;
+    constexpr double Lg6 = 1.531383769920937332e-01;
+    constexpr double Lg7 = 1.479819860511658591e-01;
+
+    // Subnormals are scaled into the normal range first.
+    const bool tiny = x < 0x1p-1022;
+    const double xs = tiny ? x * 0x1p54 : x;
+    std::uint64_t u = std::bit_cast<std::uint64_t>(xs);
+
+    // x = 2^k m with sqrt(2)/2 <= m < sqrt(2).
+    std::uint64_t hx = (u >> 32) + (0x3ff00000 - 0x3fe6a09e);
+    const std::int64_t k = static_cast<std::int64_t>(hx >> 20) - 0x3ff;
+    hx = (hx & 0x000fffff) + 0x3fe6a09e;
+    u = (hx << 32) | (u & 0xffffffff);
+    const double f = std::bit_cast<double>(u) - 1.0;
+
+    // log(1 + f) = f - f^2/2 + s (f^2/2 + R(s^2)), s = f / (2 + f).
+    const double hfsq = 0.5 * f * f;
+    const double s = f / (2.0 + f);
+    const double z = s * s;
+    const double w = z * z;
+    const double t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+    const double t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+    const double dk = static_cast<double>(k) - (tiny ? 54.0 : 0.0);
+    const double r = s * (hfsq + (t1 + t2)) + dk * kLn2Lo - hfsq + f + dk * kLn2Hi;
+
+    double y = x == kInf ? x : r;
+    y = x == 0.0 ? -kInf : y;
+    y = x < 0.0 ? kNaN : y;
+    return x != x ? x : y;
+}
+
+/// Arguments with |x| below this reduce exactly with `kPio2_1` to
+/// `kPio2_3`: the multiple of pi/2 fits in 20 bits.
+constexpr double kTrigLimit = 0x1p20;
+constexpr double kInvPio2 = 6.36619772367581382433e-01;
+constexpr double kPio2_1 = 1.57079632673412561417e+00;   // first 33 bits of pi/2
+constexpr double kPio2_2 = 6.07710050630396597660e-11;   // next 33 bits
+constexpr double kPio2_3 = 2.02226624871116645580e-21;   // next 33 bits
+constexpr double kPio2_3t = 8.47842766036889956997e-32;  // pi/2 - kPio2_1 - kPio2_2 - kPio2_3
+
+/// sin and cos of `x = r + rl`, |x| <= pi/4, `rl` a correction to `r`.
+inline double sin_kernel(double r, double rl) noexcept {
+    constexpr double S1 = -1.66666666666666324348e-01;
+    constexpr double S2 = 8.33333333332248946124e-03;
+    constexpr double S3 = -1.98412698298579493134e-04;
+    constexpr double S4 = 2.75573137070700676789e-06;
+    constexpr double S5 = -2.50507602534068634195e-08;
+    constexpr double S6 = 1.58969099521155010221e-10;
+    const double z = r * r;
+    const double w = z * z;
+    const double p = S2 + z * (S3 + z * S4) + z * w * (S5 + z * S6);
+    const double v = z * r;
+    return r - ((z * (0.5 * rl - v * p) - rl) - v * S1);
+}
+
+inline double cos_kernel(double r, double rl) noexcept {
+    constexpr double C1 = 4.16666666666666019037e-02;
+    constexpr double C2 = -1.38888888888741095749e-03;
+    constexpr double C3 = 2.48015872894767294178e-05;
+    constexpr double C4 = -2.75573143513906633035e-07;
+    constexpr double C5 = 2.08757232129817482790e-09;
+    constexpr double C6 = -1.13596475577881948265e-11;
+    const double z = r * r;
+    const double w = z * z;
+    const double p = z * (C1 + z * (C2 + z * C3)) + w * w * (C4 + z * (C5 + z * C6));
+    const double hz = 0.5 * z;
+    const double one_minus = 1.0 - hz;
+    return one_minus + (((1.0 - one_minus) - hz) + (z * p - r * rl));
+}
+
+/// `h + e = a - b` exactly.
+inline void two_diff(double a, double b, double& h, double& e) noexcept {
+    h = a - b;
+    const double bb = h - a;
+    e = (a - (h - bb)) - (b + bb);
+}
+
+/// Reduce `x` to `r + rl` in [-pi/4, pi/4] and the quadrant `q` (mod 4).
+///
+/// Every product of the multiple with a 33-bit part of pi/2 is exact, and
+/// so are the differences kept as `h + e`. Near a multiple of pi/2 the
+/// result cancels down to 2^-52 or so, and only the third part leaves the
+/// tail's rounding far enough below an ulp of `r`.
+inline void reduce(double x, double& r, double& rl, std::int64_t& q) noexcept {
+    const double shifted = x * kInvPio2 + kShifter;
+    const double kd = shifted - kShifter;
+    q = std::bit_cast<std::int64_t>(shifted) - std::bit_cast<std::int64_t>(kShifter);
+    const double t = x - kd * kPio2_1;
+    double h1, e1, h2, e2;
+    two_diff(t, kd * kPio2_2, h1, e1);
+    two_diff(h1, kd * kPio2_3, h2, e2);
+    // The rest folded in and renormalized so that `rl` stays below half an
+    // ulp of `r`.
+    const double l = (e1 + e2) - kd * kPio2_3t;
+    r = h2 + l;
+    rl = l - (r - h2);
+}
+
+template <class T>
+inline bool in_trig_range(T x) noexcept { return std::abs(x) < T(kTrigLimit); }
+
+/// Elements per block of the trigonometric routines: each block is copied
+/// aside so that the arguments libm has to handle survive aliased outputs.
+constexpr std::size_t kBlock = 64;
+
+template <class T, class Body, class Fallback>
+void trig_blocks(std::size_t n, const T* x, Body body, Fallback fallback) noexcept {
+    T arg[kBlock];
+    for (std::size_t b = 0; b < n; b += kBlock) {
+        const std::size_t len = std::min(kBlock, n - b);
+        std::copy_n(x + b, len, arg);
+        int outside = 0;
+        for (std::size_t j = 0; j < len; ++j) {
+            body(b + j, arg[j]);
+            outside |= !in_trig_range(arg[j]);
+        }
+        if (outside)
+            for (std::size_t j = 0; j < len; ++j)
+                if (!in_trig_range(arg[j]))
+                    fallback(b + j, arg[j]);
+    }
+}
+
+// Single precision: Cephes' polynomials, evaluated in float on 32-bit
+// integer exponents, so they vectorize on any SIMD target with twice the
+// lanes of the double routines.
+
+constexpr float kShifterF = 0x1.8p23f;
+constexpr float kInfF = std::numeric_limits<float>::infinity();
+constexpr float kNaNF = std::numeric_limits<float>::quiet_NaN();
+constexpr float kLn2HiF = 0.693359375f;  // 9 bits, k * kLn2HiF exact
+constexpr float kLn2LoF = -2.12194440e-4f;
+constexpr float kInvLn2F = 1.44269504088896341f;
+
+/// 2^k for -126 <= k <= 127.
+inline float pow2f(std::int32_t k) noexcept {
+    return std::bit_cast<float>(static_cast<std::uint32_t>(k + 127) << 23);
+}
+
+inline float expf1(float x) noexcept {
+    const float xc = std::min(std::max(x, -104.0f), 89.0f);
+    const float shifted = xc * kInvLn2F + kShifterF;
+    const float kf = shifted - kShifterF;
+    const std::int32_t k = std::bit_cast<std::int32_t>(shifted) - std::bit_cast<std::int32_t>(kShifterF);
+    const float r = (xc - kf * kLn2HiF) - kf * kLn2LoF;
+    const float z = r * r;
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    const float y = (p * z + r) + 1.0f;
+    const std::int32_t k1 = k >> 1;
+    const float e = y * pow2f(k1) * pow2f(k - k1);
+    return x != x ? x : e;
+}
+
+inline float logf1(float x) noexcept {
+    const bool tiny = x < 0x1p-126f;
+    const float xs = tiny ? x * 0x1p25f : x;
+    std::uint32_t u = std::bit_cast<std::uint32_t>(xs);
+
+    // x = 2^k m with sqrt(2)/2 <= m < sqrt(2).
+    u += 0x3f800000u - 0x3f3504f3u;
+    const std::int32_t k = static_cast<std::int32_t>(u >> 23) - 127;
+    u = (u & 0x007fffffu) + 0x3f3504f3u;
+    const float f = std::bit_cast<float>(u) - 1.0f;
+
+    const float z = f * f;
+    float p = 7.0376836292e-2f;
+    p = p * f - 1.1514610310e-1f;
+    p = p * f + 1.1676998740e-1f;
+    p = p * f - 1.2420140846e-1f;
+    p = p * f + 1.4249322787e-1f;
+    p = p * f - 1.6668057665e-1f;
+    p = p * f + 2.0000714765e-1f;
+    p = p * f - 2.4999993993e-1f;
+    p = p * f + 3.3333331174e-1f;
+    const float kf = static_cast<float>(k) - (tiny ? 25.0f : 0.0f);
+    const float r = ((f * z * p + kf * kLn2LoF) - 0.5f * z + f) + kf * kLn2HiF;
+
+    float y = x == kInfF ? x : r;
+    y = x == 0.0f ? -kInfF : y;
+    y = x < 0.0f ? kNaNF : y;
+    return x != x ? x : y;
+}
+
+/// Reduce `x` in double, where the three parts of pi/2 leave `r` correct to
+/// well below a float ulp; the float kernels take it from there.
+inline void reducef(float x, float& r, std::int32_t& q) noexcept {
+    const double xd = x;
+    const double shifted = xd * kInvPio2 + kShifter;
+    const double kd = shifted - kShifter;
+    // From the bits, as in `reduce`: converting `kd` would be undefined for
+    // the lanes that go to libm.
+    q = static_cast<std::int32_t>(std::bit_cast<std::int64_t>(shifted) -
+                                  std::bit_cast<std::int64_t>(kShifter));
+    r = static_cast<float>((xd - kd * kPio2_1) - kd * kPio2_2 - kd * kPio2_3);
+}
+
+inline float sinf_kernel(float r) noexcept {
+    const float z = r * r;
+    return r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+}
+
+inline float cosf_kernel(float r) noexcept {
+    const float z = r * r;
+    return (1.0f - 0.5f * z) +
+           z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+}
+
+inline float tanhf1(float x) noexcept {
+    // Near zero an odd polynomial, beyond 1 - 2 / (e^2|x| + 1).
+    const float a = std::abs(x);
+    const float z = x * x;
+    float p = -5.70498872745e-3f;
+    p = p * z + 2.06390887954e-2f;
+    p = p * z - 5.37397155531e-2f;
+    p = p * z + 1.33314422036e-1f;
+    p = p * z - 3.33332819422e-1f;
+    const float small = x + x * z * p;
+    const float big = 1.0f - 2.0f / (expf1(2.0f * a) + 1.0f);
+    return std::copysign(a < 0.625f ? small : big, x);
+}
+
+}  // namespace
+
+// The exponent arithmetic of exp and log is on 64-bit integers, which only
+// vectorizes from AVX2 on; scalar, libm is faster.
+#if defined(__AVX2__)
+void exp(std::size_t n, const double* x, double* y) noexcept {
+    for (std::size_t j = 0; j < n; ++j)
+        y[j] = exp1(x[j]);
+}
+
+void log(std::size_t n, const double* x, double* y) noexcept {
+    for (std::size_t j = 0; j < n; ++j)
+        y[j] = log1(x[j]);
+}
+#else
+void exp(std::size_t n, const double* x, double* y) noexcept {
+    for (std::size_t j = 0; j < n; ++j)
+        y[j] = std::exp(x[j]);
+}
+
+void log(std::size_t n, const double* x, double* y) noexcept {
+    for (std::size_t j = 0; j < n; ++j)
+        y[j] = std::log(x[j]);
+}
+#endif
+
+void sin(std::size_t n, const double* x, double* y) noexcept {
+    trig_blocks(
+        n, x,
+        [y](std::size_t j, double a) {
+            double r, rl;
+            std::int64_t q;
+            reduce(a, r, rl, q);
+            const double s = sin_kernel(r, rl), c = cos_kernel(r, rl);
+            const double v = q & 1 ? c : s;
+            // The reduction loses the sign of a zero.
+            y[j] = a == 0.0 ? a : q & 2 ? -v : v;
+        },
+        [y](std::size_t j, double a) { y[j] = std::sin(a); });
+}
+
+void cos(std::size_t n, const double* x, double* y) noexcept {
+    trig_blocks(
+        n, x,
+        [y](std::size_t j, double a) {
+            double r, rl;
+            std::int64_t q;
+            reduce(a, r, rl, q);
+            const double s = sin_kernel(r, rl), c = cos_kernel(r, rl);
+            const double v = q & 1 ? s : c;
+            y[j] = (q + 1) & 2 ? -v : v;
+        },
+        [y](std::size_t j, double a) { y[j] = std::cos(a); });
+}
+
+void sincos(std::size_t n, const double* x, double* s, double* c) noexcept {
+    trig_blocks(
+        n, x,
+        [s, c](std::size_t j, double a) {
+            double r, rl;
+            std::int64_t q;
+            reduce(a, r, rl, q);
+            const double ks = sin_kernel(r, rl), kc = cos_kernel(r, rl);
+            const double vs = q & 1 ? kc : ks;
+            const double vc = q & 1 ? ks : kc;
+            s[j] = a == 0.0 ? a : q & 2 ? -vs : vs;
+            c[j] = (q + 1) & 2 ? -vc : vc;
+        },
+        [s, c](std::size_t j, double a) {
+            s[j] = std::sin(a);
+            c[j] = std::cos(a);
+        });
+}
+
+void pow_pair(std::size_t n, const double* x, double p, double* hi, double* lo) noexcept {
+    // Zero and infinite bases, and results that are not normal, take a
+    // second `pow`: there the product gets signs wrong (`-0`, `-inf` for
+    // non-integral `p`) or rounds twice into a subnormal.
+    auto exact = [](double a, double h) {
+        return std::abs(h) >= 0x1p-1022 && std::abs(h) <= std::numeric_limits<double>::max() &&
+               std::abs(a) <= std::numeric_limits<double>::max();
+    };
+    for (std::size_t b = 0; b < n; b += kBlock) {
+        const std::size_t len = std::min(kBlock, n - b);
+        double arg[kBlock];
+        std::copy_n(x + b, len, arg);
+        int special = 0;
+        for (std::size_t j = 0; j < len; ++j) {
+            const double a = arg[j];
+            const double l = std::pow(a, p - 1.0);
+            lo[b + j] = l;
+            hi[b + j] = l * a;
+            special |= !exact(a, l * a);
+        }
+        if (special)
+            for (std::size_t j = 0; j < len; ++j)
+                if (!exact(arg[j], hi[b + j]))
+                    hi[b + j] = std::pow(arg[j], p);
+    }
+}
+
+void exp(std::size_t n, const float* x, float* y) noexcept {
+    for (std::size_t j = 0; j < n; ++j)
+        y[j] = expf1(x[j]);
+}
+
+void log(std::size_t n, const float* x, float* y) noexcept {
+    for (std::size_t j = 0; j < n; ++j)
+        y[j] = logf1(x[j]);
+}
+
+void tanh(std::size_t n, const float* x, float* y) noexcept {
+    for (std::size_t j = 0; j < n; ++j)
+        y[j] = tanhf1(x[j]);
+}
+
+void sin(std::size_t n, const float* x, float* y) noexcept {
+    trig_blocks(
+        n, x,
+        [y](std::size_t j, float a) {
+            float r;
+            std::int32_t q;
+            reducef(a, r, q);
+            const float v = q & 1 ? cosf_kernel(r) : sinf_kernel(r);
+            y[j] = a == 0.0f ? a : q & 2 ? -v : v;
+        },
+        [y](std::size_t j, float a) { y[j] = std::sin(a); });
+}
+
+void cos(std::size_t n, const float* x, float* y) noexcept {
+    trig_blocks(
+        n, x,
+        [y](std::size_t j, float a) {
+            float r;
+            std::int32_t q;
+            reducef(a, r, q);
+            const float v = q & 1 ? sinf_kernel(r) : cosf_kernel(r);
+            y[j] = (q + 1) & 2 ? -v : v;
+        },
+        [y](std::size_t j, float a) { y[j] = std::cos(a); });
+}
+
+void sincos(std::size_t n, const float* x, float* s, float* c) noexcept {
+    trig_blocks(
+        n, x,
+        [s, c](std::size_t j, float a) {
+            float r;
+            std::int32_t q;
+            reducef(a, r, q);
+            const float ks = sinf_kernel(r), kc = cosf_kernel(r);
+            const float vs = q & 1 ? kc : ks;
+            const float vc = q & 1 ? ks : kc;
+            s[j] = a == 0.0f ? a : q & 2 ? -vs : vs;
+            c[j] = (q + 1) & 2 ? -vc : vc;
+        },
+        [s, c](std::size_t j, float a) {
+            s[j] = std::sin(a);
+            c[j] = std::cos(a);
+        });
+}
+
+}  // namespace fte::vmath
@@ -0,0 +1,90 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/batch.hpp"
+#include "fte/parser.hpp"
+#include "fte/program.hpp"
+
+using namespace fte;
+
+namespace {
+
+bool same_bits(double a, double b) { return std::memcmp(&a, &b, sizeof a) == 0; }
+
+/// Columns of `program`'s outputs at every point of `in`, by `Program::eval`.
+std::vector<std::vector<double>> reference(const Program& program,
+                                           const std::vector<std::vector<double>>& in) {
+    const std::size_t n = in[0].size();
+    std::vector<std::vector<double>> ref(program.num_outputs(), std::vector<double>(n));
+    std::vector<double> x(in.size()), y(program.num_outputs());
+    for (std::size_t p = 0; p < n; ++p) {
+        for (std::size_t i = 0; i < in.size(); ++i)
+            x[i] = in[i][p];
+        program.eval(x, y);
+        for (std::size_t r = 0; r < y.size(); ++r)
+            ref[r][p] = y[r];
+    }
+    return ref;
+}
+
+}  // namespace
+
+int main() {
+    ExprPool pool;
+    SymbolTable symbols;
+    symbols.intern("x");
+    symbols.intern("y");
+    // Derivatives of sin and x^3 hold the pairs the evaluator fuses.
+    const Program program = gradient_program(
+        pool, parse("sin(x*y) + x^3*exp(y) - log(x)*cos(y) + sqrt(x)/y", pool, symbols), 2);
+
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> u(0.1, 3.0);
+    const std::size_t n = 1000;  // not a multiple of any tile below
+    std::vector<std::vector<double>> in(2, std::vector<double>(n));
+    for (auto& column : in)
+        for (double& v : column)
+            v = u(rng);
+    const auto ref = reference(program, in);
+    const std::vector<const double*> in_ptr{in[0].data(), in[1].data()};
+
+    for (std::size_t tile : {std::size_t{1}, std::size_t{64}, BatchEvaluator::kDefaultTile, n + 7}) {
+        for (bool vector_math : {false, true}) {
+            BatchEvaluator eval(program, tile, vector_math);
+            FTE_CHECK(vector_math == (eval.num_fused() > 0));
+            // Twice through the same scratch, then a short batch.
+            for (std::size_t count : {n, n, std::size_t{3}}) {
+                std::vector<std::vector<double>> out(program.num_outputs(), std::vector<double>(n, -1.0));
+                std::vector<double*> out_ptr;
+                for (auto& column : out)
+                    out_ptr.push_back(column.data());
+                eval(in_ptr, out_ptr, count);
+                for (std::size_t r = 0; r < out.size(); ++r)
+                    for (std::size_t p = 0; p < n; ++p) {
+                        if (p >= count)
+                            FTE_CHECK(out[r][p] == -1.0);
+                        else if (!vector_math)
+                            FTE_CHECK(same_bits(out[r][p], ref[r][p]));
+                        else
+                            FTE_CHECK(std::abs(out[r][p] - ref[r][p]) <=
+                                      1e-13 * std::max(std::abs(ref[r][p]), 1.0));
+                    }
+            }
+        }
+    }
+
+    // The one-shot wrapper, and an empty batch.
+    std::vector<std::vector<double>> out(program.num_outputs(), std::vector<double>(n));
+    std::vector<double*> out_ptr;
+    for (auto& column : out)
+        out_ptr.push_back(column.data());
+    evaluate_batch(program, in_ptr, out_ptr, 0);
+    evaluate_batch(program, in_ptr, out_ptr, n);
+    for (std::size_t r = 0; r < out.size(); ++r)
+        for (std::size_t p = 0; p < n; ++p)
+            FTE_CHECK(std::abs(out[r][p] - ref[r][p]) <= 1e-13 * std::max(std::abs(ref[r][p]), 1.0));
+    return fte::test::result();
+}
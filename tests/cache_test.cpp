@@ -0,0 +1,42 @@
+#include <cmath>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/cache.hpp"
+#include "fte/parser.hpp"
+
+using namespace fte;
+
+int main() {
+    ExprPool pool;
+    SymbolTable symbols;
+    symbols.intern("x");
+    symbols.intern("y");
+    DerivativeCache cache;
+
+    // Renamed and reordered formulas share an entry; others do not.
+    const CachedGradient a = cache.gradient(parse("x*sin(y) + x/y", pool, symbols));
+    const CachedGradient b = cache.gradient(parse("y/x + sin(x)*y", pool, symbols));
+    const CachedGradient c = cache.gradient(parse("x*cos(y) + x/y", pool, symbols));
+    FTE_CHECK(!a.hit);
+    FTE_CHECK(b.hit && b.entry == a.entry);
+    FTE_CHECK(!c.hit && c.entry != a.entry);
+
+    // Entries sharing a hash must also share the structure.
+    FTE_CHECK(canonical_form(parse("x*sin(y) + x/y", pool, symbols)).structure ==
+              canonical_form(parse("y/x + sin(x)*y", pool, symbols)).structure);
+    FTE_CHECK(canonical_form(parse("x - 3*y", pool, symbols)).structure !=
+              canonical_form(parse("x - 2*y", pool, symbols)).structure);
+
+    // b's gradient comes out in b's own variable numbering.
+    std::vector<double> grad(2, 0.0);
+    const double x = 0.7, y = 1.3;
+    const double value = b.evaluate(std::vector<double>{x, y}, grad);
+    FTE_CHECK_REL(value, y / x + std::sin(x) * y, 1e-15);
+    FTE_CHECK_REL(grad[0], -y / (x * x) + std::cos(x) * y, 1e-15);
+    FTE_CHECK_REL(grad[1], 1.0 / x + std::sin(x), 1e-15);
+
+    const DerivativeCacheStats stats = cache.stats();
+    FTE_CHECK(stats.hits == 1 && stats.misses == 2 && stats.entries == 2);
+    return fte::test::result();
+}
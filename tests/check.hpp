@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal assertions for the regression tests: a failed check prints its
+// location and the test exits non-zero once all checks have run.
+
+namespace fte::test {
+
+inline int& failures() {
+    static int n = 0;
+    return n;
+}
+
+inline void fail(const char* file, int line, const char* what) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    ++failures();
+}
+
+inline int result() {
+    if (failures() != 0)
+        std::fprintf(stderr, "%d check(s) failed\n", failures());
+    return failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}  // namespace fte::test
+
+#define FTE_CHECK(cond) \
+    ((cond) ? void() : ::fte::test::fail(__FILE__, __LINE__, #cond))
+
+/// |a - b| <= tol * max(|b|, tiny), with NaNs failing.
+#define FTE_CHECK_REL(a, b, tol)                                                     \
+    FTE_CHECK(std::abs((a) - (b)) <= (tol) * std::max(std::abs(b), 1e-300))
@@ -0,0 +1,66 @@
+#include <cmath>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/checkpoint.hpp"
+
+using namespace fte;
+
+int main() {
+    Tape tape;
+
+    // x_{i+1} = p x_i, objective x_N: d/dx0 = p^N, d/dp = N p^(N-1) x0. With
+    // default options every state fits the budget; this used to recurse
+    // once per step and overflow the stack.
+    {
+        const StepFunction step = [](std::size_t, std::span<const Real> x, std::span<const Real> p,
+                                     std::span<Real> next) { next[0] = p[0] * x[0]; };
+        const ObjectiveFunction objective = [](std::span<const Real> x, std::span<const Real>) {
+            return x[0];
+        };
+        const std::size_t steps = 200000;
+        const double x0 = 1.5, p = 1.0 + 1e-6;
+        double gx = 0.0, gp = 0.0;
+        CheckpointStats stats;
+        const double value = checkpointed_gradient(tape, step, objective, steps, {&x0, 1}, {&p, 1},
+                                                   {&gx, 1}, {&gp, 1}, {}, &stats);
+        const double n = static_cast<double>(steps);
+        FTE_CHECK_REL(value, x0 * std::pow(p, n), 1e-9);
+        FTE_CHECK_REL(gx, std::pow(p, n), 1e-9);
+        FTE_CHECK_REL(gp, n * std::pow(p, n - 1.0) * x0, 1e-9);
+        FTE_CHECK(stats.recorded_steps == steps);
+        FTE_CHECK(stats.advanced_steps == steps - 1);
+    }
+
+    // A nonlinear step gives the same gradient under every snapshot count.
+    {
+        const StepFunction step = [](std::size_t, std::span<const Real> x, std::span<const Real> p,
+                                     std::span<Real> next) {
+            next[0] = x[0] + 0.01 * sin(p[0] * x[1]);
+            next[1] = x[1] - 0.01 * x[0] * x[0];
+        };
+        const ObjectiveFunction objective = [](std::span<const Real> x, std::span<const Real>) {
+            return x[0] * x[1];
+        };
+        const std::size_t steps = 1000;
+        const std::vector<double> x0{0.3, 0.8}, p{1.7};
+        std::vector<double> ref_x(2), ref_p(1);
+        CheckpointOptions all;
+        all.max_snapshots = steps + 1;
+        const double ref = checkpointed_gradient(tape, step, objective, steps, x0, p, ref_x, ref_p, all);
+        for (std::size_t s : {1, 2, 3, 10, 999}) {
+            CheckpointOptions options;
+            options.max_snapshots = s;
+            std::vector<double> gx(2), gp(1);
+            CheckpointStats stats;
+            const double value =
+                checkpointed_gradient(tape, step, objective, steps, x0, p, gx, gp, options, &stats);
+            FTE_CHECK(value == ref);
+            FTE_CHECK_REL(gx[0], ref_x[0], 1e-13);
+            FTE_CHECK_REL(gx[1], ref_x[1], 1e-13);
+            FTE_CHECK_REL(gp[0], ref_p[0], 1e-13);
+            FTE_CHECK(stats.recorded_steps == steps);
+        }
+    }
+    return fte::test::result();
+}
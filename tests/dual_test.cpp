@@ -0,0 +1,88 @@
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/derivative.hpp"
+#include "fte/dual.hpp"
+#include "fte/eval.hpp"
+#include "fte/parser.hpp"
+
+using namespace fte;
+
+namespace {
+
+constexpr std::uint32_t kVars = 11;
+
+/// Symbolic gradients of `roots` at `x`, row-major.
+std::vector<double> symbolic_jacobian(ExprPool& pool, std::span<const Node* const> roots,
+                                      const std::vector<double>& x) {
+    std::vector<double> jac;
+    for (const Node* r : roots)
+        for (std::uint32_t i = 0; i < kVars; ++i)
+            jac.push_back(evaluate(differentiate(pool, r, i), x));
+    return jac;
+}
+
+template <std::size_t N>
+void check_directions(std::span<const Node* const> roots, const std::vector<double>& x,
+                      const std::vector<double>& jac, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<double> seeds(N * kVars), out(N * roots.size());
+    for (double& s : seeds)
+        s = u(rng);
+    const std::vector<double> y = directional_derivatives<N>(roots, x, seeds, out);
+    for (std::size_t r = 0; r < roots.size(); ++r) {
+        FTE_CHECK_REL(y[r], evaluate(roots[r], x), 1e-15);
+        for (std::size_t k = 0; k < N; ++k) {
+            double ref = 0.0;
+            for (std::uint32_t i = 0; i < kVars; ++i)
+                ref += jac[r * kVars + i] * seeds[k * kVars + i];
+            FTE_CHECK(std::abs(out[r * N + k] - ref) <= 1e-12 * std::max(std::abs(ref), 1.0));
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    ExprPool pool;
+    SymbolTable symbols;
+    // x0*sin(x1) + exp(x2)*sin(x3) + ... over every variable, in order.
+    std::ostringstream text;
+    text << "x0";
+    for (std::uint32_t i = 1; i < kVars; ++i)
+        text << (i % 2 ? "*sin(x" : " + exp(x") << i << ')';
+    const Node* roots[] = {
+        parse(text.str(), pool, symbols),
+        parse("x3^2.5 * log(x7) - x10/x1 + tanh(x2*x9)", pool, symbols),
+        pool.constant(4.0),
+    };
+    FTE_CHECK(symbols.size() == kVars);
+    std::vector<double> x(kVars);
+    for (std::uint32_t i = 0; i < kVars; ++i)
+        x[i] = 0.3 + 0.11 * i;
+    const std::vector<double> jac = symbolic_jacobian(pool, roots, x);
+
+    // Random directions in the default width and in a narrower one.
+    std::mt19937_64 rng(3);
+    check_directions<kDualWidth>(roots, x, jac, rng);
+    check_directions<4>(roots, x, jac, rng);
+
+    // More columns than one pass carries.
+    for (const std::vector<double>& j : {jacobian(roots, x), jacobian<4>(roots, x)})
+        for (std::size_t e = 0; e < jac.size(); ++e)
+            FTE_CHECK(std::abs(j[e] - jac[e]) <= 1e-12 * std::max(std::abs(jac[e]), 1.0));
+
+    std::vector<double> seeds(4 * kVars), out(4);
+    bool threw = false;
+    try {
+        directional_derivatives<4>(roots, x, seeds, out);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    FTE_CHECK(threw);
+    return fte::test::result();
+}
@@ -0,0 +1,82 @@
+#include <cmath>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/derivative.hpp"
+#include "fte/eval.hpp"
+#include "fte/parser.hpp"
+
+using namespace fte;
+
+namespace {
+
+/// Central difference of `f` in `x_i`.
+double finite_difference(const Node* f, std::vector<double> x, std::uint32_t i) {
+    const double h = 1e-6 * std::max(std::abs(x[i]), 1.0);
+    x[i] += h;
+    const double up = evaluate(f, x);
+    x[i] -= 2 * h;
+    return (up - evaluate(f, x)) / (2 * h);
+}
+
+}  // namespace
+
+int main() {
+    ExprPool pool;
+    const Node* x = pool.variable(0);
+    const Node* y = pool.variable(1);
+
+    // Structural equality is pointer equality, after local identities and
+    // canonical operand order.
+    FTE_CHECK(pool.mul(pool.sin(x), y) == pool.mul(y, pool.sin(x)));
+    FTE_CHECK(pool.add(x, pool.constant(0.0)) == x && pool.mul(x, pool.constant(1.0)) == x);
+    FTE_CHECK(pool.mul(x, pool.constant(0.0)) == pool.constant(0.0));
+    FTE_CHECK(pool.sub(pool.sin(x), pool.sin(x)) == pool.constant(0.0));
+    FTE_CHECK(pool.add(pool.constant(2.0), pool.constant(3.0)) == pool.constant(5.0));
+    FTE_CHECK(pool.sub(x, y) != pool.sub(y, x));
+    const std::size_t before = pool.size();
+    pool.mul(pool.sin(x), y);
+    FTE_CHECK(pool.size() == before);
+
+    // Hashes depend on structure only, not on the pool or creation order.
+    {
+        ExprPool other;
+        const Node* b = other.cos(other.variable(1));
+        const Node* a = other.mul(other.sin(other.variable(0)), b);
+        FTE_CHECK(a->hash == pool.mul(pool.sin(x), pool.cos(y))->hash);
+    }
+
+    // Nested functions: the chain rule shares every inner subterm, so the
+    // derivative grows linearly with the depth.
+    const Node* deep = x;
+    for (int i = 0; i < 200; ++i)
+        deep = pool.sin(pool.mul(deep, y));
+    const Node* d_deep = differentiate(pool, deep, 0);
+    FTE_CHECK(dag_size(std::span<const Node* const>(&d_deep, 1)) < 10 * 200);
+
+    // Symbolic and adjoint gradients agree with each other and with finite
+    // differences.
+    SymbolTable symbols;
+    for (const char* name : {"a", "b", "c"})
+        symbols.intern(name);
+    const char* formulas[] = {
+        "a*b*c + sin(a*b)*exp(c)",
+        "log(a*a + b) / (1 + c^2) - sqrt(b)*tanh(a - c)",
+        "a^b + cos(c)^3 + tan(a/4)",
+    };
+    const std::vector<double> p{0.8, 1.7, -0.3};
+    for (const char* text : formulas) {
+        const Node* f = parse(text, pool, symbols);
+        const std::vector<const Node*> g = gradient(pool, f, 3);
+        const std::vector<const Node*> ga = adjoint_gradient(pool, f, 3);
+        for (std::uint32_t i = 0; i < 3; ++i) {
+            const double s = evaluate(g[i], p);
+            FTE_CHECK_REL(evaluate(ga[i], p), s, 1e-13);
+            FTE_CHECK_REL(finite_difference(f, p, i), s, 1e-7);
+        }
+    }
+
+    pool.clear();
+    FTE_CHECK(pool.size() == 0 && pool.variable(0)->id == 0);
+    return fte::test::result();
+}
@@ -0,0 +1,88 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/derivative.hpp"
+#include "fte/eval.hpp"
+#include "fte/hvp.hpp"
+#include "fte/parser.hpp"
+
+using namespace fte;
+
+namespace {
+
+constexpr std::uint32_t kVars = 5;
+
+bool close(double a, double b) { return std::abs(a - b) <= 1e-11 * std::max(std::abs(b), 1.0); }
+
+}  // namespace
+
+int main() {
+    const char* formulas[] = {
+        "a^3*b + sin(c*d)*exp(e) + (b*b + 1)^2.5 + a/e + tanh(c - d)*log(e)",
+        "sqrt(a*b + c^2) + cos(d)*e^1.5 - a^-2 + pow(b, 4)",
+        "(a + b + c + d + e)^2 * exp(-a*e) + c",
+    };
+    const std::vector<double> x{0.7, 1.3, -0.4, 0.9, 1.6};
+    std::mt19937_64 rng(9);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    // More directions than one sweep carries, and a ragged last batch.
+    const std::size_t k = 2 * HvpEvaluator::kWidth + 3;
+    std::vector<double> v(k * kVars);
+    for (double& vi : v)
+        vi = u(rng);
+
+    for (const char* text : formulas) {
+        ExprPool pool;
+        SymbolTable symbols;
+        for (const char* name : {"a", "b", "c", "d", "e"})
+            symbols.intern(name);
+        const Node* f = parse(text, pool, symbols);
+
+        // Dense symbolic Hessian.
+        std::vector<double> h(kVars * kVars), grad(kVars);
+        for (std::uint32_t i = 0; i < kVars; ++i) {
+            const Node* fi = differentiate(pool, f, i);
+            grad[i] = evaluate(fi, x);
+            for (std::uint32_t j = 0; j < kVars; ++j)
+                h[i * kVars + j] = evaluate(differentiate(pool, fi, j), x);
+        }
+
+        Tape tape;
+        std::vector<double> hv(k * kVars);
+        FTE_CHECK(close(hessian_vector_products(tape, f, x, v, k, hv), evaluate(f, x)));
+        for (std::size_t d = 0; d < k; ++d)
+            for (std::uint32_t i = 0; i < kVars; ++i) {
+                double ref = 0.0;
+                for (std::uint32_t j = 0; j < kVars; ++j)
+                    ref += h[i * kVars + j] * v[d * kVars + j];
+                FTE_CHECK(close(hv[d * kVars + i], ref));
+            }
+
+        // The evaluator keeps its tape copy: the gradient is the tape's, and
+        // the unit directions give the Hessian's rows, in any batch size.
+        tape.clear();
+        Tape::Scope scope(tape);
+        std::vector<Real> xs;
+        for (double xi : x)
+            xs.push_back(tape.input(xi));
+        const Real y = evaluate<Real>(std::span<const Node* const>(&f, 1), std::span<const Real>(xs))[0];
+        HvpEvaluator hvp(tape, y);
+        tape.clear();
+        FTE_CHECK(hvp.num_inputs() == kVars);
+        for (std::uint32_t i = 0; i < kVars; ++i)
+            FTE_CHECK(close(hvp.gradient()[i], grad[i]));
+        std::vector<double> unit(kVars * kVars, 0.0), rows(kVars * kVars);
+        for (std::uint32_t i = 0; i < kVars; ++i)
+            unit[i * kVars + i] = 1.0;
+        for (std::size_t batch : {std::size_t{kVars}, std::size_t{1}}) {
+            for (std::size_t d = 0; d < kVars; d += batch)
+                hvp(std::span(unit).subspan(d * kVars, batch * kVars), batch,
+                    std::span(rows).subspan(d * kVars, batch * kVars));
+            for (std::uint32_t i = 0; i < kVars * kVars; ++i)
+                FTE_CHECK(close(rows[i], h[i]));
+        }
+    }
+    return fte::test::result();
+}
@@ -0,0 +1,84 @@
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/eval.hpp"
+#include "fte/incremental.hpp"
+
+using namespace fte;
+
+namespace {
+
+/// A sum of `n` terms in x and y, the last one `last`.
+std::string formula(int n, const std::string& last) {
+    std::string text;
+    for (int i = 1; i < n; ++i)
+        text += "sin(x*" + std::to_string(i) + " + y)*exp(y/" + std::to_string(i) + ") + ";
+    return text + last;
+}
+
+/// Does the incremental gradient agree with a fresh `gradient()` of its
+/// function, evaluated at `x`?
+bool matches_fresh(IncrementalGradient& g, const std::vector<double>& x) {
+    const auto n = static_cast<std::uint32_t>(g.gradient().size());
+    const std::vector<const Node*> fresh = gradient(g.pool(), g.function(), n);
+    bool ok = fresh.size() == n;
+    for (std::uint32_t v = 0; v < n && ok; ++v) {
+        const double a = evaluate(g.gradient()[v], x), b = evaluate(fresh[v], x);
+        ok = std::abs(a - b) <= 1e-12 * std::max(std::abs(b), 1.0);
+    }
+    return ok;
+}
+
+}  // namespace
+
+int main() {
+    constexpr int kTerms = 400;
+    const std::vector<double> x{0.3, -0.7, 1.1};
+    IncrementalGradient g;
+
+    const EditStats first = g.update(formula(kTerms, "x*y"));
+    FTE_CHECK(first.variables == 2 && first.new_variables == 2);
+    FTE_CHECK(first.changed_nodes > 5 * kTerms && first.reused == 0);
+    FTE_CHECK(matches_fresh(g, x));
+
+    // One term of the sum edited: only it and the root are new.
+    const EditStats edit = g.update(formula(kTerms, "x*cos(y)"));
+    FTE_CHECK(edit.new_variables == 0);
+    FTE_CHECK(edit.changed_nodes <= 4);
+    FTE_CHECK(edit.recomputed <= 2 * edit.changed_nodes);
+    FTE_CHECK(edit.reused > 0);
+    FTE_CHECK(matches_fresh(g, x));
+
+    // Undoing the edit finds the first version again.
+    const EditStats undo = g.update(formula(kTerms, "x*y"));
+    FTE_CHECK(undo.changed_nodes == 0 && undo.recomputed == 0);
+    FTE_CHECK(matches_fresh(g, x));
+
+    // A new variable costs one full pass for itself only.
+    const EditStats widened = g.update(formula(kTerms, "x*z"));
+    FTE_CHECK(widened.variables == 3 && widened.new_variables == 1);
+    FTE_CHECK(widened.changed_nodes <= 4);
+    FTE_CHECK(widened.recomputed > first.changed_nodes);
+    FTE_CHECK(g.gradient().size() == 3 && matches_fresh(g, x));
+    FTE_CHECK(evaluate(g.gradient()[2], x) == x[0]);
+
+    // A syntax error leaves the current version in place.
+    const Node* before = g.function();
+    try {
+        g.update(formula(kTerms, "x*"));
+        FTE_CHECK(false);
+    } catch (const ParseError&) {
+    }
+    FTE_CHECK(g.function() == before && g.gradient().size() == 3);
+
+    // After a reset, symbols are numbered afresh: y is now variable 0.
+    g.reset();
+    FTE_CHECK(g.function() == nullptr && g.gradient().empty() && g.symbols().size() == 0);
+    const EditStats again = g.update("y*y + x");
+    FTE_CHECK(again.variables == 2 && again.new_variables == 2 && again.reused == 0);
+    FTE_CHECK(matches_fresh(g, {0.5, 2.0}));
+    FTE_CHECK(evaluate(g.gradient()[0], std::vector<double>{0.5, 2.0}) == 1.0);
+    return fte::test::result();
+}
@@ -0,0 +1,83 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/eval.hpp"
+#include "fte/interval.hpp"
+#include "fte/parser.hpp"
+
+using namespace fte;
+
+namespace {
+
+struct Bounds {
+    double lo, hi;
+};
+
+/// Enclosure of `text` over the box `[lo_i, hi_i]` by each evaluator.
+template <class Evaluator>
+Bounds enclose(const char* text, const std::vector<double>& lo, const std::vector<double>& hi) {
+    ExprPool pool;
+    SymbolTable symbols;
+    symbols.intern("x");
+    symbols.intern("y");
+    const Node* f = parse(text, pool, symbols);
+    const Program program = linearize(std::span<const Node* const>(&f, 1), 2);
+    std::vector<const double*> in_lo{&lo[0], &lo[1]}, in_hi{&hi[0], &hi[1]};
+    Bounds b{};
+    double* out_lo[] = {&b.lo};
+    double* out_hi[] = {&b.hi};
+    Evaluator evaluator(program);
+    evaluator(in_lo, in_hi, out_lo, out_hi, 1);
+    return b;
+}
+
+bool whole_line(const Bounds& b) { return b.lo == -INFINITY && b.hi == INFINITY; }
+
+}  // namespace
+
+int main() {
+    // Zero-spanning divisors leave no finite bound, never an empty one.
+    const std::vector<double> lo{-1.0, -1.0}, hi{1.0, 1.0};
+    for (const char* text : {"x/y", "x*(1/y)", "(x/y)*2+x", "exp(x/y)*y", "sin(x/y)*(x/y)"}) {
+        FTE_CHECK(whole_line(enclose<IntervalEvaluator>(text, lo, hi)));
+        FTE_CHECK(whole_line(enclose<AffineEvaluator>(text, lo, hi)));
+    }
+
+    // Overflowing centers are unbounded rather than NaN.
+    {
+        const Bounds b = enclose<AffineEvaluator>("exp(x)*exp(y) - exp(x)",
+                                                  {700.0, 700.0}, {710.0, 710.0});
+        FTE_CHECK(whole_line(b));
+    }
+
+    // Both evaluators enclose sampled values on random boxes.
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> u(-2.0, 2.0);
+    for (const char* text : {"x*(1-x) + y", "x/y + y*y", "exp(x)/(1+y*y)", "sqrt(x*x+y*y)*x"}) {
+        ExprPool pool;
+        SymbolTable symbols;
+        symbols.intern("x");
+        symbols.intern("y");
+        const Node* f = parse(text, pool, symbols);
+        for (int box = 0; box < 200; ++box) {
+            std::vector<double> l{u(rng), u(rng)}, h(2);
+            h[0] = l[0] + std::abs(u(rng));
+            h[1] = l[1] + std::abs(u(rng));
+            const Bounds a = enclose<AffineEvaluator>(text, l, h);
+            const Bounds i = enclose<IntervalEvaluator>(text, l, h);
+            for (int k = 0; k < 20; ++k) {
+                const double t = (k + 0.5) / 20;
+                const std::vector<double> x{l[0] + t * (h[0] - l[0]), h[1] - t * (h[1] - l[1])};
+                const double v = evaluate<double>(std::span<const Node* const>(&f, 1),
+                                                  std::span<const double>(x))[0];
+                if (std::isnan(v))
+                    continue;
+                FTE_CHECK(a.lo <= v && v <= a.hi);
+                FTE_CHECK(i.lo <= v && v <= i.hi);
+            }
+        }
+    }
+    return fte::test::result();
+}
@@ -0,0 +1,99 @@
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "check.hpp"
+#include "fte/jit.hpp"
+#include "fte/parser.hpp"
+#include "fte/program.hpp"
+
+using namespace fte;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+std::string read(const fs::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    std::ostringstream s;
+    s << in.rdbuf();
+    return s.str();
+}
+
+/// Compile `root` into `cache`, check it against `Program::eval` and
+/// return where it was cached.
+fs::path compile_and_check(const Node* root, const fs::path& cache, bool& from_cache) {
+    const std::span<const Node* const> roots(&root, 1);
+    JitOptions options;
+    options.cache_dir = cache;
+    const CompiledKernel k = CompiledKernel::compile(roots, options);
+    from_cache = k.from_cache();
+    FTE_CHECK(k.key() == kernel_key(roots, options));
+    const Program program = linearize(roots, 2);
+    for (double x : {-1.5, 0.25, 3.0}) {
+        const std::vector<double> in{x, 0.5 - x};
+        double out = 0.0;
+        std::vector<double> ref(1);
+        k(in.data(), &out);
+        program.eval(in, ref);
+        FTE_CHECK(std::abs(out - ref[0]) <= 1e-12 * std::max(std::abs(ref[0]), 1.0));
+    }
+    return k.path();
+}
+
+}  // namespace
+
+int main() {
+    const fs::path cache = fs::temp_directory_path() / ("fte-jit-test-" + std::to_string(::getpid()));
+    ExprPool pool;
+    SymbolTable symbols;
+    symbols.intern("x");
+    symbols.intern("y");
+    const Node* f = parse("sin(x)*y + exp(x*y)", pool, symbols);
+    const Node* g = parse("cos(x) - y/(1 + x*x)", pool, symbols);
+
+    // Built once, then loaded; the source is published beside the object.
+    bool hit = true;
+    const fs::path so_f = compile_and_check(f, cache, hit);
+    FTE_CHECK(!hit);
+    fs::path cpp_f = so_f;
+    cpp_f.replace_extension(".cpp");
+    FTE_CHECK(fs::exists(so_f) && fs::exists(cpp_f));
+    compile_and_check(f, cache, hit);
+    FTE_CHECK(hit);
+    const fs::path so_g = compile_and_check(g, cache, hit);
+    FTE_CHECK(!hit && so_g != so_f);
+    fs::path cpp_g = so_g;
+    cpp_g.replace_extension(".cpp");
+
+    // A forged entry: g's object and source under f's key. f is compiled
+    // privately and the entry is left alone.
+    fs::copy_file(so_g, so_f, fs::copy_options::overwrite_existing);
+    fs::copy_file(cpp_g, cpp_f, fs::copy_options::overwrite_existing);
+    FTE_CHECK(compile_and_check(f, cache, hit) != so_f && !hit);
+    FTE_CHECK(read(cpp_f) == read(cpp_g));
+    compile_and_check(f, cache, hit);
+    FTE_CHECK(!hit);
+
+    // An object without its source is rebuilt and republished.
+    fs::remove(cpp_f);
+    FTE_CHECK(compile_and_check(f, cache, hit) == so_f && !hit);
+    FTE_CHECK(read(cpp_f) != read(cpp_g));
+    compile_and_check(f, cache, hit);
+    FTE_CHECK(hit);
+
+    // Nothing but published entries is left behind.
+    std::size_t files = 0;
+    for (const auto& e : fs::directory_iterator(cache))
+        files += e.is_regular_file();
+    FTE_CHECK(files == 4);
+
+    std::error_code ec;
+    fs::remove_all(cache, ec);
+    return fte::test::result();
+}
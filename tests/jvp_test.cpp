@@ -0,0 +1,97 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/derivative.hpp"
+#include "fte/dual.hpp"
+#include "fte/eval.hpp"
+#include "fte/jvp.hpp"
+#include "fte/parser.hpp"
+
+using namespace fte;
+
+namespace {
+
+constexpr std::uint32_t kVars = 4;
+
+bool close(double a, double b) { return std::abs(a - b) <= 1e-11 * std::max(std::abs(b), 1.0); }
+
+}  // namespace
+
+int main() {
+    const char* formulas[] = {
+        "a^3*b + sin(c*d)*exp(a) + (b*b + 1)^2.5 - c/d",
+        "sqrt(a*b + c^2) + cos(d)*b^1.5 - a^-2 + tanh(a - d)*log(b)",
+    };
+    const std::vector<double> x{0.7, 1.3, -0.4, 0.9};
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+
+    for (const char* text : formulas) {
+        ExprPool pool;
+        SymbolTable symbols;
+        for (const char* name : {"a", "b", "c", "d"})
+            symbols.intern(name);
+        const Node* f = parse(text, pool, symbols);
+        // f, its gradient and two trivial outputs; the Jacobian's rows are
+        // the gradient and the Hessian.
+        std::vector<const Node*> roots{f};
+        for (std::uint32_t i = 0; i < kVars; ++i)
+            roots.push_back(differentiate(pool, f, i));
+        roots.push_back(pool.variable(2));
+        roots.push_back(pool.constant(3.0));
+        const std::size_t m = roots.size();
+        std::vector<double> jac(m * kVars), y_ref(m);
+        for (std::size_t r = 0; r < m; ++r) {
+            y_ref[r] = evaluate(roots[r], x);
+            for (std::uint32_t i = 0; i < kVars; ++i)
+                jac[r * kVars + i] = evaluate(differentiate(pool, roots[r], i), x);
+        }
+
+        for (bool reuse : {true, false}) {
+            const Program program = linearize(roots, kVars, {.reuse_slots = reuse});
+            JvpEvaluator jvp_eval(program);
+            VjpEvaluator vjp_eval(program);
+            // Twice with different batch sizes, through the same scratch.
+            for (std::size_t k : {kDualWidth + 3, std::size_t{1}}) {
+                std::vector<double> v(k * kVars), w(k * m), jv(k * m), wj(k * kVars), y(m), y2(m);
+                for (double& e : v)
+                    e = u(rng);
+                for (double& e : w)
+                    e = u(rng);
+                jvp_eval(x, v, k, y, jv);
+                vjp_eval(x, w, k, y2, wj);
+                for (std::size_t r = 0; r < m; ++r)
+                    FTE_CHECK(close(y[r], y_ref[r]) && close(y2[r], y_ref[r]));
+                for (std::size_t d = 0; d < k; ++d) {
+                    for (std::size_t r = 0; r < m; ++r) {
+                        double ref = 0.0;
+                        for (std::uint32_t i = 0; i < kVars; ++i)
+                            ref += jac[r * kVars + i] * v[d * kVars + i];
+                        FTE_CHECK(close(jv[d * m + r], ref));
+                    }
+                    for (std::uint32_t i = 0; i < kVars; ++i) {
+                        double ref = 0.0;
+                        for (std::size_t r = 0; r < m; ++r)
+                            ref += w[d * m + r] * jac[r * kVars + i];
+                        FTE_CHECK(close(wj[d * kVars + i], ref));
+                    }
+                }
+            }
+
+            // Seeding f alone gives the gradient; the one-shot wrappers
+            // agree, with no outputs requested.
+            std::vector<double> seed(m, 0.0), grad(kVars), e0(kVars, 0.0), col(m);
+            seed[0] = 1.0;
+            e0[0] = 1.0;
+            vjp(program, x, seed, 1, {}, grad);
+            jvp(program, x, e0, 1, {}, col);
+            for (std::uint32_t i = 0; i < kVars; ++i)
+                FTE_CHECK(close(grad[i], y_ref[1 + i]));
+            for (std::size_t r = 0; r < m; ++r)
+                FTE_CHECK(close(col[r], jac[r * kVars]));
+        }
+    }
+    return fte::test::result();
+}
@@ -0,0 +1,107 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/mixed.hpp"
+#include "fte/parser.hpp"
+
+using namespace fte;
+
+namespace {
+
+/// Largest error of a `MixedPrecisionEvaluator` over the gradient program
+/// of `text` at `x`, `y`, relative to each output's largest magnitude, or
+/// to each value's own with `pointwise`; NaN if the evaluator and
+/// `Program::eval` disagree on a NaN.
+double worst_error(const char* text, const MixedPrecisionOptions& options,
+                   const std::vector<double>& x, const std::vector<double>& y,
+                   MixedPrecisionStats& stats, bool pointwise = false) {
+    ExprPool pool;
+    SymbolTable symbols;
+    symbols.intern("x");
+    symbols.intern("y");
+    const Program program = gradient_program(pool, parse(text, pool, symbols), 2);
+    const std::size_t n = x.size();
+    std::vector<std::vector<double>> out(program.num_outputs(), std::vector<double>(n));
+    std::vector<const double*> in{x.data(), y.data()};
+    std::vector<double*> out_ptr;
+    for (auto& column : out)
+        out_ptr.push_back(column.data());
+    MixedPrecisionEvaluator evaluator(program, options);
+    evaluator(in, out_ptr, n);
+    stats = evaluator.stats();
+
+    std::vector<std::vector<double>> ref(program.num_outputs(), std::vector<double>(n));
+    std::vector<double> point(2), value(program.num_outputs());
+    for (std::size_t p = 0; p < n; ++p) {
+        point = {x[p], y[p]};
+        program.eval(point, value);
+        for (std::size_t r = 0; r < value.size(); ++r)
+            ref[r][p] = value[r];
+    }
+    double worst = 0.0;
+    for (std::size_t r = 0; r < ref.size(); ++r) {
+        double scale = 0.0, err = 0.0;
+        for (std::size_t p = 0; p < n; ++p) {
+            if (std::isnan(ref[r][p]) != std::isnan(out[r][p]))
+                return NAN;
+            if (!std::isfinite(ref[r][p]))
+                continue;
+            const double e = std::abs(out[r][p] - ref[r][p]);
+            err = std::max(err, pointwise ? e / std::max(std::abs(ref[r][p]), 1e-300) : e);
+            scale = std::max(scale, std::abs(ref[r][p]));
+        }
+        worst = std::max(worst, pointwise || scale == 0.0 ? err : err / scale);
+    }
+    return worst;
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937_64 rng(5);
+    std::uniform_real_distribution<double> u(0.5, 2.0);
+    const std::size_t n = 20000;
+    std::vector<double> x(n), y(n);
+    for (std::size_t p = 0; p < n; ++p) {
+        x[p] = u(rng);
+        y[p] = u(rng);
+    }
+
+    // Every elementary function the float routines cover, and cancellation
+    // in the partials of the sum.
+    const char* formulas[] = {
+        "x*x*y + 3*x*y*y",
+        "sin(x)*exp(y) + x/y",
+        "tanh(x*y) + exp(x)",
+        "log(x)*cos(y) + sqrt(x)",
+        "sin(3*x) - cos(x*y) + tanh(x - y)",
+    };
+    MixedPrecisionStats stats;
+    for (const char* f : formulas) {
+        const double err = worst_error(f, {}, x, y, stats);
+        FTE_CHECK(err <= 1e-4);
+        FTE_CHECK(stats.reduced_points > n / 2);
+        FTE_CHECK(stats.fallback_points == 0);
+        FTE_CHECK(worst_error(f, {.precision = Precision::Half, .tolerance = 1e-2}, x, y, stats) <=
+                  1e-2);
+    }
+
+    // Near-equal arguments: exp(x) - exp(y) cancels to a few float ulps,
+    // so those lanes must come back from double.
+    std::vector<double> yc = y;
+    for (std::size_t p = 0; p < n; p += 5)
+        yc[p] = x[p] * (1.0 + 1e-6);
+    FTE_CHECK(worst_error("exp(x) - exp(y)", {}, x, yc, stats, true) <= 1e-4);
+    FTE_CHECK(stats.recomputed_points + stats.fallback_points + stats.sampled_points >= n / 5);
+
+    // Lanes outside the domain give NaN in both, and take the double path.
+    std::vector<double> xs = x;
+    for (std::size_t p = 0; p < n; p += 7)
+        xs[p] = -xs[p];
+    const double err = worst_error("log(x)*exp(y)", {}, xs, y, stats);
+    FTE_CHECK(err <= 1e-4);
+    FTE_CHECK(stats.recomputed_points + stats.fallback_points + stats.sampled_points >= n / 7);
+    return fte::test::result();
+}
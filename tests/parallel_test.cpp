@@ -0,0 +1,101 @@
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/batch.hpp"
+#include "fte/parallel.hpp"
+#include "fte/parser.hpp"
+#include "fte/thread_pool.hpp"
+
+using namespace fte;
+
+namespace {
+
+/// Columns of `num_outputs` values for `n` points, and pointers to them.
+struct Columns {
+    std::vector<std::vector<double>> data;
+    std::vector<double*> ptr;
+
+    Columns(std::size_t num_outputs, std::size_t n) : data(num_outputs, std::vector<double>(n)) {
+        for (auto& c : data)
+            ptr.push_back(c.data());
+    }
+};
+
+bool same(const Columns& a, const Columns& b) {
+    bool ok = true;
+    for (std::size_t r = 0; r < a.data.size(); ++r)
+        ok &= std::memcmp(a.data[r].data(), b.data[r].data(), a.data[r].size() * sizeof(double)) == 0;
+    return ok;
+}
+
+}  // namespace
+
+int main() {
+    for (unsigned threads : {1u, 3u}) {
+        ThreadPool pool(threads);
+        FTE_CHECK(pool.size() == threads && pool.worker_index() == threads);
+
+        // Every iteration runs exactly once, nested loops included.
+        std::vector<std::atomic<int>> hits(10007);
+        std::atomic<int> nested{0};
+        pool.parallel_for(hits.size(), 100, [&](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i)
+                ++hits[i];
+            pool.parallel_for(4, 1, [&](std::size_t, std::size_t) { ++nested; });
+        });
+        bool once = true;
+        for (const auto& h : hits)
+            once &= h == 1;
+        FTE_CHECK(once);
+        FTE_CHECK(nested == 4 * 101);
+
+        // The first exception reaches the caller, and the pool stays usable.
+        bool threw = false;
+        try {
+            pool.parallel_for(64, 1, [](std::size_t b, std::size_t) {
+                if (b == 17)
+                    throw std::runtime_error("range 17");
+            });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        FTE_CHECK(threw);
+        std::atomic<std::size_t> sum{0};
+        pool.parallel_for(100, 7, [&](std::size_t b, std::size_t e) { sum += e - b; });
+        FTE_CHECK(sum == 100);
+
+        // Bitwise the serial batch, for any chunk size.
+        ExprPool exprs;
+        SymbolTable symbols;
+        symbols.intern("x");
+        symbols.intern("y");
+        const Node* f = parse("sin(x*y)*exp(x) + x^3/y", exprs, symbols);
+        const Program program = gradient_program(exprs, f, 2);
+        const Program value = linearize(std::span<const Node* const>(&f, 1), 2);
+        const std::size_t n = 5000;
+        std::vector<double> x(n), y(n);
+        for (std::size_t p = 0; p < n; ++p) {
+            x[p] = 0.5 + 1e-3 * static_cast<double>(p);
+            y[p] = 2.0 - 3e-4 * static_cast<double>(p);
+        }
+        const std::vector<const double*> in{x.data(), y.data()};
+        Columns serial(program.num_outputs(), n), serial_value(1, n);
+        evaluate_batch(program, in, serial.ptr, n);
+        evaluate_batch(value, in, serial_value.ptr, n);
+        for (std::size_t chunk : {std::size_t{0}, std::size_t{1}, std::size_t{333}, n}) {
+            Columns out(program.num_outputs(), n);
+            evaluate_batch_parallel(pool, program, in, out.ptr, n, chunk);
+            FTE_CHECK(same(out, serial));
+
+            Columns a(program.num_outputs(), n), b(1, n);
+            const Program* programs[] = {&program, &value};
+            const std::span<double* const> outputs[] = {a.ptr, b.ptr};
+            evaluate_batch_parallel(pool, programs, in, outputs, n, chunk);
+            FTE_CHECK(same(a, serial) && same(b, serial_value));
+        }
+    }
+    return fte::test::result();
+}
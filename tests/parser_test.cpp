@@ -0,0 +1,84 @@
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/parser.hpp"
+#include "fte/print.hpp"
+
+using namespace fte;
+
+namespace {
+
+/// Offset of the `ParseError` for `text`, or -1 if it parses.
+long error_offset(const char* text) {
+    ExprPool pool;
+    SymbolTable symbols;
+    try {
+        parse(text, pool, symbols);
+    } catch (const ParseError& e) {
+        return static_cast<long>(e.offset());
+    }
+    return -1;
+}
+
+}  // namespace
+
+int main() {
+    ExprPool pool;
+    SymbolTable symbols;
+    const std::uint32_t x = symbols.intern("x");
+    const std::uint32_t y = symbols.intern("y");
+
+    // Identifiers are variables in order of first use; precedence and
+    // associativity as documented.
+    FTE_CHECK(parse("x", pool, symbols) == pool.variable(x));
+    FTE_CHECK(parse("y - x - 1", pool, symbols) ==
+              pool.sub(pool.sub(pool.variable(y), pool.variable(x)), pool.constant(1.0)));
+    FTE_CHECK(parse("2^3^x", pool, symbols) ==
+              pool.pow(pool.constant(2.0), pool.pow(pool.constant(3.0), pool.variable(x))));
+    FTE_CHECK(parse("-x**2", pool, symbols) ==
+              pool.neg(pool.pow(pool.variable(x), pool.constant(2.0))));
+    FTE_CHECK(parse("pow(x, y) / 2.5e-1", pool, symbols) ==
+              pool.div(pool.pow(pool.variable(x), pool.variable(y)), pool.constant(0.25)));
+    FTE_CHECK(parse("z", pool, symbols) == pool.variable(2) && symbols.size() == 3);
+
+    // Printed formulas parse back to the same node, non-finite constants
+    // included.
+    const double inf = std::numeric_limits<double>::infinity();
+    const Node* vx = pool.variable(x);
+    const Node* vy = pool.variable(y);
+    const Node* formulas[] = {
+        pool.add(pool.mul(pool.sin(vx), vy), pool.div(vx, pool.sub(vy, pool.constant(-2.0)))),
+        pool.pow(pool.neg(vx), pool.pow(vy, pool.constant(0.1))),
+        pool.sub(vx, pool.sub(vy, pool.exp(pool.mul(pool.constant(-1e-300), vx)))),
+        pool.mul(vx, pool.constant(inf)),
+        pool.add(pool.mul(vy, pool.constant(-inf)), pool.pow(vx, pool.constant(-inf))),
+        pool.sub(vx, pool.constant(std::numeric_limits<double>::quiet_NaN())),
+        pool.pow(vx, pool.constant(-std::numeric_limits<double>::quiet_NaN())),
+    };
+    const std::vector<std::string> names = symbols.names();
+    for (std::size_t i = 0; i < std::size(formulas); ++i) {
+        const std::string text = to_string(formulas[i], names);
+        const Node* back = parse(text, pool, symbols);
+        // NaN comes back as the default NaN.
+        FTE_CHECK(i < 6 ? back == formulas[i] : to_string(back, names) == text);
+    }
+    FTE_CHECK(to_string(formulas[3], names) == "inf*x");
+    FTE_CHECK(to_string(formulas[6], names) == "x^nan");
+    FTE_CHECK(symbols.size() == 3);
+
+    // Errors carry the offset at which they were detected.
+    FTE_CHECK(error_offset("x + sin(y)") == -1);
+    FTE_CHECK(error_offset("x +") == 3);
+    FTE_CHECK(error_offset("x + * y") == 4);
+    FTE_CHECK(error_offset("(x + y") == 6);
+    FTE_CHECK(error_offset("foo(x)") == 0);
+    FTE_CHECK(error_offset("x + frob(y)") == 4);
+    FTE_CHECK(error_offset("pow(x)") == 5);
+    FTE_CHECK(error_offset("x y") == 2);
+    FTE_CHECK(error_offset("x $ y") == 2);
+    FTE_CHECK(error_offset(std::string(100000, '(').c_str()) >= 0);
+    return fte::test::result();
+}
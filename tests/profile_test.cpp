@@ -0,0 +1,55 @@
+#include <string>
+#include <thread>
+
+#include "check.hpp"
+#include "fte/parser.hpp"
+#include "fte/profile.hpp"
+
+using namespace fte;
+using namespace fte::profile;
+
+int main() {
+    reset();
+    Snapshot s = snapshot();
+    FTE_CHECK(s[Counter::CacheHits] == 0 && s[Phase::Simplify].calls == 0);
+
+    // Counters are per thread and merged on read.
+    count(Counter::CacheHits, 3);
+    std::thread([] { count(Counter::CacheHits, 4); }).join();
+    s = snapshot();
+    FTE_CHECK(s[Counter::CacheHits] == 7 && s.threads >= 2);
+
+    // Scopes count calls and time; the longest is no longer than the total.
+    {
+        ScopedTimer timer(Phase::Simplify);
+    }
+    const std::uint64_t t0 = ticks();
+    record(Phase::Simplify, t0, t0 + 1000);
+    s = snapshot();
+    FTE_CHECK(s[Phase::Simplify].calls == 2);
+    FTE_CHECK(s[Phase::Simplify].max_ns > 0 && s[Phase::Simplify].max_ns <= s[Phase::Simplify].total_ns);
+
+    // Exports name what was recorded.
+    const std::string text = prometheus_text();
+    FTE_CHECK(text.find("fte_cache_hits_total 7\n") != std::string::npos);
+    FTE_CHECK(text.find("fte_phase_calls_total{phase=\"simplify\"} 2\n") != std::string::npos);
+    set_tracing(true, 4);
+    FTE_CHECK(tracing());
+    for (int i = 0; i < 10; ++i)
+        ScopedTimer timer(Phase::Evaluate);
+    const std::string trace = chrome_trace();
+    set_tracing(false);
+    FTE_CHECK(trace.find("\"name\": \"evaluate\"") != std::string::npos);
+    FTE_CHECK(trace.find("\"name\": \"simplify\"") == std::string::npos);
+
+    // The library's own instrumentation compiles out unless enabled.
+    reset();
+    ExprPool pool;
+    SymbolTable symbols;
+    parse("x*y + sin(x)", pool, symbols);
+    s = snapshot();
+    FTE_CHECK(s[Counter::ParsedBytes] == (kEnabled ? 12u : 0u));
+    FTE_CHECK(s[Phase::Parse].calls == (kEnabled ? 1u : 0u));
+    FTE_CHECK(s[Phase::Simplify].calls == 0 && s[Counter::CacheHits] == 0);
+    return fte::test::result();
+}
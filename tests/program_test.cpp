@@ -0,0 +1,91 @@
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/derivative.hpp"
+#include "fte/eval.hpp"
+#include "fte/parser.hpp"
+#include "fte/program.hpp"
+
+using namespace fte;
+
+namespace {
+
+bool same_bits(double a, double b) { return std::memcmp(&a, &b, sizeof a) == 0; }
+
+}  // namespace
+
+int main() {
+    const char* formulas[] = {
+        "sin(x*y)*cos(x*y) + x*y*z",
+        "exp(sin(x)*cos(y)) / (1 + x*x + y*y) + 2*z",
+        "(x*y - z)*(x*y + z) - x^3*y + z^2.5",
+    };
+    const std::vector<double> x{0.7, -1.3, 0.4};
+    for (const char* text : formulas) {
+        ExprPool pool;
+        SymbolTable symbols;
+        for (const char* name : {"x", "y", "z"})
+            symbols.intern(name);
+        const Node* f = parse(text, pool, symbols);
+        std::vector<const Node*> roots{f};
+        for (const Node* g : gradient(pool, f, 3))
+            roots.push_back(g);
+
+        // One instruction per unique operation, each constant stored once.
+        std::size_t ops = 0, constants = 0;
+        for (const Node* n : topo_order(roots)) {
+            ops += n->op != Op::Const && n->op != Op::Var;
+            constants += n->op == Op::Const;
+        }
+        const std::vector<double> ref = evaluate<double>(roots, x);
+        const Program ssa = linearize(roots, 3, {.reuse_slots = false});
+        const Program reused = linearize(roots, 3);
+        FTE_CHECK(ssa.is_ssa() && !reused.is_ssa());
+        FTE_CHECK(ssa.code().size() == ops && reused.code().size() == ops);
+        FTE_CHECK(ssa.constants().size() == constants);
+        FTE_CHECK(ssa.num_slots() == 3 + constants + ops);
+        FTE_CHECK(reused.num_slots() < ssa.num_slots());
+
+        // The same operations in the same order: identical bits, with or
+        // without scratch supplied.
+        std::vector<double> out(roots.size()), slots(reused.num_slots());
+        for (const Program* p : {&ssa, &reused}) {
+            p->eval(x, out);
+            for (std::size_t r = 0; r < ref.size(); ++r)
+                FTE_CHECK(same_bits(out[r], ref[r]));
+        }
+        for (int rep = 0; rep < 2; ++rep) {
+            reused.eval(x, out, slots);
+            for (std::size_t r = 0; r < ref.size(); ++r)
+                FTE_CHECK(same_bits(out[r], ref[r]));
+        }
+
+        // gradient_program is the same fused layout.
+        const Program gp = gradient_program(pool, f, 3);
+        FTE_CHECK(gp.num_outputs() == 4 && gp.code().size() == ops);
+        gp.eval(x, out);
+        for (std::size_t r = 0; r < ref.size(); ++r)
+            FTE_CHECK(same_bits(out[r], ref[r]));
+    }
+
+    // A leaf as an output, and a variable outside the input range.
+    {
+        ExprPool pool;
+        const Node* roots[] = {pool.variable(1), pool.constant(2.5)};
+        const Program p = linearize(roots, 2);
+        std::vector<double> out(2);
+        p.eval(std::vector<double>{7.0, 8.0}, out);
+        FTE_CHECK(out[0] == 8.0 && out[1] == 2.5 && p.code().empty());
+        bool threw = false;
+        try {
+            linearize(roots, 1);
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        FTE_CHECK(threw);
+    }
+    return fte::test::result();
+}
@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/derivative.hpp"
+#include "fte/eval.hpp"
+#include "fte/parser.hpp"
+#include "fte/simplify.hpp"
+
+using namespace fte;
+
+int main() {
+    const SimplifyOptions options{.time_budget = std::chrono::milliseconds(50)};
+    const std::vector<std::vector<double>> points{{0.7, 1.3, 0.4}, {2.1, 0.2, 1.9}, {0.05, 3.0, 0.6}};
+
+    // Gradients keep their values and never get more expensive.
+    const char* formulas[] = {
+        "x*y + x*z",
+        "sin(x)*sin(x) + cos(x)*cos(x) + x*y*z",
+        "exp(x)*exp(y) / (x*x + 1)",
+        "(x + y)^3 - x^2*y + log(x*z)",
+        "sqrt(x*y) * tanh(z/x) + x/3",
+    };
+    for (const char* text : formulas) {
+        ExprPool pool;
+        SymbolTable symbols;
+        for (const char* name : {"x", "y", "z"})
+            symbols.intern(name);
+        const Node* f = parse(text, pool, symbols);
+        std::vector<const Node*> roots = gradient(pool, f, 3);
+        roots.push_back(f);
+        SimplifyStats stats;
+        const std::vector<const Node*> simple = simplify(pool, roots, options, &stats);
+        FTE_CHECK(simple.size() == roots.size());
+        FTE_CHECK(stats.cost_after <= stats.cost_before);
+        FTE_CHECK(stats.cost_before == dag_cost(roots) && stats.cost_after == dag_cost(simple));
+        FTE_CHECK(stats.iterations > 0 && stats.enodes > 0);
+        for (const auto& p : points) {
+            const std::vector<double> a = evaluate<double>(roots, p), b = evaluate<double>(simple, p);
+            for (std::size_t r = 0; r < a.size(); ++r)
+                FTE_CHECK(std::abs(a[r] - b[r]) <= 1e-12 * std::max(std::abs(a[r]), 1.0));
+        }
+    }
+
+    // Rewrites that pay: factoring and the Pythagorean identity.
+    {
+        ExprPool pool;
+        SymbolTable symbols;
+        for (const char* name : {"x", "y", "z"})
+            symbols.intern(name);
+        const Node* f = parse("x*y + x*z", pool, symbols);
+        FTE_CHECK(dag_cost(std::span<const Node* const>(&f, 1)) >
+                  dag_cost(std::vector<const Node*>{simplify(pool, f, options)}));
+        const Node* g = parse("x/x + y - y", pool, symbols);
+        FTE_CHECK(simplify(pool, g, options) == pool.constant(1.0));
+    }
+
+    // Division by a constant becomes a product only when the reciprocal is
+    // exact, so the values stay bit for bit.
+    for (const char* text : {"x/3", "x/4", "x/0.1", "x/-0.5"}) {
+        ExprPool pool;
+        SymbolTable symbols;
+        symbols.intern("x");
+        const Node* f = parse(text, pool, symbols);
+        const Node* s = simplify(pool, f, options);
+        for (double x : {0.7, 1.0 / 3.0, 123.456, -9.9e10})
+            FTE_CHECK(evaluate(s, std::vector<double>{x}) == evaluate(f, std::vector<double>{x}));
+    }
+    return fte::test::result();
+}
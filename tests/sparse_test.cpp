@@ -0,0 +1,107 @@
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/derivative.hpp"
+#include "fte/dual.hpp"
+#include "fte/eval.hpp"
+#include "fte/parser.hpp"
+#include "fte/sparse.hpp"
+
+using namespace fte;
+
+namespace {
+
+constexpr std::uint32_t kVars = 20;
+
+bool close(double a, double b) { return std::abs(a - b) <= 1e-11 * std::max(std::abs(b), 1.0); }
+
+/// `m` against the dense `ref`: the pattern holds every nonzero of `ref`,
+/// and each stored value equals its entry.
+bool matches(const CsrMatrix& m, const std::vector<double>& ref, std::size_t rows) {
+    std::vector<double> dense(rows * kVars, 0.0);
+    bool ok = m.rows == rows && m.cols == kVars && m.row_ptr.size() == rows + 1;
+    for (std::size_t r = 0; r < rows && ok; ++r)
+        for (std::size_t p = m.row_ptr[r]; p < m.row_ptr[r + 1]; ++p)
+            dense[r * kVars + m.col_idx[p]] = m.values[p];
+    for (std::size_t e = 0; e < dense.size() && ok; ++e)
+        ok = close(dense[e], ref[e]);
+    return ok;
+}
+
+/// Do two columns of one color share a row of `pattern`?
+bool shares_row(const SparsityPattern& pattern, std::span<const std::uint32_t> colors) {
+    for (std::size_t r = 0; r < pattern.rows; ++r)
+        for (std::size_t p = pattern.row_ptr[r]; p < pattern.row_ptr[r + 1]; ++p)
+            for (std::size_t q = p + 1; q < pattern.row_ptr[r + 1]; ++q)
+                if (colors[pattern.col_idx[p]] == colors[pattern.col_idx[q]])
+                    return true;
+    return false;
+}
+
+}  // namespace
+
+int main() {
+    std::vector<double> x(kVars);
+    for (std::uint32_t i = 0; i < kVars; ++i)
+        x[i] = 0.5 + 0.07 * i;
+
+    // Banded, then with one dense term: a handful of colors, then more
+    // than one sweep carries.
+    for (bool dense_term : {false, true}) {
+        ExprPool pool;
+        SymbolTable symbols;
+        for (std::uint32_t i = 0; i < kVars; ++i) {
+            std::ostringstream name;
+            name << 'x' << i;
+            symbols.intern(name.str());
+        }
+
+        std::vector<const Node*> roots;
+        std::ostringstream f, sum;
+        for (int i = 0; i + 1 < static_cast<int>(kVars); ++i) {
+            std::ostringstream term;
+            term << 'x' << i << "^2.5*x" << i + 1 << " + sin(x" << i << ")";
+            roots.push_back(parse(term.str(), pool, symbols));
+            f << (i ? " + " : "") << "(x" << i << " - x" << i + 1 << ")^3*exp(x" << i << ")";
+        }
+        if (dense_term) {
+            for (int i = 0; i < static_cast<int>(kVars); ++i)
+                sum << (i ? " + x" : "x") << i;
+            roots.push_back(parse("log(" + sum.str() + ")", pool, symbols));
+            f << " + (" << sum.str() << ")^2";
+        }
+        const Node* fn = parse(f.str(), pool, symbols);
+
+        // Jacobian.
+        const std::size_t m = roots.size();
+        std::vector<double> jac(m * kVars);
+        for (std::size_t r = 0; r < m; ++r)
+            for (std::uint32_t i = 0; i < kVars; ++i)
+                jac[r * kVars + i] = evaluate(differentiate(pool, roots[r], i), x);
+        const SparseJacobian sj(roots, kVars);
+        FTE_CHECK(!shares_row(sj.pattern(), sj.colors()));
+        FTE_CHECK(dense_term ? sj.num_colors() == kVars : sj.num_colors() <= 3);
+        FTE_CHECK(sj.pattern().nnz() == (dense_term ? 3 * kVars - 2 : 2 * kVars - 2));
+        FTE_CHECK(matches(sj(x), jac, m));
+
+        // Hessian, whose rows are the gradient's Jacobian.
+        std::vector<double> hess(kVars * kVars);
+        for (std::uint32_t i = 0; i < kVars; ++i) {
+            const Node* fi = differentiate(pool, fn, i);
+            for (std::uint32_t j = 0; j < kVars; ++j)
+                hess[i * kVars + j] = evaluate(differentiate(pool, fi, j), x);
+        }
+        const SparseHessian sh(pool, fn, kVars);
+        const SparsityPattern& hp = sh.pattern();
+        FTE_CHECK(hp.nnz() == (dense_term ? kVars * kVars : 3 * kVars - 2));
+        for (std::size_t r = 0; r < hp.rows; ++r)
+            for (std::size_t p = hp.row_ptr[r]; p < hp.row_ptr[r + 1]; ++p)
+                FTE_CHECK(hp.col_idx[p] == r || sh.colors()[hp.col_idx[p]] != sh.colors()[r]);
+        FTE_CHECK(dense_term ? sh.num_colors() == kVars : sh.num_colors() <= 3);
+        FTE_CHECK(dense_term == (sh.num_colors() > kDualWidth));
+        FTE_CHECK(matches(sh(x), hess, kVars));
+    }
+    return fte::test::result();
+}
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/derivative.hpp"
+#include "fte/dual.hpp"
+#include "fte/eval.hpp"
+#include "fte/parser.hpp"
+#include "fte/static_expr.hpp"
+
+using namespace fte;
+using namespace fte::static_expr;
+
+namespace {
+
+constexpr Var<0> x;
+constexpr Var<1> y;
+
+// Arithmetic-only derivatives are constant expressions, and zero terms are
+// pruned from the types.
+constexpr auto g = x * x * y + c<2.0> * y;
+static_assert(derivative<0>(g)(3.0, 4.0) == 24.0);
+static_assert(derivative<1>(g)(3.0, 4.0) == 11.0);
+static_assert(std::is_same_v<decltype(derivative<1>(x * x)), Constant<0.0>>);
+static_assert(std::is_same_v<decltype(derivative<0>(x + c<5.0>)), Constant<1.0>>);
+static_assert(gradient<2>(g)(1.0, 2.0)[1] == 3.0);
+
+/// Static partials of `f` against the runtime `differentiate` of the same
+/// formula, built into one pool.
+template <class E>
+bool matches_runtime(E f, const std::vector<double>& p) {
+    ExprPool pool;
+    const Node* node = to_node(pool, f);
+    const auto grad = gradient<2>(f).at(p);
+    bool ok = f.at(p) == evaluate(node, p);
+    for (std::uint32_t i = 0; i < 2; ++i) {
+        const double ref = evaluate(differentiate(pool, node, i), p);
+        ok &= std::abs(grad[i] - ref) <= 1e-14 * std::max(std::abs(ref), 1.0);
+    }
+    return ok;
+}
+
+}  // namespace
+
+int main() {
+    // The example of the header comment.
+    {
+        constexpr auto f = x * sin(y) + c<3.0> * x * x;
+        constexpr auto dfdx = derivative<0>(f);
+        ExprPool pool;
+        SymbolTable symbols;
+        symbols.intern("x");
+        symbols.intern("y");
+        FTE_CHECK(to_node(pool, dfdx) == parse("sin(y) + (3*x + 3*x)", pool, symbols));
+        FTE_CHECK(to_node(pool, dfdx) == differentiate(pool, to_node(pool, f), 0));
+        FTE_CHECK(dfdx(1.0, 2.0) == std::sin(2.0) + 6.0);
+    }
+
+    const std::vector<double> p{0.7, 1.9};
+    FTE_CHECK(matches_runtime(g, p));
+    FTE_CHECK(matches_runtime(exp(x * y) / (c<1.0> + x * x), p));
+    FTE_CHECK(matches_runtime(pow(x, c<2.5>) * log(y) - tanh(x - y) * sqrt(y), p));
+    FTE_CHECK(matches_runtime(cos(sin(x) * y) + tan(x / c<4.0>) - pow(y, x), p));
+
+    // Other number types: float, and dual numbers carrying a direction.
+    constexpr auto h = sin(x) * y;
+    FTE_CHECK(std::abs(derivative<0>(h)(0.5f, 2.0f) - 2.0f * std::cos(0.5f)) <= 1e-6f);
+    Dual<2> dx(0.5), dy(2.0);
+    dx.d.set(0, 1.0);
+    dy.d.set(1, 1.0);
+    const Dual<2> hd = h(dx, dy);
+    FTE_CHECK_REL(hd.d[0], derivative<0>(h)(0.5, 2.0), 1e-15);
+    FTE_CHECK_REL(hd.d[1], derivative<1>(h)(0.5, 2.0), 1e-15);
+    return fte::test::result();
+}
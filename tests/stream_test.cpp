@@ -0,0 +1,46 @@
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "check.hpp"
+#include "fte/parser.hpp"
+#include "fte/stream.hpp"
+
+using namespace fte;
+
+namespace {
+
+/// Stream `text` through `program`; false if it was rejected.
+bool accepts(ThreadPool& pool, const Program& program, const std::string& text) {
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto in = dir / "fte_stream_test.csv";
+    const auto out = dir / "fte_stream_test.col";
+    std::ofstream(in, std::ios::binary) << text;
+    bool ok = true;
+    try {
+        stream_evaluate_csv(pool, program, in, out);
+    } catch (const std::runtime_error&) {
+        ok = false;
+    }
+    std::filesystem::remove(in);
+    std::filesystem::remove(out);
+    return ok;
+}
+
+}  // namespace
+
+int main() {
+    ExprPool exprs;
+    SymbolTable symbols;
+    const Node* f = parse("x + y", exprs, symbols);
+    const Program program = linearize(std::span<const Node* const>(&f, 1), 2);
+    ThreadPool pool(2);
+
+    FTE_CHECK(accepts(pool, program, "1,2\n 3 , 4 \r\n\n5,6"));
+    FTE_CHECK(!accepts(pool, program, "1,2\n1,2,3\n"));
+    FTE_CHECK(!accepts(pool, program, "1,2abc\n"));
+    FTE_CHECK(!accepts(pool, program, "1\n"));
+    FTE_CHECK(!accepts(pool, program, "1,2,\n"));
+    return fte::test::result();
+}
@@ -0,0 +1,52 @@
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/parser.hpp"
+#include "fte/taylor.hpp"
+
+using namespace fte;
+
+namespace {
+
+const Node* parse_x(const char* text, ExprPool& pool) {
+    SymbolTable symbols;
+    symbols.intern("x");
+    return parse(text, pool, symbols);
+}
+
+}  // namespace
+
+int main() {
+    // (e^x sin x)^(k) = 2^(k/2) e^x sin(x + k pi/4). High degrees must keep
+    // the small high-order coefficients accurate.
+    {
+        ExprPool pool;
+        const Node* f = parse_x("exp(x)*sin(x)", pool);
+        const double x = 0.5;
+        for (std::size_t degree : {40, 127, 128, 200}) {
+            const std::vector<double> d = higher_derivatives(f, 0, std::vector<double>{x}, degree);
+            for (std::size_t k = 0; k <= 40; ++k) {
+                const double kd = static_cast<double>(k);
+                const double exact = std::pow(2.0, kd / 2) * std::exp(x) *
+                                     std::sin(x + kd * std::numbers::pi / 4);
+                FTE_CHECK_REL(d[k], exact, 1e-9);
+            }
+        }
+    }
+    // Zero base with a natural exponent, including one beyond the degree.
+    {
+        ExprPool pool;
+        const std::vector<double> x{0.0};
+        const std::vector<double> cube = higher_derivatives(parse_x("x^3", pool), 0, x, 5);
+        for (std::size_t k = 0; k <= 5; ++k)
+            FTE_CHECK(cube[k] == (k == 3 ? 6.0 : 0.0));
+        for (const char* text : {"x^1e30", "x^6"}) {
+            const std::vector<double> d = higher_derivatives(parse_x(text, pool), 0, x, 5);
+            for (double dk : d)
+                FTE_CHECK(dk == 0.0);
+        }
+    }
+    return fte::test::result();
+}
@@ -0,0 +1,143 @@
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "check.hpp"
+#include "fte/derivative.hpp"
+#include "fte/parser.hpp"
+#include "fte/program.hpp"
+#include "fte/tiered.hpp"
+
+using namespace fte;
+
+namespace {
+
+/// Gradient of a small formula, whose roots the tiered functions share.
+struct Gradient {
+    ExprPool pool;
+    std::vector<const Node*> roots;
+
+    Gradient() {
+        SymbolTable symbols;
+        symbols.intern("x");
+        symbols.intern("y");
+        const Node* f = parse("sin(x*y) * exp(x) + x / (1 + y*y)", pool, symbols);
+        roots.push_back(f);
+        for (std::uint32_t i = 0; i < 2; ++i)
+            roots.push_back(differentiate(pool, f, i));
+    }
+};
+
+/// Does `tiered` agree with `Program::eval` at a few points, one by one and
+/// as a batch?
+bool agrees(const TieredFunction& tiered) {
+    const std::vector<double> xs{0.3, -1.2, 2.0}, ys{0.7, 0.4, -0.9};
+    std::vector<double> out(tiered.num_outputs()), ref(tiered.num_outputs());
+    std::vector<std::vector<double>> columns(out.size(), std::vector<double>(xs.size()));
+    std::vector<const double*> in{xs.data(), ys.data()};
+    std::vector<double*> out_ptr;
+    for (auto& c : columns)
+        out_ptr.push_back(c.data());
+    tiered.batch(in, out_ptr, xs.size());
+    bool ok = true;
+    for (std::size_t p = 0; p < xs.size(); ++p) {
+        const std::vector<double> x{xs[p], ys[p]};
+        tiered(x, out);
+        tiered.program().eval(x, ref);
+        for (std::size_t r = 0; r < ref.size(); ++r) {
+            const double tol = 1e-12 * std::max(std::abs(ref[r]), 1.0);
+            ok &= std::abs(out[r] - ref[r]) <= tol && std::abs(columns[r][p] - ref[r]) <= tol;
+        }
+    }
+    return ok;
+}
+
+/// Options compiling into a private cache.
+TieredOptions options(const std::filesystem::path& cache, std::uint64_t calls,
+                      std::uint64_t points, bool background = true) {
+    TieredOptions o;
+    o.call_threshold = calls;
+    o.point_threshold = points;
+    o.background = background;
+    o.jit.cache_dir = cache;
+    return o;
+}
+
+}  // namespace
+
+int main() {
+    namespace fs = std::filesystem;
+    const fs::path cache = fs::temp_directory_path() / ("fte-tiered-test-" + std::to_string(::getpid()));
+    Gradient g;
+    const std::vector<double> x{0.5, 0.25};
+    std::vector<double> out(g.roots.size());
+
+    // Compiling in the call that crosses the call threshold.
+    {
+        TieredFunction f(g.roots, 2, options(cache, 5, 0, false));
+        for (int i = 0; i < 4; ++i)
+            f(x, out);
+        FTE_CHECK(f.tier() == Tier::Interpreted && f.calls() == 4);
+        FTE_CHECK(f.compile_seconds() == 0.0 && f.error().empty());
+        f(x, out);
+        FTE_CHECK(f.tier() == Tier::Compiled);
+        FTE_CHECK(f.compile_seconds() > 0.0);
+        FTE_CHECK(agrees(f));
+        // Counting stops at promotion.
+        FTE_CHECK(f.calls() == 5);
+    }
+
+    // In the background, started by the point threshold of a batch; calls
+    // stay interpreted and correct until the kernel is published.
+    {
+        TieredFunction f(g.roots, 2, options(cache, 0, 6));
+        FTE_CHECK(agrees(f));  // 3 points as a batch, then 3 calls
+        FTE_CHECK(f.tier() != Tier::Interpreted);
+        FTE_CHECK(agrees(f));
+        f.wait();
+        FTE_CHECK(f.tier() == Tier::Compiled && f.error().empty());
+        FTE_CHECK(agrees(f));
+    }
+
+    // Many threads crossing the threshold at once start one compilation.
+    {
+        TieredFunction f(g.roots, 2, options(cache, 50, 0));
+        std::atomic<bool> ok{true};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&] {
+                for (int i = 0; i < 40; ++i)
+                    if (!agrees(f))
+                        ok = false;
+            });
+        for (auto& t : threads)
+            t.join();
+        f.wait();
+        FTE_CHECK(ok);
+        FTE_CHECK(f.tier() == Tier::Compiled);
+        FTE_CHECK(agrees(f));
+    }
+
+    // A compiler that does not exist: the function stays interpreted.
+    for (bool background : {true, false}) {
+        TieredOptions o = options(cache / "failed", 0, 0, background);
+        o.jit.compiler = "/nonexistent/c++";
+        TieredFunction f(g.roots, 2, o);
+        f.promote();
+        f.wait();
+        FTE_CHECK(f.tier() == Tier::Interpreted);
+        FTE_CHECK(!f.error().empty());
+        FTE_CHECK(agrees(f));
+        f.promote();  // once failed, it stays so
+        FTE_CHECK(f.tier() == Tier::Interpreted);
+    }
+
+    std::error_code ec;
+    fs::remove_all(cache, ec);
+    return fte::test::result();
+}
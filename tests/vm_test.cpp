@@ -0,0 +1,90 @@
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/parser.hpp"
+#include "fte/program.hpp"
+#include "fte/vm.hpp"
+
+using namespace fte;
+
+namespace {
+
+bool same_bits(double a, double b) { return std::memcmp(&a, &b, sizeof a) == 0; }
+
+/// Evaluate `program` at `x` with `Program::eval` and as bytecode with and
+/// without superinstructions; returns the fused instruction count.
+std::size_t check_program(const Program& program, const std::vector<double>& x) {
+    std::vector<double> ref(program.num_outputs()), plain(ref.size()), fused(ref.size());
+    program.eval(x, ref);
+    const Bytecode unfused(program, {.superinstructions = false});
+    const Bytecode bytecode(program);
+    unfused.eval(x, plain);
+    bytecode.eval(x, fused);
+    FTE_CHECK(unfused.num_fused() == 0);
+    FTE_CHECK(bytecode.num_instructions() + bytecode.num_fused() == program.code().size());
+    for (std::size_t r = 0; r < ref.size(); ++r) {
+        FTE_CHECK(same_bits(plain[r], ref[r]));
+        // A fused multiply-add rounds once.
+        FTE_CHECK(std::abs(fused[r] - ref[r]) <= 1e-13 * std::max(std::abs(ref[r]), 1.0));
+    }
+    return bytecode.num_fused();
+}
+
+}  // namespace
+
+int main() {
+    const char* formulas[] = {
+        "x*y + z",
+        "sin(x*y)*cos(x*y) + x*y*z - x*z",
+        "exp(sin(x)*cos(y)) / (1 + x*x + y*y)",
+        "sin(x+y)*sin(x-y) + cos(x+y)*cos(x-y)",
+        "tanh(x*y - z*x) + log(x*x + y*y + 1) * sqrt(z*z + 1)",
+        "(x*y - z)*(x*y + z) - x^3*y + z^2.5",
+        "z - x*y",
+    };
+    const std::vector<double> x{0.7, -1.3, 0.4};
+    std::size_t fused = 0;
+    for (const char* text : formulas) {
+        ExprPool pool;
+        SymbolTable symbols;
+        for (const char* name : {"x", "y", "z"})
+            symbols.intern(name);
+        const Node* f = parse(text, pool, symbols);
+        // Gradient programs reuse slots heavily, and results overwrite
+        // their own operands; single assignment is the other layout.
+        for (bool reuse : {true, false})
+            fused += check_program(gradient_program(pool, f, 3, {.reuse_slots = reuse}), x);
+    }
+    FTE_CHECK(fused > 0);
+
+    // A sine and a cosine of one value pair up within the window only;
+    // beyond it each is computed on its own, with the same results. The
+    // product stays an output, so the cosine does not overwrite it.
+    for (int gap : {4, 20, 200}) {
+        ExprPool pool;
+        const Node* a = pool.mul(pool.variable(0), pool.variable(1));
+        const Node* t = pool.variable(2);
+        for (int i = 0; i < gap; ++i)
+            t = pool.add(pool.mul(t, pool.constant(0.5 + 0.001 * i)), pool.variable(0));
+        const Node* roots[] = {pool.sin(a), t, pool.cos(a), a};
+        const std::size_t n = check_program(linearize(roots, 3), x);
+        // Every product in the chain feeds the next addition.
+        FTE_CHECK(n == static_cast<std::size_t>(gap) + (2 * gap < 60 ? 1 : 0));
+    }
+
+    // More registers than 16-bit words can name.
+    {
+        ExprPool pool;
+        const Node* s = pool.variable(0);
+        for (int i = 0; i < 40000; ++i)
+            s = pool.add(s, pool.mul(pool.variable(1), pool.constant(1.0 + i)));
+        const Node* root = pool.sin(s);
+        const Program program =
+            linearize(std::span<const Node* const>(&root, 1), 2, {.reuse_slots = false});
+        FTE_CHECK(program.num_slots() > 65536);
+        check_program(program, {0.25, 0.5});
+    }
+    return fte::test::result();
+}
@@ -0,0 +1,177 @@
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fte/vmath.hpp"
+
+using namespace fte;
+
+namespace {
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+/// Error of `got` in units in the last place of the exact result `ref`.
+double ulps(double got, long double ref) {
+    if (got == static_cast<double>(ref))
+        return 0.0;
+    int e;
+    std::frexp(static_cast<double>(ref), &e);
+    const double ulp = std::max(std::ldexp(1.0, e - 53), std::numeric_limits<double>::denorm_min());
+    return static_cast<double>(std::fabs(got - ref) / ulp);
+}
+
+/// The same for a float result, against a double reference.
+double ulps_f(float got, double ref) {
+    if (got == static_cast<float>(ref))
+        return 0.0;
+    int e;
+    std::frexp(static_cast<float>(ref), &e);
+    const double ulp = std::max(std::ldexp(1.0, e - 24), 0x1p-149);
+    return std::fabs(got - ref) / ulp;
+}
+
+using Routine = void (*)(std::size_t, const double*, double*) noexcept;
+using RoutineF = void (*)(std::size_t, const float*, float*) noexcept;
+
+/// Largest error of `f` against `ref` over `x`.
+template <class Ref>
+double worst(Routine f, const std::vector<double>& x, Ref ref) {
+    std::vector<double> y(x.size());
+    f(x.size(), x.data(), y.data());
+    double w = 0.0;
+    for (std::size_t j = 0; j < x.size(); ++j)
+        w = std::max(w, ulps(y[j], ref(static_cast<long double>(x[j]))));
+    return w;
+}
+
+template <class Ref>
+double worst_f(RoutineF f, const std::vector<float>& x, Ref ref) {
+    std::vector<float> y(x.size());
+    f(x.size(), x.data(), y.data());
+    double w = 0.0;
+    for (std::size_t j = 0; j < x.size(); ++j)
+        w = std::max(w, ulps_f(y[j], ref(static_cast<double>(x[j]))));
+    return w;
+}
+
+}  // namespace
+
+int main() {
+    // The bounds documented in vmath.hpp, plus slack for the long double
+    // reference.
+    constexpr double kSlack = 0.002;
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<double> x(200000);
+
+    for (double& v : x)
+        v = 745.0 * u(rng);
+    FTE_CHECK(worst(vmath::exp, x, [](long double a) { return expl(a); }) <= 0.8 + kSlack);
+    for (double& v : x)
+        v = std::ldexp(std::abs(u(rng)), static_cast<int>(rng() % 2000) - 1000);
+    FTE_CHECK(worst(vmath::log, x, [](long double a) { return logl(a); }) <= 0.8 + kSlack);
+
+    // Uniform arguments, then the doubles nearest to multiples of pi/2,
+    // where the reduction cancels hardest.
+    for (double& v : x)
+        v = 0x1p20 * u(rng);
+    x.push_back(826882.89438810153);
+    x.push_back(413441.44719405076);
+    for (long k = 1; k < 667000; k += 7)
+        x.push_back(static_cast<double>(static_cast<long double>(k) * std::numbers::pi_v<long double> / 2));
+    FTE_CHECK(worst(vmath::sin, x, [](long double a) { return sinl(a); }) <= 0.8 + kSlack);
+    FTE_CHECK(worst(vmath::cos, x, [](long double a) { return cosl(a); }) <= 0.8 + kSlack);
+
+    // Special values as in C99 Annex F.
+    const std::vector<double> special{0.0, -0.0, kInf, -kInf, std::nan(""), -1.0, 0x1p-1074};
+    const std::size_t n = special.size();
+    std::vector<double> s(n), c(n), e(n), l(n);
+    vmath::sincos(n, special.data(), s.data(), c.data());
+    vmath::exp(n, special.data(), e.data());
+    vmath::log(n, special.data(), l.data());
+    FTE_CHECK(s[0] == 0.0 && !std::signbit(s[0]) && c[0] == 1.0);
+    FTE_CHECK(s[1] == 0.0 && std::signbit(s[1]) && c[1] == 1.0);
+    FTE_CHECK(std::isnan(s[2]) && std::isnan(c[3]) && std::isnan(s[4]));
+    FTE_CHECK(s[6] == 0x1p-1074);
+    std::vector<double> sn(n);
+    vmath::sin(n, special.data(), sn.data());
+    FTE_CHECK(std::signbit(sn[1]) && sn[1] == 0.0);
+    FTE_CHECK(e[0] == 1.0 && e[1] == 1.0 && e[2] == kInf && e[3] == 0.0 && std::isnan(e[4]));
+    FTE_CHECK(l[0] == -kInf && l[1] == -kInf && l[2] == kInf && std::isnan(l[3]) &&
+              std::isnan(l[4]) && std::isnan(l[5]));
+    FTE_CHECK(l[6] == std::log(0x1p-1074));
+
+    // pow_pair: hi is pow(x, p) up to one ulp, and exactly pow's value at
+    // zeros, infinities and non-normal results.
+    const std::vector<double> bases{-kInf, -0.0, 0.0, kInf, 0x1p-600, 0.3, 2.5, -2.0, 1e300};
+    for (double p : {1.0, 2.0, 2.5, 3.0, 1.9}) {
+        std::vector<double> hi(bases.size()), lo(bases.size());
+        vmath::pow_pair(bases.size(), bases.data(), p, hi.data(), lo.data());
+        for (std::size_t j = 0; j < bases.size(); ++j) {
+            const double ref = std::pow(bases[j], p);
+            FTE_CHECK(lo[j] == std::pow(bases[j], p - 1.0) || std::isnan(lo[j]));
+            if (std::isnan(ref)) {
+                FTE_CHECK(std::isnan(hi[j]));
+            } else if (!std::isnormal(ref)) {
+                FTE_CHECK(hi[j] == ref && std::signbit(hi[j]) == std::signbit(ref));
+            } else {
+                FTE_CHECK(ulps(hi[j], std::pow(static_cast<long double>(bases[j]), p)) <= 1.0 + kSlack);
+            }
+        }
+    }
+
+    // Single precision, against double libm.
+    std::vector<float> xf(200000);
+    for (float& v : xf)
+        v = static_cast<float>(104.0 * u(rng));
+    FTE_CHECK(worst_f(vmath::exp, xf, [](double a) { return std::exp(a); }) <= 1.01 + kSlack);
+    for (float& v : xf)
+        v = static_cast<float>(std::ldexp(std::abs(u(rng)), static_cast<int>(rng() % 270) - 140));
+    FTE_CHECK(worst_f(vmath::log, xf, [](double a) { return std::log(a); }) <= 0.79 + kSlack);
+    for (float& v : xf)
+        v = static_cast<float>(0x1p20 * u(rng));
+    for (long k = 1; k < 667000; k += 7)
+        xf.push_back(static_cast<float>(static_cast<double>(k) * std::numbers::pi / 2));
+    FTE_CHECK(worst_f(vmath::sin, xf, [](double a) { return std::sin(a); }) <= 1.56 + kSlack);
+    FTE_CHECK(worst_f(vmath::cos, xf, [](double a) { return std::cos(a); }) <= 1.56 + kSlack);
+    xf.resize(200000);
+    for (float& v : xf)
+        v = static_cast<float>(u(rng) * (rng() % 2 ? 12.0 : 0.7));
+    FTE_CHECK(worst_f(vmath::tanh, xf, [](double a) { return std::tanh(a); }) <= 1.32 + kSlack);
+
+    const float kInfF = std::numeric_limits<float>::infinity();
+    const std::vector<float> special_f{0.0f, -0.0f, kInfF, -kInfF, std::nanf(""), -1.0f, 0x1p-149f};
+    std::vector<float> sf(n), cf(n), ef(n), lf(n), tf(n);
+    vmath::sincos(n, special_f.data(), sf.data(), cf.data());
+    vmath::exp(n, special_f.data(), ef.data());
+    vmath::log(n, special_f.data(), lf.data());
+    vmath::tanh(n, special_f.data(), tf.data());
+    FTE_CHECK(sf[1] == 0.0f && std::signbit(sf[1]) && cf[1] == 1.0f);
+    FTE_CHECK(std::isnan(sf[2]) && std::isnan(cf[3]) && std::isnan(sf[4]) && sf[6] == 0x1p-149f);
+    FTE_CHECK(ef[0] == 1.0f && ef[2] == kInfF && ef[3] == 0.0f && std::isnan(ef[4]));
+    FTE_CHECK(lf[1] == -kInfF && lf[2] == kInfF && std::isnan(lf[4]) && std::isnan(lf[5]));
+    FTE_CHECK(std::abs(lf[6] - std::log(0x1p-149f)) <= 1e-5f);
+    FTE_CHECK(std::signbit(tf[1]) && tf[2] == 1.0f && tf[3] == -1.0f && std::isnan(tf[4]));
+
+    // Arguments the float trigonometric routines hand to libm, each routine
+    // on its own.
+    const std::vector<float> huge_f{kInfF, -kInfF, std::nanf(""), 1e30f, -1e30f, 0x1p20f, 3.5e9f};
+    const std::size_t m = huge_f.size();
+    std::vector<float> hs(m), hc(m), ss(m), sc(m);
+    vmath::sin(m, huge_f.data(), hs.data());
+    vmath::cos(m, huge_f.data(), hc.data());
+    vmath::sincos(m, huge_f.data(), ss.data(), sc.data());
+    for (std::size_t j = 0; j < m; ++j) {
+        const float a = huge_f[j];
+        if (std::isfinite(a)) {
+            FTE_CHECK(hs[j] == std::sin(a) && ss[j] == std::sin(a));
+            FTE_CHECK(hc[j] == std::cos(a) && sc[j] == std::cos(a));
+        } else {
+            FTE_CHECK(std::isnan(hs[j]) && std::isnan(hc[j]) && std::isnan(ss[j]) && std::isnan(sc[j]));
+        }
+    }
+    return fte::test::result();
+}